@@ -0,0 +1,272 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "truety.h"
+#include "thread.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+/*
+ * Measures how lookups in a TTY_Concurrent_Atlas_Cache scale with the number
+ * of threads. Readers look up a small set of hot glyphs while a writer keeps
+ * adding the font's other glyphs, so the shards are being modified (and
+ * evicted) during the whole run.
+ *
+ * usage: atlas_cache_bench <path> [max-readers] [lookups-per-reader]
+ */
+
+#define BENCH_PPEM              32
+#define BENCH_PAGE_SIZE         256
+#define BENCH_NUM_SHARDS        8
+#define BENCH_PAGES_PER_SHARD   1
+#define BENCH_NUM_HOT           64
+#define BENCH_WRITES_PER_CHECK  16
+
+typedef struct {
+    TTY_Font*                    font;          /* Shared file data, each thread has its own font */
+    TTY_Concurrent_Atlas_Cache*  cache;
+    const TTY_U32*               code_points;   /* The hot ones come first */
+    const TTY_U32*               glyph_indices; /* Indexed the same as code_points */
+    int                          num_code_points;
+    int                          num_lookups;   /* Per reader */
+    volatile int                 stop;          /* Set once the readers finish, only accessed atomically */
+    volatile int                 num_errors;
+} Bench;
+
+typedef struct {
+    Bench*        bench;
+    Thread        thread;
+    TTY_Font      font;
+    TTY_Instance  instance;
+    unsigned int  seed;
+    int           num_writes; /* Only counted by the writer */
+} Bench_Thread;
+
+static double get_time(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+static int bench_thread_init(Bench* bench, Bench_Thread* thread, unsigned int seed) {
+    // Rendering modifies the font and instance, so threads can't share them
+    thread->bench      = bench;
+    thread->seed       = seed;
+    thread->num_writes = 0;
+    if (tty_font_init_from_memory(&thread->font, bench->font->fileData, bench->font->fileSize)) {
+        return 0;
+    }
+    if (tty_instance_init(&thread->font, &thread->instance, BENCH_PPEM, TTY_INSTANCE_NO_HINTING)) {
+        tty_font_free(&thread->font);
+        return 0;
+    }
+    return 1;
+}
+
+static void bench_thread_free(Bench_Thread* thread) {
+    tty_instance_free(&thread->instance);
+    tty_font_free(&thread->font);
+}
+
+static int bench_get_entry(Bench_Thread* thread, int i) {
+    // Returns 0 if the entry doesn't belong to the code point
+    Bench*                bench = thread->bench;
+    TTY_Atlas_Cache_Entry entry;
+    TTY_Error             error = tty_concurrent_atlas_cache_get_entry(
+        &thread->font, &thread->instance, bench->cache, &entry, bench->code_points[i]);
+    return error == TTY_ERROR_NONE && entry.glyph.idx == bench->glyph_indices[i];
+}
+
+static void bench_reader_main(void* arg) {
+    Bench_Thread* thread     = (Bench_Thread*)arg;
+    Bench*        bench      = thread->bench;
+    int           num_errors = 0;
+
+    for (int i = 0; i < bench->num_lookups; i++) {
+        thread->seed = thread->seed * 1103515245 + 12345;
+        if (!bench_get_entry(thread, (thread->seed >> 16) % BENCH_NUM_HOT)) {
+            num_errors++;
+        }
+    }
+    atomic_add_int(&bench->num_errors, num_errors);
+}
+
+static void bench_writer_main(void* arg) {
+    // Cycles through the cold glyphs, which are rarely still cached when the
+    // writer comes back to them. The stop flag is only checked every so often
+    // since it is read with a locked instruction.
+    Bench_Thread* thread     = (Bench_Thread*)arg;
+    Bench*        bench      = thread->bench;
+    int           num_cold   = bench->num_code_points - BENCH_NUM_HOT;
+    int           num_errors = 0;
+
+    for (int i = 0; i % BENCH_WRITES_PER_CHECK != 0 || atomic_add_int(&bench->stop, 0) == 0; i++) {
+        if (!bench_get_entry(thread, BENCH_NUM_HOT + i % num_cold)) {
+            num_errors++;
+        }
+        thread->num_writes++;
+    }
+    atomic_add_int(&bench->num_errors, num_errors);
+}
+
+static int bench_run(Bench* bench, int num_readers, double* lookups_per_sec, int* num_writes) {
+    // The writer is started first so the shards are already being modified
+    // when the readers start
+    Bench_Thread* threads = calloc(num_readers + 1, sizeof(Bench_Thread));
+    if (threads == NULL) {
+        return 0;
+    }
+
+    int num_init = 0;
+    for (; num_init < num_readers + 1; num_init++) {
+        if (!bench_thread_init(bench, threads + num_init, 1 + num_init)) {
+            break;
+        }
+    }
+
+    int ok             = num_init == num_readers + 1;
+    int writer_started = ok && thread_create(&threads[0].thread, bench_writer_main, threads);
+    int num_started    = 0;
+    ok = ok && writer_started;
+
+    double start = get_time();
+    for (; ok && num_started < num_readers; num_started++) {
+        ok = thread_create(&threads[num_started + 1].thread, bench_reader_main, threads + num_started + 1);
+    }
+    for (int i = 0; i < num_started; i++) {
+        thread_join(&threads[i + 1].thread);
+    }
+    double elapsed = get_time() - start;
+
+    if (writer_started) {
+        atomic_add_int(&bench->stop, 1);
+        thread_join(&threads[0].thread);
+    }
+
+    *lookups_per_sec = (double)num_readers * bench->num_lookups / (elapsed > 0.0 ? elapsed : 1e-9);
+    *num_writes      = num_init > 0 ? threads[0].num_writes : 0;
+
+    for (int i = 0; i < num_init; i++) {
+        bench_thread_free(threads + i);
+    }
+    free(threads);
+    return ok;
+}
+
+static int get_code_points(TTY_Font* font, TTY_U32** code_points, TTY_U32** glyph_indices) {
+    // Only code points that the font maps are used. The hot glyphs are the
+    // first ones, which are usually ASCII.
+    int count = 0;
+    *code_points   = malloc(0x10000 * sizeof(TTY_U32));
+    *glyph_indices = malloc(0x10000 * sizeof(TTY_U32));
+    if (*code_points == NULL || *glyph_indices == NULL) {
+        free(*code_points);
+        free(*glyph_indices);
+        return -1;
+    }
+
+    for (TTY_U32 cp = 0x20; cp < 0x10000; cp++) {
+        TTY_U32 idx;
+        if (tty_get_glyph_index(font, cp, &idx) == TTY_ERROR_NONE && idx != 0) {
+            (*code_points)[count]   = cp;
+            (*glyph_indices)[count] = idx;
+            count++;
+        }
+    }
+    return count;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: atlas_cache_bench <path> [max-readers] [lookups-per-reader]\n");
+        return 1;
+    }
+
+    int max_readers = argc > 2 ? atoi(argv[2]) : get_num_cpus();
+    int num_lookups = argc > 3 ? atoi(argv[3]) : 2000000;
+    if (max_readers < 1 || num_lookups < 1) {
+        fprintf(stderr, "error: max-readers and lookups-per-reader must be at least 1\n");
+        return 1;
+    }
+
+    TTY_Font font;
+    if (tty_font_init(&font, argv[1])) {
+        fprintf(stderr, "error: '%s': Failed to load\n", argv[1]);
+        return 1;
+    }
+
+    TTY_U32* code_points;
+    TTY_U32* glyph_indices;
+    int      num_code_points = get_code_points(&font, &code_points, &glyph_indices);
+    if (num_code_points < 0) {
+        fprintf(stderr, "error: out of memory\n");
+        return 1;
+    }
+    if (num_code_points <= BENCH_NUM_HOT) {
+        fprintf(stderr, "error: '%s': The font needs more than %d glyphs\n", argv[1], BENCH_NUM_HOT);
+        return 1;
+    }
+
+    TTY_Instance instance;
+    if (tty_instance_init(&font, &instance, BENCH_PPEM, TTY_INSTANCE_NO_HINTING)) {
+        fprintf(stderr, "error: '%s': Failed to create an instance\n", argv[1]);
+        return 1;
+    }
+
+    printf("%d glyphs, %d hot, %d shards of %dx%d\n",
+           num_code_points, BENCH_NUM_HOT, BENCH_NUM_SHARDS, BENCH_PAGE_SIZE, BENCH_PAGE_SIZE);
+
+    int exit_code = 0;
+    for (int num_readers = 1; num_readers <= max_readers; num_readers *= 2) {
+        // Each run starts with an empty cache
+        TTY_Concurrent_Atlas_Cache cache;
+        if (tty_concurrent_atlas_cache_init(&instance, &cache, BENCH_PAGE_SIZE, BENCH_PAGE_SIZE, BENCH_NUM_SHARDS, BENCH_PAGES_PER_SHARD)) {
+            fprintf(stderr, "error: out of memory\n");
+            exit_code = 1;
+            break;
+        }
+
+        Bench bench = {
+            .font            = &font,
+            .cache           = &cache,
+            .code_points     = code_points,
+            .glyph_indices   = glyph_indices,
+            .num_code_points = num_code_points,
+            .num_lookups     = num_lookups,
+        };
+
+        double lookups_per_sec;
+        int    num_writes;
+        int    ok = bench_run(&bench, num_readers, &lookups_per_sec, &num_writes);
+        tty_concurrent_atlas_cache_free(&cache);
+
+        if (!ok) {
+            fprintf(stderr, "error: Failed to start %d threads\n", num_readers + 1);
+            exit_code = 1;
+            break;
+        }
+
+        printf("readers=%-3d lookups/sec=%-12.0f writer lookups=%-8d errors=%d\n",
+               num_readers, lookups_per_sec, num_writes, bench.num_errors);
+        if (bench.num_errors > 0) {
+            exit_code = 1;
+        }
+    }
+
+    tty_instance_free(&instance);
+    tty_font_free(&font);
+    free(code_points);
+    free(glyph_indices);
+    return exit_code;
+}
@@ -0,0 +1,204 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "truety.h"
+#include "df_cache.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+/*
+ * Drives a DF_Cache through a miss, hits, and enough other glyphs to fill its
+ * page, and prints how long each takes. Every entry is checked against the
+ * distance field it had when it was generated, so evicting a shelf can't
+ * silently clobber a glyph that is still cached.
+ *
+ * usage: df_cache_bench <path> [glyph-size] [page-size]
+ */
+
+#define BENCH_SCALE       5
+#define BENCH_NUM_HITS    1000000
+#define BENCH_NUM_HOT     16
+#define BENCH_NUM_PASSES  3
+
+typedef struct {
+    uint32_t code_point;
+    uint32_t checksum; /* Of the glyph's distance field, 0 until it's generated */
+} Bench_Glyph;
+
+static double get_time(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+static uint32_t get_checksum(DF_Cache* cache, const DF_Cache_Entry* entry) {
+    // FNV-1a over the entry's area of its page
+    const TTY_Image* page = &cache->atlas.pages[entry->page].image;
+    uint32_t         hash = 2166136261u;
+    for (int y = 0; y < entry->h; y++) {
+        const uint8_t* row = page->pixels + entry->x + (entry->y + y) * page->size.x;
+        for (int x = 0; x < entry->w; x++) {
+            hash = (hash ^ row[x]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+static int check_entry(DF_Cache* cache, const DF_Cache_Entry* entry, Bench_Glyph* glyph, int was_cached) {
+    // Returns 0 if the entry is outside its page, or if a cached entry's
+    // pixels changed since it was generated
+    if (entry->page < 0 || entry->page >= (int)cache->atlas.numPages) {
+        return 0;
+    }
+
+    const TTY_Image* page = &cache->atlas.pages[entry->page].image;
+    if (entry->x + entry->w > (int)page->size.x || entry->y + entry->h > (int)page->size.y) {
+        return 0;
+    }
+
+    uint32_t checksum = get_checksum(cache, entry);
+    if (was_cached && glyph->checksum != checksum) {
+        return 0;
+    }
+    glyph->checksum = checksum;
+    return 1;
+}
+
+static int get_glyphs(TTY_Font* font, Bench_Glyph** glyphs) {
+    // The glyphs with pixels that the font maps, and the space as the last one
+    int count = 0;
+    *glyphs = calloc(0x10000, sizeof(Bench_Glyph));
+    if (*glyphs == NULL) {
+        return -1;
+    }
+
+    for (uint32_t cp = 0x21; cp < 0x10000; cp++) {
+        TTY_U32 idx;
+        if (tty_get_glyph_index(font, cp, &idx) == TTY_ERROR_NONE && idx != 0) {
+            (*glyphs)[count++].code_point = cp;
+        }
+    }
+    (*glyphs)[count++].code_point = ' ';
+    return count;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: df_cache_bench <path> [glyph-size] [page-size]\n");
+        return 1;
+    }
+
+    int ppem      = argc > 2 ? atoi(argv[2]) : 32;
+    int page_size = argc > 3 ? atoi(argv[3]) : 256;
+    if (ppem < 1 || page_size < 1) {
+        fprintf(stderr, "error: glyph-size and page-size must be at least 1\n");
+        return 1;
+    }
+
+    TTY_Font font;
+    if (tty_font_init(&font, argv[1])) {
+        fprintf(stderr, "error: '%s': Failed to load\n", argv[1]);
+        return 1;
+    }
+
+    Bench_Glyph* glyphs;
+    int          num_glyphs = get_glyphs(&font, &glyphs);
+    if (num_glyphs < 0) {
+        fprintf(stderr, "error: out of memory\n");
+        return 1;
+    }
+    if (num_glyphs <= BENCH_NUM_HOT) {
+        fprintf(stderr, "error: '%s': The font needs more than %d glyphs\n", argv[1], BENCH_NUM_HOT);
+        return 1;
+    }
+
+    // A single page, so it fills up and shelves are evicted
+    DF_Cache cache;
+    DF_Error error;
+    int      spread = (ppem + 7) / 14 > 0 ? (ppem + 7) / 14 : 1; /* dffont's default, roundf(ppem / 14) */
+    if ((error = df_cache_init(&cache, &font, ppem, BENCH_SCALE, spread, page_size, page_size, 1))) {
+        fprintf(stderr, "error: failed to create the cache (%d)\n", (int)error);
+        return 1;
+    }
+
+    printf("%d glyphs, %dx%d page, ppem %d, spread %d\n", num_glyphs, page_size, page_size, ppem, spread);
+
+    int            num_errors = 0;
+    DF_Cache_Entry entry;
+
+    // A miss generates the distance field, a hit only looks it up
+    {
+        double start = get_time();
+        error = df_cache_get(&cache, &entry, glyphs[0].code_point);
+        double miss_time = get_time() - start;
+        if (error || entry.w == 0 || !check_entry(&cache, &entry, glyphs, 0)) {
+            num_errors++;
+        }
+
+        start = get_time();
+        for (int i = 0; i < BENCH_NUM_HITS; i++) {
+            DF_Cache_Entry hit;
+            if (df_cache_get(&cache, &hit, glyphs[0].code_point) || memcmp(&hit, &entry, sizeof(DF_Cache_Entry)) != 0) {
+                num_errors++;
+                break;
+            }
+        }
+        double hit_time = (get_time() - start) / BENCH_NUM_HITS;
+
+        printf("miss: %.1f us, hit: %.3f us\n", miss_time * 1e6, hit_time * 1e6);
+    }
+
+    // Glyphs without pixels are cached without taking up space
+    if (df_cache_get(&cache, &entry, ' ') || entry.w != 0 || entry.h != 0 ||
+        !check_entry(&cache, &entry, glyphs + num_glyphs - 1, 0))
+    {
+        num_errors++;
+    }
+
+    // Requesting every glyph a few times fills the page and evicts shelves.
+    // The hot glyphs are requested between the others, so CLOCK keeps them.
+    int    num_misses    = 0;
+    int    num_evictions = 0;
+    double start         = get_time();
+    for (int pass = 0; pass < BENCH_NUM_PASSES; pass++) {
+        for (int i = 0; i < num_glyphs; i++) {
+            Bench_Glyph* glyph = glyphs + (i % 2 == 0 ? i % BENCH_NUM_HOT : i);
+            int cached = tty_atlas_cache_contains(&cache.atlas, glyph->code_point);
+            if (!cached) {
+                num_misses++;
+                num_evictions += glyph->checksum != 0;
+            }
+
+            if (df_cache_get(&cache, &entry, glyph->code_point) || !check_entry(&cache, &entry, glyph, cached)) {
+                num_errors++;
+            }
+        }
+    }
+    double elapsed = get_time() - start;
+
+    int num_hot_cached = 0;
+    for (int i = 0; i < BENCH_NUM_HOT; i++) {
+        num_hot_cached += tty_atlas_cache_contains(&cache.atlas, glyphs[i].code_point);
+    }
+
+    printf("full page: %d lookups, %d misses, %d evicted glyphs regenerated, %.1f us per lookup\n",
+           BENCH_NUM_PASSES * num_glyphs, num_misses, num_evictions, elapsed * 1e6 / (BENCH_NUM_PASSES * num_glyphs));
+    printf("hot glyphs still cached: %d of %d, errors=%d\n", num_hot_cached, BENCH_NUM_HOT, num_errors);
+
+    df_cache_free(&cache);
+    tty_font_free(&font);
+    free(glyphs);
+    return num_errors > 0 ? 1 : 0;
+}
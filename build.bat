@@ -3,4 +3,8 @@ if not exist .\build (
     mkdir .\build
 )
 gcc -Wall -o./build/dffont -I./src/truety -I./src/stb ./src/*.c ./src/truety/truety.c
-REM cl /Fe.\build\dffont /Zi .\src\*.c .\src\truety\truety.c /I.\src\truety /I.\src\stb
\ No newline at end of file
+gcc -Wall -O2 -o./build/atlas_cache_bench -I./src -I./src/truety ./bench/atlas_cache_bench.c ./src/thread.c ./src/truety/truety.c
+gcc -Wall -O2 -o./build/df_cache_bench -I./src -I./src/truety -I./src/stb ./bench/df_cache_bench.c ./src/df_cache.c ./src/df_glyph.c ./src/df.c ./src/tile_cache.c ./src/hash.c ./src/thread.c ./src/truety/truety.c
+REM cl /Fe.\build\dffont /Zi .\src\*.c .\src\truety\truety.c /I.\src\truety /I.\src\stb
+REM cl /Fe.\build\atlas_cache_bench /O2 .\bench\atlas_cache_bench.c .\src\thread.c .\src\truety\truety.c /I.\src /I.\src\truety
+REM cl /Fe.\build\df_cache_bench /O2 .\bench\df_cache_bench.c .\src\df_cache.c .\src\df_glyph.c .\src\df.c .\src\tile_cache.c .\src\hash.c .\src\thread.c .\src\truety\truety.c /I.\src /I.\src\truety /I.\src\stb
\ No newline at end of file
@@ -6,9 +6,10 @@ uniform sampler2D tex;
 
 in vec2 fUV;
 in vec4 fRgba;
+flat in int fChannel;
 
 void main() {
-    float d = 1.0 - texture(tex, fUV).r;
+    float d = 1.0 - texture(tex, fUV)[fChannel];
     float w = fwidth(d);
     fragColor = fRgba;
     fragColor.a *= 1.0 - smoothstep(0.4 - w, 0.4 + w, d);;
@@ -3,14 +3,17 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aUV;
 layout (location = 2) in vec4 aRgba;
+layout (location = 3) in float aChannel;
 
 out vec2 fUV;
 out vec4 fRgba;
+flat out int fChannel;
 
 uniform mat4 proj;
 
 void main() {
     fUV = aUV;
     fRgba = aRgba;
+    fChannel = int(aChannel);
     gl_Position = proj * vec4(aPos, 1.0);
 }
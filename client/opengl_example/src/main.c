@@ -10,7 +10,7 @@
 /* ------- */
 /* globals */
 /* ------- */
-#define VBO_STRIDE      9
+#define VBO_STRIDE      10
 #define VBO_STRIDE_SIZE (VBO_STRIDE * sizeof(float))
 
 /* Can render up to MAX_GLYPHS glyphs at a time */
@@ -190,8 +190,11 @@ GLFWwindow* create_glfw_window(const char* title, int w, int h) {
 /* --------- */
 static void draw_text(const char* text, int x, int y, float scale) {
     for (int i = 0; text[i] != '\0'; i++) {
-        DFFont_Glyph* glyph = g_client.glyphs + (text[i] - ' ');
-        if (glyph->codepoint == ' ') {
+        DFFont_Glyph* glyph = dffont_client_get_glyph(&g_client, (unsigned char)text[i]);
+        if (glyph == NULL) {
+            continue;
+        }
+        if (glyph->w == 0 || glyph->h == 0 || glyph->codepoint == ' ') {
             x += glyph->xadv * scale;
             continue;
         }
@@ -214,16 +217,33 @@ static void draw_text(const char* text, int x, int y, float scale) {
             float x1 = x0 + glyph->w * scale;
             float y1 = y0 + glyph->h * scale;
             
-            float u0 = (float)glyph->x / g_texw;
-            float v0 = (float)glyph->y / g_texh;
-            float u1 = (float)(glyph->x + glyph->w) / g_texw;
-            float v1 = (float)(glyph->y + glyph->h) / g_texh;
+            int   idx = (int)(glyph - g_client.glyphs);
+            float u0  = g_client.glyphUVs.u0[idx];
+            float v0  = g_client.glyphUVs.v0[idx];
+            float u1  = g_client.glyphUVs.u1[idx];
+            float v1  = g_client.glyphUVs.v1[idx];
+            
+            // Top left, top right, bottom left, bottom right of the glyph.
+            // Rotated glyphs were turned clockwise, so their top left is at
+            // the top right of their area in the atlas.
+            float uvs[4][2] = {
+                {u0, v0}, {u1, v0}, {u0, v1}, {u1, v1},
+            };
+            if (glyph->rot) {
+                float rotated[4][2] = {
+                    {u1, v0}, {u1, v1}, {u0, v0}, {u0, v1},
+                };
+                memcpy(uvs, rotated, sizeof(uvs));
+            }
             
+            // Fonts that share an atlas are told apart by the channel
+            // their glyphs are sampled from
+            float ch = (float)glyph->channel;
             float values[] = {
-                x0, y0, 0.0f, u0, v0, 1.0f, 1.0f, 1.0f, 1.0f,
-                x1, y0, 0.0f, u1, v0, 1.0f, 1.0f, 1.0f, 1.0f,
-                x0, y1, 0.0f, u0, v1, 1.0f, 1.0f, 1.0f, 1.0f,
-                x1, y1, 0.0f, u1, v1, 1.0f, 1.0f, 1.0f, 1.0f,
+                x0, y0, 0.0f, uvs[0][0], uvs[0][1], 1.0f, 1.0f, 1.0f, 1.0f, ch,
+                x1, y0, 0.0f, uvs[1][0], uvs[1][1], 1.0f, 1.0f, 1.0f, 1.0f, ch,
+                x0, y1, 0.0f, uvs[2][0], uvs[2][1], 1.0f, 1.0f, 1.0f, 1.0f, ch,
+                x1, y1, 0.0f, uvs[3][0], uvs[3][1], 1.0f, 1.0f, 1.0f, 1.0f, ch,
             };
             
             memcpy(g_values + g_numValues, values, sizeof(values));
@@ -305,8 +325,23 @@ int main() {
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glGenTextures(1, &g_texture);
     glBindTexture(GL_TEXTURE_2D, g_texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, g_texw, g_texh, 0, GL_RED, GL_UNSIGNED_BYTE, g_client.atlasPixels);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    for (int level = 0; level < g_client.atlasPages[0].numLevels; level++) {
+        int         levelw, levelh;
+        size_t      levelsize;
+        const char* data = dffont_client_get_page_level(&g_client.atlasPages[0], level, &levelw, &levelh, &levelsize);
+        if (g_client.atlasPages[0].format == DFFONT_FORMAT_BC4) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, GL_COMPRESSED_RED_RGTC1, levelw, levelh, 0, (GLsizei)levelsize, data);
+        }
+        else if (g_client.atlasPages[0].format == DFFONT_FORMAT_RGBA8) {
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, levelw, levelh, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        }
+        else {
+            glTexImage2D(GL_TEXTURE_2D, level, GL_R8, levelw, levelh, 0, GL_RED, GL_UNSIGNED_BYTE, data);
+        }
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, g_client.atlasPages[0].numLevels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    g_client.atlasPages[0].numLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -327,10 +362,12 @@ int main() {
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VBO_STRIDE_SIZE, (void*)(0));
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, VBO_STRIDE_SIZE, (void*)(3 * sizeof(float)));
         glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, VBO_STRIDE_SIZE, (void*)(5 * sizeof(float)));
+        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, VBO_STRIDE_SIZE, (void*)(9 * sizeof(float)));
 
         glEnableVertexAttribArray(0);
         glEnableVertexAttribArray(1);
         glEnableVertexAttribArray(2);
+        glEnableVertexAttribArray(3);
 
         glBindVertexArray(0);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
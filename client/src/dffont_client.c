@@ -1,17 +1,287 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
 
 #include "dffont_client.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-int dffont_client_init(DFFont_Client* client, const char* filepath, const char* atlaspath) {
+/* See write_bundle in dffont's df_output.c for the layout */
+#define DFFONT_BUNDLE_MAGIC             "DFFB"
+#define DFFONT_BUNDLE_VERSION           2
+#define DFFONT_BUNDLE_HEADER_SIZE       64
+#define DFFONT_BUNDLE_PAGE_RECORD_SIZE  32
+#define DFFONT_BUNDLE_COMPRESSION_NONE  0
+#define DFFONT_BUNDLE_COMPRESSION_ZLIB  1
+
+#define DFFONT_KTX2_HEADER_SIZE           80
+#define DFFONT_KTX2_LEVEL_INDEX_SIZE      24
+#define DFFONT_KTX2_VK_FORMAT_R8_UNORM        9
+#define DFFONT_KTX2_VK_FORMAT_R8G8B8A8_UNORM  37
+#define DFFONT_KTX2_VK_FORMAT_BC4_UNORM       139
+#define DFFONT_DDS_HEADER_SIZE                148 /* Magic, header, and DX10 header */
+#define DFFONT_DDS_DXGI_FORMAT_R8_UNORM       61
+#define DFFONT_DDS_DXGI_FORMAT_R8G8B8A8_UNORM 28
+#define DFFONT_DDS_DXGI_FORMAT_BC4_UNORM      80
+#define DFFONT_DDS_MIPMAPCOUNT            0x20000
+
+static uint32_t dffont_client_get_u32(const char* data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint64_t dffont_client_get_u64(const char* data) {
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static size_t dffont_client_get_level_size(const DFFont_Atlas_Page* page, int level, int* width, int* height) {
+    int w = page->width >> level > 0 ? page->width >> level : 1;
+    int h = page->height >> level > 0 ? page->height >> level : 1;
+    if (width != NULL) {
+        *width = w;
+    }
+    if (height != NULL) {
+        *height = h;
+    }
+    switch (page->format) {
+        case DFFONT_FORMAT_BC4:
+            return DFFONT_BC4_SIZE(w, h);
+        case DFFONT_FORMAT_RGBA8:
+            return (size_t)w * h * 4;
+        default:
+            return (size_t)w * h;
+    }
+}
+
+const char* dffont_client_get_page_level(const DFFont_Atlas_Page* page, int level, int* width, int* height, size_t* size) {
+    if (level < 0 || level >= page->numLevels) {
+        return NULL;
+    }
+
+    const char* data = page->pixels;
+    for (int i = 0; i < level; i++) {
+        data += dffont_client_get_level_size(page, i, NULL, NULL);
+    }
+    size_t levelSize = dffont_client_get_level_size(page, level, width, height);
+    if (size != NULL) {
+        *size = levelSize;
+    }
+    return data;
+}
+
+static int dffont_client_load_page(DFFont_Atlas_Page* page, const char* path) {
+    // KTX2 and DDS pages written by dffont hold R8 or RGBA8 pixels or BC4
+    // blocks, with one level or a full mip chain, which are copied out as
+    // they are.
+    // Anything else goes through stb_image, which also rejects raw pages since
+    // they have no header.
+    static const char ktx2Identifier[12] = {(char)0xab, 'K', 'T', 'X', ' ', '2', '0', (char)0xbb, '\r', '\n', 0x1a, '\n'};
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    // Large enough for either header, the KTX2 one is followed by the level index
+    char     header[DFFONT_KTX2_HEADER_SIZE + DFFONT_MAX_LEVELS * DFFONT_KTX2_LEVEL_INDEX_SIZE];
+    size_t   headerSize = fread(header, 1, sizeof(header), file);
+    uint64_t width      = 0;
+    uint64_t height     = 0;
+    uint32_t numLevels  = 1;
+    uint32_t format     = 0;
+    int      isKtx2     = 0;
+
+    if (headerSize >= DFFONT_KTX2_HEADER_SIZE + 8 && memcmp(header, ktx2Identifier, 12) == 0) {
+        format       = dffont_client_get_u32(header + 12);
+        page->format = format == DFFONT_KTX2_VK_FORMAT_R8_UNORM       ? DFFONT_FORMAT_R8 :
+                       format == DFFONT_KTX2_VK_FORMAT_R8G8B8A8_UNORM ? DFFONT_FORMAT_RGBA8 :
+                       format == DFFONT_KTX2_VK_FORMAT_BC4_UNORM      ? DFFONT_FORMAT_BC4 : -1;
+        if (page->format < 0 || dffont_client_get_u32(header + 44) != 0) {
+            fclose(file);
+            return 0;
+        }
+        width        = dffont_client_get_u32(header + 20);
+        height       = dffont_client_get_u32(header + 24);
+        numLevels    = dffont_client_get_u32(header + 40);
+        numLevels    = numLevels > 0 ? numLevels : 1;
+        isKtx2       = 1;
+    }
+    else if (headerSize >= DFFONT_DDS_HEADER_SIZE && memcmp(header, "DDS ", 4) == 0) {
+        format       = dffont_client_get_u32(header + 128);
+        page->format = format == DFFONT_DDS_DXGI_FORMAT_R8_UNORM       ? DFFONT_FORMAT_R8 :
+                       format == DFFONT_DDS_DXGI_FORMAT_R8G8B8A8_UNORM ? DFFONT_FORMAT_RGBA8 :
+                       format == DFFONT_DDS_DXGI_FORMAT_BC4_UNORM      ? DFFONT_FORMAT_BC4 : -1;
+        if (memcmp(header + 84, "DX10", 4) != 0 || page->format < 0) {
+            fclose(file);
+            return 0;
+        }
+        width        = dffont_client_get_u32(header + 16);
+        height       = dffont_client_get_u32(header + 12);
+        numLevels    = dffont_client_get_u32(header + 8) & DFFONT_DDS_MIPMAPCOUNT ? dffont_client_get_u32(header + 28) : 1;
+        numLevels    = numLevels > 0 ? numLevels : 1;
+    }
+    else {
+        fclose(file);
+
+        // Shared atlases are RGBA, the others are grayscale
+        int comp;
+        page->pixels = stbi_load(path, &page->width, &page->height, &comp, 0);
+        if (page->pixels != NULL && comp != 1 && comp != 4) {
+            stbi_image_free(page->pixels);
+            page->pixels = NULL;
+        }
+        page->format    = comp == 4 ? DFFONT_FORMAT_RGBA8 : DFFONT_FORMAT_R8;
+        page->numLevels = 1;
+        page->dataSize  = page->pixels != NULL ? (size_t)page->width * page->height * comp : 0;
+        return page->pixels != NULL;
+    }
+
+    if (width == 0 || height == 0 || width > INT32_MAX || height > INT32_MAX || width * height > SIZE_MAX / 8 ||
+        numLevels > DFFONT_MAX_LEVELS ||
+        (isKtx2 && headerSize < DFFONT_KTX2_HEADER_SIZE + numLevels * DFFONT_KTX2_LEVEL_INDEX_SIZE))
+    {
+        fclose(file);
+        return 0;
+    }
+
+    // The levels are stored largest first, allocated the same way as
+    // stb_image's pixels so all pages are freed the same way. A full mip chain
+    // is less than twice the size of level 0.
+    page->width     = (int)width;
+    page->height    = (int)height;
+    page->numLevels = (int)numLevels;
+    page->dataSize  = 0;
+    for (int level = 0; level < page->numLevels; level++) {
+        page->dataSize += dffont_client_get_level_size(page, level, NULL, NULL);
+    }
+
+    page->pixels = STBI_MALLOC(page->dataSize);
+    if (page->pixels == NULL) {
+        fclose(file);
+        return 0;
+    }
+
+    // DDS levels follow the header back to back, KTX2 ones are wherever the
+    // level index says
+    char*    data   = page->pixels;
+    uint64_t offset = DFFONT_DDS_HEADER_SIZE;
+    for (int level = 0; level < page->numLevels; level++) {
+        size_t size = dffont_client_get_level_size(page, level, NULL, NULL);
+        if (isKtx2) {
+            const char* index = header + DFFONT_KTX2_HEADER_SIZE + level * DFFONT_KTX2_LEVEL_INDEX_SIZE;
+            offset = dffont_client_get_u64(index);
+            if (dffont_client_get_u64(index + 8) != size) {
+                break;
+            }
+        }
+        if (offset > LONG_MAX || fseek(file, (long)offset, SEEK_SET) != 0 || fread(data, 1, size, file) != size) {
+            break;
+        }
+        data   += size;
+        offset += size;
+    }
+    fclose(file);
+
+    if (data != page->pixels + page->dataSize) {
+        STBI_FREE(page->pixels);
+        page->pixels = NULL;
+    }
+    return page->pixels != NULL;
+}
+
+static int dffont_client_add_to_table(DFFont_Client* client, int glyphIdx) {
+    int codepoint = client->glyphs[glyphIdx].codepoint;
+    if (codepoint < 0 || codepoint > DFFONT_MAX_CODEPOINT) {
+        return 0;
+    }
+
+    int** page = client->glyphPages + codepoint / DFFONT_PAGE_SIZE;
+    if (*page == NULL) {
+        *page = calloc(DFFONT_PAGE_SIZE, sizeof(int));
+        if (*page == NULL) {
+            return 0;
+        }
+    }
+
+    (*page)[codepoint % DFFONT_PAGE_SIZE] = glyphIdx + 1;
+    return 1;
+}
+
+static char* dffont_client_get_page_path(const char* path, int page, int numPages) {
+    // Matches the names dffont gives to pages: <name>_<page>.<ext>
+    size_t len = strlen(path);
+    char*  out = malloc(len + 16);
+    if (out == NULL) {
+        return NULL;
+    }
+
+    if (numPages == 1) {
+        memcpy(out, path, len + 1);
+        return out;
+    }
+
+    const char* ext = strrchr(path, '.');
+    const char* sep = strrchr(path, '/');
+    if (ext == NULL || (sep != NULL && ext < sep) || ext == path || ext[-1] == '/') {
+        ext = path + len;
+    }
+
+    sprintf(out, "%.*s_%d%s", (int)(ext - path), path, page, ext);
+    return out;
+}
+
+static int dffont_client_init_uvs(DFFont_Client* client) {
+    // Bundles store the UVs, so this is only done for font info files
+    float* uvs = malloc((client->numGlyphs > 0 ? client->numGlyphs : 1) * 4 * sizeof(float));
+    if (uvs == NULL) {
+        return 0;
+    }
+
+    client->glyphUVs.u0 = uvs;
+    client->glyphUVs.v0 = uvs + client->numGlyphs;
+    client->glyphUVs.u1 = uvs + client->numGlyphs * 2;
+    client->glyphUVs.v1 = uvs + client->numGlyphs * 3;
+
+    for (int i = 0; i < client->numGlyphs; i++) {
+        DFFont_Glyph*      glyph = client->glyphs + i;
+        DFFont_Atlas_Page* page  = client->atlasPages + glyph->page;
+        int                areaW = glyph->rot ? glyph->h : glyph->w;
+        int                areaH = glyph->rot ? glyph->w : glyph->h;
+
+        client->glyphUVs.u0[i] = (float)glyph->x / (float)page->width;
+        client->glyphUVs.v0[i] = (float)glyph->y / (float)page->height;
+        client->glyphUVs.u1[i] = (float)(glyph->x + areaW) / (float)page->width;
+        client->glyphUVs.v1[i] = (float)(glyph->y + areaH) / (float)page->height;
+    }
+    return 1;
+}
+
+static int dffont_client_read_info(DFFont_Client* client, const char* filepath) {
+    memset(client, 0, sizeof(DFFont_Client));
+
     {
         #define DFFONT_CLIENT_FSCANF(numArgs, format, ...)\
         {                                                \
             int res = fscanf(file, format, __VA_ARGS__); \
             if (res != numArgs) {                        \
                 fclose(file);                            \
+                dffont_client_free(client);              \
                 return 0;                                \
             }                                            \
         }
@@ -24,39 +294,357 @@ int dffont_client_init(DFFont_Client* client, const char* filepath, const char*
         DFFONT_CLIENT_FSCANF(1, "num_glyphs=%d\n", &client->numGlyphs);
         DFFONT_CLIENT_FSCANF(1, "ppem=%d\n", &client->ppemInitial);
         DFFONT_CLIENT_FSCANF(1, "line_gap=%d\n", &client->lineGap);
+
+        // num_pages is only written when there is more than one page
+        if (fscanf(file, "num_pages=%d\n", &client->numAtlasPages) != 1) {
+            client->numAtlasPages = 1;
+        }
         
-        if (client->numGlyphs != DFFONT_NUM_CHARS) {
+        if (client->numGlyphs < 0 || client->numAtlasPages < 1) {
             fclose(file);
             return 0;
         }
+
+        client->glyphs     = calloc(client->numGlyphs > 0 ? client->numGlyphs : 1, sizeof(DFFont_Glyph));
+        client->glyphPages = calloc(DFFONT_NUM_PAGES, sizeof(int*));
+        if (client->glyphs == NULL || client->glyphPages == NULL) {
+            fclose(file);
+            dffont_client_free(client);
+            return 0;
+        }
         
-        for (int i = 0; i < DFFONT_NUM_CHARS; i++) {
+        for (int i = 0; i < client->numGlyphs; i++) {
             DFFont_Glyph* glyph = client->glyphs + i;
             DFFONT_CLIENT_FSCANF(
-                9, "char=%d, x=%d, y=%d, w=%d, h=%d, xoff=%d, yoff=%d, xadv=%d, yadv=%d\n",
+                9, "char=%d, x=%d, y=%d, w=%d, h=%d, xoff=%d, yoff=%d, xadv=%d, yadv=%d",
                 &glyph->codepoint, &glyph->x, &glyph->y, &glyph->w, &glyph->h, 
                 &glyph->xoff, &glyph->yoff, &glyph->xadv, &glyph->yadv);
+
+            // Optional values that are only written when they are used
+            {
+                char key[16];
+                int  value;
+                while (fscanf(file, ", %15[a-z]=%d", key, &value) == 2) {
+                    if (strcmp(key, "rot") == 0) {
+                        glyph->rot = value;
+                    }
+                    else if (strcmp(key, "page") == 0) {
+                        glyph->page = value;
+                    }
+                    else if (strcmp(key, "channel") == 0) {
+                        glyph->channel = value;
+                    }
+                }
+                fscanf(file, "\n");
+            }
+
+            if (glyph->page < 0 || glyph->page >= client->numAtlasPages || glyph->channel < 0 || glyph->channel > 3) {
+                fclose(file);
+                dffont_client_free(client);
+                return 0;
+            }
+
+            if (!dffont_client_add_to_table(client, i)) {
+                fclose(file);
+                dffont_client_free(client);
+                return 0;
+            }
         }
         
         fclose(file);
     }
+
+    return 1;
+}
+
+int dffont_client_init(DFFont_Client* client, const char* filepath, const char* atlaspath) {
+    if (!dffont_client_read_info(client, filepath)) {
+        return 0;
+    }
+
+    client->atlasPages = calloc(client->numAtlasPages, sizeof(DFFont_Atlas_Page));
+    if (client->atlasPages == NULL) {
+        dffont_client_free(client);
+        return 0;
+    }
+
+    for (int i = 0; i < client->numAtlasPages; i++) {
+        DFFont_Atlas_Page* page = client->atlasPages + i;
+
+        char* path = dffont_client_get_page_path(atlaspath, i, client->numAtlasPages);
+        if (path == NULL) {
+            dffont_client_free(client);
+            return 0;
+        }
+
+        int loaded = dffont_client_load_page(page, path);
+        free(path);
+        if (!loaded) {
+            dffont_client_free(client);
+            return 0;
+        }
+    }
+
+    if (!dffont_client_init_uvs(client)) {
+        dffont_client_free(client);
+        return 0;
+    }
+
+    client->atlasPixels = client->atlasPages[0].pixels;
+    client->atlasWidth  = client->atlasPages[0].width;
+    client->atlasHeight = client->atlasPages[0].height;
     
+    return 1;
+}
+
+int dffont_client_init_shared(DFFont_Client* client, const char* filepath, const DFFont_Client* atlasClient) {
+    if (!dffont_client_read_info(client, filepath)) {
+        return 0;
+    }
+
+    // Every font that shares an atlas is written with the atlas's number of
+    // pages
+    if (client->numAtlasPages != atlasClient->numAtlasPages) {
+        dffont_client_free(client);
+        return 0;
+    }
+
+    client->atlasPages  = atlasClient->atlasPages;
+    client->sharesAtlas = 1;
+    if (!dffont_client_init_uvs(client)) {
+        dffont_client_free(client);
+        return 0;
+    }
+
+    client->atlasPixels = client->atlasPages[0].pixels;
+    client->atlasWidth  = client->atlasPages[0].width;
+    client->atlasHeight = client->atlasPages[0].height;
+
+    return 1;
+}
+
+static void* dffont_client_map_file(const char* path, size_t* size) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0 || (unsigned long long)fileSize.QuadPart > SIZE_MAX) {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    // The view keeps the mapping (and the file) alive, so the handles can be
+    // closed immediately
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+        return NULL;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    *size = (size_t)fileSize.QuadPart;
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || (unsigned long long)st.st_size > SIZE_MAX) {
+        close(fd);
+        return NULL;
+    }
+
+    // The mapping keeps the file alive, so the descriptor can be closed
+    // immediately
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+
+    *size = (size_t)st.st_size;
+    return data;
+#endif
+}
+
+static void dffont_client_unmap_file(void* data, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+static int dffont_client_in_bundle(DFFont_Client* client, uint64_t offset, uint64_t size) {
+    return offset <= client->bundleSize && size <= client->bundleSize - offset;
+}
+
+int dffont_client_init_bundle(DFFont_Client* client, const char* bundlepath) {
+    memset(client, 0, sizeof(DFFont_Client));
+
+    client->bundleData = dffont_client_map_file(bundlepath, &client->bundleSize);
+    if (client->bundleData == NULL) {
+        return 0;
+    }
+
+    const char* data = (const char*)client->bundleData;
+
+    // The version is read in the machine's byte order, so it doesn't match on
+    // big endian machines
+    if (client->bundleSize < DFFONT_BUNDLE_HEADER_SIZE ||
+        memcmp(data, DFFONT_BUNDLE_MAGIC, 4) != 0 ||
+        dffont_client_get_u32(data + 4) != DFFONT_BUNDLE_VERSION ||
+        dffont_client_get_u32(data + 24) != sizeof(DFFont_Glyph))
     {
-        int comp;
-        client->atlasPixels = stbi_load(atlaspath, &client->atlasWidth, &client->atlasHeight, &comp, 0);
-        if (client->atlasPixels == NULL) {
+        dffont_client_free(client);
+        return 0;
+    }
+
+    client->numGlyphs     = (int)dffont_client_get_u32(data + 8);
+    client->ppemInitial   = (int)dffont_client_get_u32(data + 12);
+    client->lineGap       = (int)dffont_client_get_u32(data + 16);
+    client->numAtlasPages = (int)dffont_client_get_u32(data + 20);
+
+    uint64_t pagesOff  = dffont_client_get_u64(data + 32);
+    uint64_t glyphsOff = dffont_client_get_u64(data + 40);
+    uint64_t uvsOff    = dffont_client_get_u64(data + 48);
+    uint64_t indexOff  = dffont_client_get_u64(data + 56);
+    uint64_t numGlyphs = (uint64_t)(unsigned int)client->numGlyphs;
+
+    if (client->numGlyphs < 0 || client->numAtlasPages < 1 ||
+        !dffont_client_in_bundle(client, pagesOff, (uint64_t)client->numAtlasPages * DFFONT_BUNDLE_PAGE_RECORD_SIZE) ||
+        !dffont_client_in_bundle(client, glyphsOff, numGlyphs * sizeof(DFFont_Glyph)) ||
+        !dffont_client_in_bundle(client, uvsOff, numGlyphs * 4 * sizeof(float)) ||
+        !dffont_client_in_bundle(client, indexOff, DFFONT_NUM_PAGES * sizeof(uint32_t)))
+    {
+        dffont_client_free(client);
+        return 0;
+    }
+
+    // Every section is aligned, so the tables are used in place
+    client->glyphs      = (DFFont_Glyph*)(data + glyphsOff);
+    client->glyphUVs.u0 = (float*)(data + uvsOff);
+    client->glyphUVs.v0 = client->glyphUVs.u0 + numGlyphs;
+    client->glyphUVs.u1 = client->glyphUVs.u0 + numGlyphs * 2;
+    client->glyphUVs.v1 = client->glyphUVs.u0 + numGlyphs * 3;
+
+    client->glyphPages = calloc(DFFONT_NUM_PAGES, sizeof(int*));
+    client->atlasPages = calloc(client->numAtlasPages, sizeof(DFFont_Atlas_Page));
+    if (client->glyphPages == NULL || client->atlasPages == NULL) {
+        dffont_client_free(client);
+        return 0;
+    }
+
+    const uint32_t* index = (const uint32_t*)(data + indexOff);
+    for (int i = 0; i < DFFONT_NUM_PAGES; i++) {
+        if (index[i] == 0) {
+            continue;
+        }
+        if (!dffont_client_in_bundle(client, index[i], DFFONT_PAGE_SIZE * sizeof(int))) {
+            dffont_client_free(client);
+            return 0;
+        }
+        client->glyphPages[i] = (int*)(data + index[i]);
+    }
+
+    for (int i = 0; i < client->numAtlasPages; i++) {
+        DFFont_Atlas_Page* page        = client->atlasPages + i;
+        const char*        record      = data + pagesOff + (uint64_t)i * DFFONT_BUNDLE_PAGE_RECORD_SIZE;
+        uint32_t           compression = dffont_client_get_u32(record + 8);
+        uint64_t           offset      = dffont_client_get_u64(record + 16);
+        uint64_t           size        = dffont_client_get_u64(record + 24);
+
+        page->width     = (int)dffont_client_get_u32(record);
+        page->height    = (int)dffont_client_get_u32(record + 4);
+        page->format    = DFFONT_FORMAT_R8;
+        page->numLevels = 1;
+        page->dataSize  = (size_t)page->width * page->height;
+
+        uint64_t numPixels = (uint64_t)page->width * (uint64_t)page->height;
+        if (page->width <= 0 || page->height <= 0 || numPixels > INT32_MAX || !dffont_client_in_bundle(client, offset, size)) {
+            dffont_client_free(client);
             return 0;
         }
-        if (comp != 1) {
+
+        if (compression == DFFONT_BUNDLE_COMPRESSION_NONE && size == numPixels) {
+            page->pixels   = (char*)(data + offset);
+            page->isMapped = 1;
+        }
+        else if (compression == DFFONT_BUNDLE_COMPRESSION_ZLIB && size <= INT32_MAX) {
+            page->pixels = STBI_MALLOC(numPixels);
+            if (page->pixels == NULL ||
+                stbi_zlib_decode_buffer(page->pixels, (int)numPixels, data + offset, (int)size) != (int)numPixels)
+            {
+                dffont_client_free(client);
+                return 0;
+            }
+        }
+        else {
             dffont_client_free(client);
             return 0;
         }
     }
-    
+
+    client->atlasPixels = client->atlasPages[0].pixels;
+    client->atlasWidth  = client->atlasPages[0].width;
+    client->atlasHeight = client->atlasPages[0].height;
+
     return 1;
 }
 
 void dffont_client_free(DFFont_Client* client) {
-    stbi_image_free(client->atlasPixels);
+    // Everything but the page table and decompressed pages of a bundle
+    // points into the mapped file
+    int isBundle = client->bundleData != NULL;
+
+    if (client->glyphPages != NULL && !isBundle) {
+        for (int i = 0; i < DFFONT_NUM_PAGES; i++) {
+            free(client->glyphPages[i]);
+        }
+    }
+    if (client->atlasPages != NULL && !client->sharesAtlas) {
+        for (int i = 0; i < client->numAtlasPages; i++) {
+            if (!client->atlasPages[i].isMapped) {
+                stbi_image_free(client->atlasPages[i].pixels);
+            }
+        }
+        free(client->atlasPages);
+    }
+    if (!isBundle) {
+        free(client->glyphs);
+        free(client->glyphUVs.u0);
+    }
+    else {
+        dffont_client_unmap_file(client->bundleData, client->bundleSize);
+    }
+    free(client->glyphPages);
+    memset(&client->glyphUVs, 0, sizeof(DFFont_Glyph_UVs));
+    client->glyphPages  = NULL;
+    client->glyphs      = NULL;
+    client->atlasPages  = NULL;
     client->atlasPixels = NULL;
+    client->bundleData  = NULL;
+    client->bundleSize  = 0;
+}
+
+DFFont_Glyph* dffont_client_get_glyph(DFFont_Client* client, int codepoint) {
+    if (codepoint < 0 || codepoint > DFFONT_MAX_CODEPOINT) {
+        return NULL;
+    }
+    int* page = client->glyphPages[codepoint / DFFONT_PAGE_SIZE];
+    if (page == NULL || page[codepoint % DFFONT_PAGE_SIZE] == 0) {
+        return NULL;
+    }
+    return client->glyphs + page[codepoint % DFFONT_PAGE_SIZE] - 1;
 }
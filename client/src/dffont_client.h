@@ -1,10 +1,13 @@
 #ifndef DFFONT_CLIENT_H
 #define DFFONT_CLIENT_H
 
-#define DFFONT_FIRST_CHAR ' '
-#define DFFONT_LAST_CHAR  '~'
-#define DFFONT_NUM_CHARS  (DFFONT_LAST_CHAR - DFFONT_FIRST_CHAR + 1)
+#include <stddef.h>
 
+#define DFFONT_MAX_CODEPOINT   0x10FFFF
+#define DFFONT_PAGE_SIZE       256
+#define DFFONT_NUM_PAGES       ((DFFONT_MAX_CODEPOINT + 1) / DFFONT_PAGE_SIZE)
+
+/* The layout matches the glyph table of a bundle, so a mapped bundle's glyphs are used in place */
 typedef struct {
     int codepoint;
     int x;
@@ -15,21 +18,102 @@ typedef struct {
     int yoff;
     int xadv;
     int yadv;
+    int rot;     /* 1 if the glyph is rotated 90 degrees clockwise in the atlas, so it takes up h x w pixels */
+    int page;    /* Index into the client's atlasPages */
+    int channel; /* The atlas channel the glyph is in, 0-3 for red, green, blue, and alpha */
 } DFFont_Glyph;
 
+#define DFFONT_FORMAT_R8       0 /* One byte per pixel */
+#define DFFONT_FORMAT_BC4      1 /* BC4 blocks, which GPUs can sample without decompressing them */
+#define DFFONT_FORMAT_RGBA8    2 /* Four bytes per pixel, the atlas of fonts that share one (see dffont_client_init_shared) */
+
+/* The most levels a page can have, enough for a full mip chain of any size */
+#define DFFONT_MAX_LEVELS      32
+
+/* The bytes of BC4 blocks in a w x h page, each 4x4 block of pixels is 8 bytes */
+#define DFFONT_BC4_SIZE(w, h)  ((size_t)(((w) + 3) / 4) * (((h) + 3) / 4) * 8)
+
+typedef struct {
+    char*  pixels;    /* The pixels, or the blocks if the format is DFFONT_FORMAT_BC4, of every level, largest first */
+    size_t dataSize;  /* The number of bytes in pixels */
+    int    width;     /* The size of level 0 */
+    int    height;
+    int    format;    /* DFFONT_FORMAT_R8, DFFONT_FORMAT_BC4, or DFFONT_FORMAT_RGBA8 */
+    int    numLevels; /* 1, or a full mip chain down to 1x1 if dffont was run with --mips */
+    int    isMapped;  /* 1 if the pixels point into a mapped bundle and aren't freed */
+} DFFont_Atlas_Page;
+
+/*
+ * The area of each glyph in its atlas page, from 0 to 1, indexed the same as
+ * the client's glyphs. Rotated glyphs take up h x w pixels.
+ */
 typedef struct {
-    DFFont_Glyph  glyphs[DFFONT_NUM_CHARS];
-    char*         atlasPixels;
-    int           atlasWidth;
-    int           atlasHeight;
-    int           numGlyphs; /* This should always equal DFFONT_NUM_CHARS */
-    int           ppemInitial;
-    int           lineGap;
+    float* u0;
+    float* v0;
+    float* u1;
+    float* v1;
+} DFFont_Glyph_UVs;
+
+typedef struct {
+    DFFont_Glyph*       glyphs;        /* In the same order as the font info file */
+    DFFont_Glyph_UVs    glyphUVs;
+    int**               glyphPages;    /* Maps codepoints to glyphs, DFFONT_PAGE_SIZE codepoints per page. 
+                                          Pages are NULL if none of their codepoints have a glyph, and 
+                                          entries are the glyph's index + 1 or 0 if there is no glyph. */
+    DFFont_Atlas_Page*  atlasPages;
+    int                 numAtlasPages;
+    char*               atlasPixels;   /* The same as atlasPages[0] */
+    int                 atlasWidth;
+    int                 atlasHeight;
+    int                 numGlyphs;
+    int                 ppemInitial;
+    int                 lineGap;
+    void*               bundleData;    /* The mapped bundle, NULL if the font wasn't loaded from one */
+    size_t              bundleSize;
+    int                 sharesAtlas;   /* 1 if atlasPages belong to another client */
 } DFFont_Client;
 
 
+/*
+ * If the font has more than one page, `atlaspath` is the path that was given
+ * to dffont, and the pages are loaded from <name>_<page>.<ext>. Pages can be
+ * PNG, KTX2, or DDS images, but not raw ones, since they don't store their
+ * size. KTX2 and DDS pages may be BC4 compressed, in which case the page's
+ * format is DFFONT_FORMAT_BC4 and atlasPixels holds page 0's blocks, and may
+ * have mip levels, which follow level 0 in the page's pixels. RGBA pages hold
+ * several fonts, see `dffont_client_init_shared`.
+ */
 int dffont_client_init(DFFont_Client* client, const char* filepath, const char* atlaspath);
 
+/*
+ * Loads a font that was written to one channel of an atlas it shares with
+ * other fonts (dffont's --channel). One of the fonts is loaded with
+ * `dffont_client_init`, which loads the RGBA atlas, and the others use its
+ * pages instead of loading them again, so every font can be drawn with one
+ * texture by sampling each glyph's channel. `atlasClient` must be freed after
+ * `client`.
+ */
+int dffont_client_init_shared(DFFont_Client* client, const char* filepath, const DFFont_Client* atlasClient);
+
+/*
+ * Loads a bundle written with dffont's --out-bundle. The file is mapped and
+ * the glyphs, UVs, codepoint table, and uncompressed pages are used in place,
+ * so nothing is parsed. Only the bounds of each section are checked, since
+ * the bundle is trusted to have been written by dffont. Bundles are little
+ * endian and can't be loaded on big endian machines.
+ */
+int dffont_client_init_bundle(DFFont_Client* client, const char* bundlepath);
+
 void dffont_client_free(DFFont_Client* client);
 
+/*
+ * Returns a level of a page and sets its size and its number of bytes, or
+ * returns NULL if the page doesn't have the level. Any of the outputs can be
+ * NULL.
+ */
+const char* dffont_client_get_page_level(const DFFont_Atlas_Page* page, int level, int* width, int* height, size_t* size);
+
+/* Returns NULL if the font doesn't have a glyph for the codepoint */
+DFFont_Glyph* dffont_client_get_glyph(DFFont_Client* client, int codepoint);
+
 #endif
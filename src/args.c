@@ -2,15 +2,29 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <errno.h>
 #include "args.h"
+#include "thread.h"
+#include "deflate.h"
+
+/* Most GPUs support textures at least this large */
+#define DFFONT_DEFAULT_MAX_PAGE_SIZE 4096
+
+/* In MiB */
+#define DFFONT_DEFAULT_CACHE_SIZE 512
 
 static void print_ttf_help() {
     printf(
         "usage:\n"
-        "    dffont ttf <path> <glyph-size> <width,height>\n"
-        "               [--spread=<value>] [--scale=<value>]\n"
-        "               [--padding=<left,right,top,bottom>]\n"
+        "    dffont ttf <path> <glyph-size> <width,height|auto>\n"
+        "               [--spread=<value>] [--scale=<value>] [--threads=<value>]\n"
+        "               [--charset=<value>] [--padding=<left,right,top,bottom>] [--rotate]\n"
+        "               [--dedup-outlines] [--max-page-size=<width,height>]\n"
+        "               [--cache-dir=<path>] [--cache-size=<MiB>]\n"
         "               [--out-image=<path>] [--out-info=<path>]\n"
+        "               [--out-bundle=<path>] [--compress-bundle]\n"
+        "               [--image-format=<png|raw|ktx2|dds>] [--png-level=<0-9>]\n"
+        "               [--bc4] [--bc4-report=<path>] [--mips] [--channel=<r|g|b|a>]\n"
         "\n"
         "Description:\n"
         "    Generates distance fields for glyphs in a TrueType Font file.\n"
@@ -20,8 +34,12 @@ static void print_ttf_help() {
         "        The path to a TTF file.\n"
         "    <glyph-size>\n"
         "        The ppem that each glyph will be rendered at.\n"
-        "    <width,height>\n"
-        "        The width and height of output image (in pixels).\n"
+        "    <width,height|auto>\n"
+        "        The width and height of output image (in pixels). If the glyphs don't fit, they are\n"
+        "        spread across several images of that size. With auto, each image is the smallest\n"
+        "        power of two size that holds its glyphs.\n"
+        "        When there is more than one image, they are written to <name>_<page>.<ext> and the\n"
+        "        font info file has a 'num_pages' value and a 'page' value for each glyph.\n"
         "Options:\n"
         "    [--spread=<value>]\n"
         "        How far from the edge of a glyph the effect of a the distance field will be seen.\n"
@@ -31,15 +49,117 @@ static void print_ttf_help() {
         "        The amount each glyph will be scaled before calculating its distance field. A larger scale\n"
         "        value will give better accuracy, but the calculations will take more time/ resources.\n"
         "        The default value is 5.\n"
+        "    [--threads=<value>]\n"
+        "        The number of threads that generate distance fields. The output does not depend on\n"
+        "        the number of threads.\n"
+        "        The default value is the number of logical processors.\n"
+        "    [--charset=<value>]\n"
+        "        The code points to generate glyphs for, as a comma separated list of:\n"
+        "            <code point>                A decimal or hex (0x4E00 or U+4E00) code point.\n"
+        "            <code point>-<code point>   An inclusive range of code points.\n"
+        "            @<path>                     Every character in a UTF-8 text file.\n"
+        "            all                         Every code point in the font.\n"
+        "        Code points that are not in the font are skipped. @<path> and all also skip control\n"
+        "        characters (0-31 and 127-159).\n"
+        "        The default value is 32-126 (printable ASCII).\n"
         "    [--padding=<left,right,top,bottom>]\n"
         "            The amount of padding there will be between glyphs.\n"
         "            The default values are 0.\n"
+        "    [--rotate]\n"
+        "            Allows glyphs to be rotated 90 degrees clockwise to pack them more tightly. Each\n"
+        "            glyph in the font info file gets a 'rot' value that is 1 if it was rotated. x and y\n"
+        "            are the top left of the rotated glyph, w and h are its size before rotation.\n"
+        "    [--dedup-outlines]\n"
+        "            Glyphs with identical outlines share one distance field and one rect in the image,\n"
+        "            like code points that map to the same glyph always do. Each glyph keeps its own\n"
+        "            advance.\n"
+        "    [--max-page-size=<width,height>]\n"
+        "            The largest an image can be when the size is auto.\n"
+        "            The default values are 4096,4096.\n"
+        "    [--cache-dir=<path>]\n"
+        "            A directory where the distance field of each glyph is kept between runs. Changing\n"
+        "            the padding, image size, or rotation reuses the cached glyphs, while changing the\n"
+        "            font, glyph size, spread, or scale generates new ones. The directory is created if\n"
+        "            it doesn't exist. By default, nothing is cached.\n"
+        "    [--cache-size=<MiB>]\n"
+        "            The most space the cache directory can use. The least recently used glyphs are\n"
+        "            deleted when it's exceeded.\n"
+        "            The default value is 512.\n"
         "    [--out-image=<path>]\n"
         "            The path of the output image.\n"
-        "            The default path is './dffont_image.png'.\n"
+        "            The default path is './dffont_image' with the image format's extension.\n"
         "    [--out-font=<path>]\n"
         "            The path of the output file that contains information about the font.\n"
-        "            The default path is './dffont_info'.\n");
+        "            The default path is './dffont_info'.\n"
+        "    [--out-bundle=<path>]\n"
+        "            The path of a binary file that holds the font info and every image, laid out so the\n"
+        "            client can map it and use it without parsing. When this is set, the image and font\n"
+        "            info files are only written if their paths are set too.\n"
+        "    [--compress-bundle]\n"
+        "            Compresses the images in the bundle with zlib. The bundle is smaller, but the client\n"
+        "            has to decompress the images when loading it.\n"
+        "    [--image-format=<png|raw|ktx2|dds>]\n"
+        "            The format of the output images:\n"
+        "                png    An 8-bit grayscale PNG, or RGBA with --channel.\n"
+        "                raw    width * height bytes, or 4 bytes per pixel with --channel, with no\n"
+        "                       header, so the size has to be known.\n"
+        "                ktx2   A KTX2 texture with the VK_FORMAT_R8_UNORM format, or\n"
+        "                       VK_FORMAT_R8G8B8A8_UNORM with --channel.\n"
+        "                dds    A DDS texture with the DXGI_FORMAT_R8_UNORM format, or\n"
+        "                       DXGI_FORMAT_R8G8B8A8_UNORM with --channel.\n"
+        "            raw, ktx2, and dds images can be uploaded to the GPU without being decoded.\n"
+        "            The default value is png.\n"
+        "    [--png-level=<0-9>]\n"
+        "            How hard PNG images are compressed. 0 stores the pixels uncompressed, 1 is the\n"
+        "            fastest, and 9 is the smallest. PNGs are compressed with --threads threads.\n"
+        "            The default value is 6.\n"
+        "    [--bc4]\n"
+        "            Compresses raw, ktx2, and dds images with BC4, which GPUs sample directly at half the\n"
+        "            size of uncompressed images. Can't be used with png images, and bundles aren't\n"
+        "            compressed with BC4.\n"
+        "    [--bc4-report=<path>]\n"
+        "            Writes the largest difference between each glyph's distance field and its BC4\n"
+        "            compressed version, in 8-bit distance values, to a file. Requires --bc4, and\n"
+        "            --out-image if --out-bundle is used.\n"
+        "    [--mips]\n"
+        "            Writes a full mip chain for each raw, ktx2, or dds image. Each level is filtered\n"
+        "            from the distances of level 0 instead of its pixel values, and has the same spread\n"
+        "            in its own pixels, so one atlas can be used at smaller sizes. Can't be used with png\n"
+        "            images.\n"
+        "    [--channel=<r|g|b|a>]\n"
+        "            Only valid in a batch manifest. Outputs with the same --out-image and a channel\n"
+        "            share one RGBA image, and each output's glyphs are written to its own channel, so\n"
+        "            several fonts or weights can be drawn from one texture. Each output is packed on its\n"
+        "            own into the same pages and keeps its own font info file, where each glyph gets a\n"
+        "            'channel' value from 0 (r) to 3 (a). The outputs must have the same image size,\n"
+        "            image format, PNG level, and --mips. Can't be used with --bc4 or --out-bundle.\n");
+}
+
+static void print_batch_help() {
+    printf(
+        "usage:\n"
+        "    dffont batch <manifest> [--threads=<value>]\n"
+        "\n"
+        "Description:\n"
+        "    Generates several fonts in one process. Each font file is loaded once, and the glyphs of\n"
+        "    every output are shared between the threads, so a large charset doesn't leave the other\n"
+        "    threads idle.\n"
+        "\n"
+        "Arguments:\n"
+        "    <manifest>\n"
+        "        A text file with one output per line. Each line has the same arguments as the ttf\n"
+        "        command, for example:\n"
+        "            fonts/Regular.ttf 32 auto --charset=32-126 --out-image=r32.png --out-font=r32.info\n"
+        "        Either --out-image and --out-font, or --out-bundle, are required, and --threads is\n"
+        "        ignored: each output's images are encoded on the one thread that finishes it. Empty\n"
+        "        lines and lines that start with '#' are skipped. Arguments that contain spaces can\n"
+        "        be quoted.\n"
+        "        Lines that have the same --out-image and a --channel share one RGBA image, see the\n"
+        "        ttf command's help.\n"
+        "Options:\n"
+        "    [--threads=<value>]\n"
+        "        The number of threads that generate distance fields.\n"
+        "        The default value is the number of logical processors.\n");
 }
 
 static void print_image_help() {
@@ -97,6 +217,19 @@ static int try_get_spread(Args* args, char* arg) {
     return 0;
 }
 
+static int try_get_threads(Args* args, char* arg) {
+    if (str_starts_with(arg, "--threads")) {
+        char* value = get_option_value(arg);
+        args->threads = parse_int(value, 1);
+        if (args->threads < 0) {
+            fprintf(stderr, "error: '%s': invalid number of threads\n", value);
+            exit(1);
+        }
+        return 1;
+    }
+    return 0;
+}
+
 static int try_get_scale(Args* args, char* arg) {
     if (str_starts_with(arg, "--scale")) {
         char* value = get_option_value(arg);
@@ -110,14 +243,187 @@ static int try_get_scale(Args* args, char* arg) {
     return 0;
 }
 
+void parse_ttf_args(Args* args, int argc, char** argv) {
+    memset(args, 0, sizeof(Args));
+
+    // Process arguments
+    if (argc < 3) {
+        fprintf(stderr, "error: too few arguments: use --help for more information\n");
+        exit(1);
+    }
+    {
+        args->ppem = parse_int(argv[1], 1);
+        if (args->ppem < 0) {
+            fprintf(stderr, "error: '%s': invalid glyph size\n", argv[1]);
+            exit(1);
+        }
+    }
+    if (strcmp(argv[2], "auto") == 0) {
+        args->auto_size   = 1;
+        args->out_image_w = DFFONT_DEFAULT_MAX_PAGE_SIZE;
+        args->out_image_h = DFFONT_DEFAULT_MAX_PAGE_SIZE;
+    }
+    else {
+        int values[2];
+        if (!parse_comma_separated_ints(argv[2], values, 2, 1)) {
+            fprintf(stderr, "error: '%s': invalid image size\n", argv[2]);
+            exit(1);
+        }
+        args->out_image_w = values[0];
+        args->out_image_h = values[1];
+    }
+    args->ttf_path = argv[0];
+
+    // Set default values for spread and scale in case they are not given as options
+    args->spread = roundf(args->ppem / 14.0f);
+    args->scale = 5;
+    args->threads = get_num_cpus();
+    args->charset = "32-126";
+    args->cache_size = (long long)DFFONT_DEFAULT_CACHE_SIZE << 20;
+    args->image_format = IMAGE_FORMAT_PNG;
+    args->png_level = IMAGE_DEFAULT_PNG_LEVEL;
+    args->channel = -1;
+
+    // Process options
+    for (int i = 3; i < argc; i++) {
+        char* arg = argv[i];
+
+        if (!try_get_spread(args, arg) && !try_get_scale(args, arg) && !try_get_threads(args, arg)) {
+            if (str_starts_with(arg, "--padding")) {
+                char* value = get_option_value(arg);
+                if (!parse_comma_separated_ints(value, args->padding, 4, 0)) {
+                    fprintf(stderr, "error: '%s': invalid value for padding\n", value);
+                    exit(1);
+                }
+            }
+            else if (str_starts_with(arg, "--max-page-size")) {
+                char* value = get_option_value(arg);
+                int values[2];
+                if (!parse_comma_separated_ints(value, values, 2, 1)) {
+                    fprintf(stderr, "error: '%s': invalid max page size\n", value);
+                    exit(1);
+                }
+                if (!args->auto_size) {
+                    fprintf(stderr, "error: --max-page-size can only be used with an image size of auto\n");
+                    exit(1);
+                }
+                args->out_image_w = values[0];
+                args->out_image_h = values[1];
+            }
+            else if (str_starts_with(arg, "--cache-dir")) {
+                args->cache_dir = get_option_value(arg);
+            }
+            else if (str_starts_with(arg, "--cache-size")) {
+                char* value = get_option_value(arg);
+                int size = parse_int(value, 0);
+                if (size < 0) {
+                    fprintf(stderr, "error: '%s': invalid cache size\n", value);
+                    exit(1);
+                }
+                args->cache_size = (long long)size << 20;
+            }
+            else if (strcmp(arg, "--rotate") == 0) {
+                args->rotate = 1;
+            }
+            else if (strcmp(arg, "--dedup-outlines") == 0) {
+                args->dedup_outlines = 1;
+            }
+            else if (str_starts_with(arg, "--charset")) {
+                args->charset = get_option_value(arg);
+            }
+            else if (str_starts_with(arg, "--out-image")) {
+                args->out_image_path = get_option_value(arg);
+            }
+            else if (str_starts_with(arg, "--out-bundle")) {
+                args->out_bundle_path = get_option_value(arg);
+            }
+            else if (str_starts_with(arg, "--image-format")) {
+                char* value = get_option_value(arg);
+                if (!image_parse_format(value, &args->image_format)) {
+                    fprintf(stderr, "error: '%s': invalid image format\n", value);
+                    exit(1);
+                }
+            }
+            else if (str_starts_with(arg, "--png-level")) {
+                char* value = get_option_value(arg);
+                args->png_level = parse_int(value, 0);
+                if (args->png_level < 0 || args->png_level > DEFLATE_MAX_LEVEL) {
+                    fprintf(stderr, "error: '%s': invalid PNG level\n", value);
+                    exit(1);
+                }
+            }
+            else if (strcmp(arg, "--compress-bundle") == 0) {
+                args->compress_bundle = 1;
+            }
+            else if (strcmp(arg, "--mips") == 0) {
+                args->mips = 1;
+            }
+            else if (str_starts_with(arg, "--channel")) {
+                char*       value    = get_option_value(arg);
+                const char* channels = "rgba";
+                if (strlen(value) != 1 || strchr(channels, value[0]) == NULL) {
+                    fprintf(stderr, "error: '%s': invalid channel\n", value);
+                    exit(1);
+                }
+                args->channel = (int)(strchr(channels, value[0]) - channels);
+            }
+            else if (strcmp(arg, "--bc4") == 0) {
+                args->bc4 = 1;
+            }
+            else if (str_starts_with(arg, "--bc4-report")) {
+                args->bc4_report_path = get_option_value(arg);
+            }
+            else if (str_starts_with(arg, "--out-font")) {
+                args->out_font_path = get_option_value(arg);
+            }
+            else if (strcmp(arg, "--help") == 0) {
+                fprintf(stderr, "error: --help is not valid in that context\n");
+                exit(1);
+            }
+            else {
+                fprintf(stderr, "error: '%s': unknown option\n", arg);
+                exit(1);
+            }
+        }
+    }
+
+    if (args->bc4 && args->image_format == IMAGE_FORMAT_PNG) {
+        fprintf(stderr, "error: --bc4 requires --image-format=raw, ktx2, or dds\n");
+        exit(1);
+    }
+    if (args->mips && args->image_format == IMAGE_FORMAT_PNG) {
+        fprintf(stderr, "error: --mips requires --image-format=raw, ktx2, or dds\n");
+        exit(1);
+    }
+    if (args->bc4_report_path != NULL && !args->bc4) {
+        fprintf(stderr, "error: --bc4-report requires --bc4\n");
+        exit(1);
+    }
+    if (args->bc4_report_path != NULL && args->out_bundle_path != NULL && args->out_image_path == NULL) {
+        // Only images are compressed with BC4, and with a bundle they're only
+        // written if they're asked for
+        fprintf(stderr, "error: --bc4-report requires --out-image when --out-bundle is used\n");
+        exit(1);
+    }
+    if (args->channel >= 0 && args->bc4) {
+        fprintf(stderr, "error: --channel can't be used with --bc4\n");
+        exit(1);
+    }
+    if (args->channel >= 0 && args->out_bundle_path != NULL) {
+        fprintf(stderr, "error: --channel can't be used with --out-bundle\n");
+        exit(1);
+    }
+}
+
 void parse_args(Args* args, int argc, char** argv) {
     // Check if no arguments were given or just --help was given
     if (argc == 1 || (argc == 2 && strcmp(argv[1], "--help") == 0)) {
         printf(
             "usage: dffont [--help] <command> [<args>]\n"
             "\n"
-            "These are the two commands that can be used:\n"
+            "These are the commands that can be used:\n"
             "    ttf      Generate distance fields for glyphs contained in a TrueType Font file.\n"
+            "    batch    Run several ttf commands listed in a manifest file in one process.\n"
             "    image    Generate a distance field for a given image.\n"
         );
         exit(0);
@@ -129,6 +435,10 @@ void parse_args(Args* args, int argc, char** argv) {
         print_ttf_help();
         exit(0);
     }
+    if (argc == 2 && strcmp(argv[1], "batch") == 0) {
+        print_batch_help();
+        exit(0);
+    }
     if (argc == 2 && strcmp(argv[1], "image") == 0) {
         print_image_help();
         exit(0);
@@ -148,6 +458,10 @@ void parse_args(Args* args, int argc, char** argv) {
                 print_ttf_help();
                 exit(0);
             }
+            else if (strcmp(command_arg, "batch") == 0) {
+                print_batch_help();
+                exit(0);
+            }
             else if (strcmp(command_arg, "image") == 0) {
                 print_image_help();
                 exit(0);
@@ -162,60 +476,25 @@ void parse_args(Args* args, int argc, char** argv) {
     memset(args, 0, sizeof(Args));
 
     if (strcmp(argv[1], "ttf") == 0) {
-        // Process arguments
-        if (argc < 5) {
-            fprintf(stderr, "error: too few arguments: use --help for more information\n");
+        parse_ttf_args(args, argc - 2, argv + 2);
+        if (args->channel >= 0) {
+            fprintf(stderr, "error: --channel can only be used in a batch manifest\n");
             exit(1);
         }
-        {
-            args->ppem = parse_int(argv[3], 1);
-            if (args->ppem < 0) {
-                fprintf(stderr, "error: '%s': invalid glyph size\n", argv[3]);
-                exit(1);
-            }
+    }
+    else if (strcmp(argv[1], "batch") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "error: too few arguments: use --help for more information\n");
+            exit(1);
         }
-        {
-            int values[2];
-            if (!parse_comma_separated_ints(argv[4], values, 2, 1)) {
-                fprintf(stderr, "error: '%s': invalid image size\n", argv[4]);
+        args->manifest_path = argv[2];
+        args->threads = get_num_cpus();
+
+        for (int i = 3; i < argc; i++) {
+            if (!try_get_threads(args, argv[i])) {
+                fprintf(stderr, "error: '%s': unknown option\n", argv[i]);
                 exit(1);
             }
-            args->out_image_w = values[0];
-            args->out_image_h = values[1];
-        }
-        args->ttf_path = argv[2];
-
-        // Set default values for spread and scale in case they are not given as options
-        args->spread = roundf(args->ppem / 14.0f);
-        args->scale = 5;
-
-        // Process options
-        for (int i = 5; i < argc; i++) {
-            char* arg = argv[i];
-
-            if (!try_get_spread(args, arg) && !try_get_scale(args, arg)) {
-                if (str_starts_with(arg, "--padding")) {
-                    char* value = get_option_value(arg);
-                    if (!parse_comma_separated_ints(value, args->padding, 4, 0)) {
-                        fprintf(stderr, "error: '%s': invalid value for padding\n", value);
-                        exit(1);
-                    }
-                }
-                else if (str_starts_with(arg, "--out-image")) {
-                    args->out_image_path = get_option_value(arg);
-                }
-                else if (str_starts_with(arg, "--out-font")) {
-                    args->out_font_path = get_option_value(arg);
-                }
-                else if (strcmp(arg, "--help") == 0) {
-                    fprintf(stderr, "error: --help is not valid in that context\n");
-                    exit(1);
-                }
-                else {
-                    fprintf(stderr, "error: '%s': unknown option\n", arg);
-                    exit(1);
-                }
-            }
         }
     }
     else if (strcmp(argv[1], "image") == 0) {
@@ -1,18 +1,42 @@
 #ifndef DFFONT_ARGS_H
 #define DFFONT_ARGS_H
 
+#include "image.h"
+
 typedef struct {
-    char* ttf_path;
-    char* out_image_path;
-    char* out_font_path;
-    int   padding[4]; /* left, right, top, bottom */
-    int   ppem;
-    int   out_image_w;
-    int   out_image_h;
-    int   spread;
-    int   scale;
+    char*         ttf_path;
+    char*         out_image_path;
+    char*         out_font_path;
+    char*         out_bundle_path;  /* NULL if no bundle is written */
+    char*         charset;
+    char*         manifest_path;    /* Only set by the batch command */
+    char*         cache_dir;        /* NULL if glyphs aren't cached */
+    long long     cache_size;       /* The most bytes of glyphs that are kept in cache_dir */
+    int           padding[4];       /* left, right, top, bottom */
+    int           ppem;
+    int           out_image_w;      /* The maximum page size if auto_size is set */
+    int           out_image_h;
+    int           auto_size;        /* Pick the smallest power of two size that holds the glyphs */
+    int           spread;
+    int           scale;
+    int           threads;
+    int           rotate;           /* Allow glyphs to be rotated 90 degrees when packing */
+    int           dedup_outlines;   /* Share distance fields between glyphs with identical outlines */
+    int           compress_bundle;
+    Image_Format  image_format;
+    int           png_level;
+    int           bc4;              /* Compress images with BC4 */
+    char*         bc4_report_path;  /* NULL if no BC4 error report is written */
+    int           mips;             /* Write a full mip chain for each image */
+    int           channel;          /* 0-3 for r, g, b, a if the image is shared with other outputs of a batch, otherwise -1 */
 } Args;
 
 void parse_args(Args* args, int argc, char** argv);
 
+/*
+ * Parses the arguments of the ttf command, starting with the font's path.
+ * Like `parse_args`, this exits with an error message if they're invalid.
+ */
+void parse_ttf_args(Args* args, int argc, char** argv);
+
 #endif
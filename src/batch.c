@@ -0,0 +1,646 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "batch.h"
+#include "charset.h"
+#include "df_glyph.h"
+#include "df_output.h"
+#include "thread.h"
+#include "tile_cache.h"
+#include "dedup.h"
+
+/* The number of glyphs in a task, small enough that a thread stealing the last few doesn't wait long */
+#define BATCH_CHUNK_SIZE 8
+
+/* The number of outputs each thread keeps an instance and renderer for */
+#define BATCH_NUM_CONTEXTS 4
+
+/* The most outputs that can share an image, one per channel */
+#define BATCH_MAX_SHARED_OUTPUTS 4
+
+typedef struct {
+    const char*  path;
+    TTY_Font     font;
+} Batch_Font;
+
+typedef struct {
+    Args          args;
+    char**        argv;        /* The manifest line's arguments, which args points into */
+    int           font;        /* Index into the batch's fonts */
+    TTY_Instance  instance;
+    Charset       charset;
+    TTY_Glyph*    glyphs;
+    DF_Glyph*     df_glyphs;
+    Dedup         dedup;       /* Only the unique glyphs are split into tasks */
+    Tile_Cache    tile_cache;  /* Only used if args.cache_dir is set */
+    volatile int  chunks_left; /* The thread that finishes the last chunk writes the output */
+    int           shared_image; /* The first output that shares the image (see --channel), otherwise -1 */
+    volatile int  shared_left;  /* On the first output of a shared image, the outputs that haven't been packed */
+    DF_Packed_Output packed;    /* Only used if the image is shared, until the last output is packed */
+} Batch_Output;
+
+typedef struct {
+    int output;
+    int first_glyph; /* Index into the output's unique glyphs */
+    int num_glyphs;
+} Batch_Task;
+
+/*
+ * Each thread has its own queue of tasks. The owner takes tasks from the
+ * head, and threads that run out of tasks steal from the tail. No tasks are
+ * added once the threads start, so a thread can stop as soon as every queue
+ * is empty.
+ */
+typedef struct {
+    Mutex        mutex;
+    Batch_Task*  tasks;
+    int          head;
+    int          tail;
+} Batch_Queue;
+
+/* The instance and renderer a thread uses for an output's glyphs */
+typedef struct {
+    int                output; /* -1 if the context isn't used */
+    int                last_used;
+    TTY_Instance       instance;
+    DF_Glyph_Renderer  renderer;
+} Batch_Context;
+
+typedef struct Batch Batch;
+
+typedef struct {
+    Batch*         batch;
+    int            idx;
+    Thread         thread;
+    TTY_Font*      fonts;       /* The thread's own copy of each font */
+    char*          fonts_used;  /* Whether each font has been copied */
+    Batch_Context  contexts[BATCH_NUM_CONTEXTS];
+    int            num_tasks_run;
+} Batch_Worker;
+
+struct Batch {
+    Batch_Font*    fonts;
+    int            num_fonts;
+    Batch_Output*  outputs;
+    int            num_outputs;
+    Batch_Queue*   queues;
+    Batch_Worker*  workers;
+    int            num_workers;
+};
+
+static void batch_error_exit(DF_Error error) {
+    if (error == DF_ERROR_OUT_OF_MEMORY) {
+        fprintf(stderr, "error: failed to allocate memory");
+    }
+    else {
+        fprintf(stderr, "error: an internal font error occurred");
+    }
+    exit(1);
+}
+
+static int batch_tokenize_line(char* line, char** tokens) {
+    // Splits the line in place. Tokens can be quoted so that paths can have
+    // spaces in them. If `tokens` is NULL, they are only counted.
+    int num_tokens = 0;
+    for (;;) {
+        while (*line == ' ' || *line == '\t' || *line == '\r') {
+            line++;
+        }
+        if (*line == '\0') {
+            break;
+        }
+
+        char* token = line;
+        if (*line == '"') {
+            token = ++line;
+            while (*line != '\0' && *line != '"') {
+                line++;
+            }
+        }
+        else {
+            while (*line != '\0' && *line != ' ' && *line != '\t' && *line != '\r') {
+                line++;
+            }
+        }
+
+        if (tokens != NULL) {
+            tokens[num_tokens] = token;
+            if (*line != '\0') {
+                *line++ = '\0';
+            }
+        }
+        else if (*line != '\0') {
+            line++;
+        }
+        num_tokens++;
+    }
+    return num_tokens;
+}
+
+static char* batch_read_manifest(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "error: '%s': failed to open manifest\n", path);
+        exit(1);
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char* data = malloc(size + 1);
+    if (data == NULL) {
+        batch_error_exit(DF_ERROR_OUT_OF_MEMORY);
+    }
+    if (size < 0 || fread(data, 1, size, file) != (size_t)size) {
+        fprintf(stderr, "error: '%s': failed to read manifest\n", path);
+        exit(1);
+    }
+    data[size] = '\0';
+
+    fclose(file);
+    return data;
+}
+
+static void batch_add_shared_image(Batch* batch, Batch_Output* output, const char* path, int line_num) {
+    // Finds the earlier outputs with the same image path. The outputs that
+    // share an image can't be told apart from one that overwrites another's
+    // image, so every one of them needs a channel.
+    const Args* args = &output->args;
+
+    output->shared_image = -1;
+    for (int i = 0; i < batch->num_outputs; i++) {
+        const Args* other = &batch->outputs[i].args;
+        if (args->out_image_path == NULL || other->out_image_path == NULL ||
+            strcmp(args->out_image_path, other->out_image_path) != 0 || (args->channel < 0 && other->channel < 0))
+        {
+            continue;
+        }
+
+        if (args->channel < 0 || other->channel < 0) {
+            fprintf(stderr, "error: '%s': line %d: every output that shares '%s' needs a --channel\n",
+                    path, line_num, args->out_image_path);
+            exit(1);
+        }
+        if (args->channel == other->channel) {
+            fprintf(stderr, "error: '%s': line %d: channel %c of '%s' is already used\n",
+                    path, line_num, "rgba"[args->channel], args->out_image_path);
+            exit(1);
+        }
+        if (args->out_image_w != other->out_image_w || args->out_image_h != other->out_image_h ||
+            args->auto_size != other->auto_size || args->image_format != other->image_format ||
+            args->png_level != other->png_level || args->mips != other->mips)
+        {
+            fprintf(stderr, "error: '%s': line %d: outputs that share '%s' must have the same image size, image "
+                    "format, PNG level, and --mips\n", path, line_num, args->out_image_path);
+            exit(1);
+        }
+
+        if (output->shared_image < 0) {
+            output->shared_image = i;
+        }
+    }
+
+    if (args->channel < 0) {
+        return;
+    }
+    if (output->shared_image < 0) {
+        output->shared_image = batch->num_outputs;
+    }
+    batch->outputs[output->shared_image].shared_left++;
+}
+
+static void batch_parse_manifest(Batch* batch, const char* path, char* data) {
+    // Lines are counted first so the outputs can be allocated at once
+    int max_outputs = 1;
+    for (char* c = data; *c != '\0'; c++) {
+        max_outputs += *c == '\n';
+    }
+
+    batch->outputs = calloc(max_outputs, sizeof(Batch_Output));
+    if (batch->outputs == NULL) {
+        batch_error_exit(DF_ERROR_OUT_OF_MEMORY);
+    }
+
+    char* line     = data;
+    int   line_num = 1;
+    for (; line != NULL; line_num++) {
+        char* next = strchr(line, '\n');
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+
+        char* start = line + strspn(line, " \t\r");
+        line = next;
+        if (*start == '\0' || *start == '#') {
+            continue;
+        }
+
+        Batch_Output* output = batch->outputs + batch->num_outputs;
+
+        int argc = batch_tokenize_line(start, NULL);
+        output->argv = malloc(argc * sizeof(char*));
+        if (output->argv == NULL) {
+            batch_error_exit(DF_ERROR_OUT_OF_MEMORY);
+        }
+        batch_tokenize_line(start, output->argv);
+
+        parse_ttf_args(&output->args, argc, output->argv);
+
+        // Outputs are finished while the batch's workers are still running,
+        // so their images are encoded on the finishing thread only. Otherwise
+        // every output would start its own threads on top of the workers.
+        output->args.threads = 1;
+
+        // The default paths would be shared by every output
+        if ((output->args.out_image_path == NULL || output->args.out_font_path == NULL) && output->args.out_bundle_path == NULL) {
+            fprintf(stderr, "error: '%s': line %d: --out-image and --out-font, or --out-bundle, are required\n", path, line_num);
+            exit(1);
+        }
+        batch_add_shared_image(batch, output, path, line_num);
+
+        batch->num_outputs++;
+    }
+}
+
+static void batch_load_fonts(Batch* batch) {
+    // Outputs that use the same font share it, so each file is only loaded
+    // once
+    batch->fonts = calloc(batch->num_outputs > 0 ? batch->num_outputs : 1, sizeof(Batch_Font));
+    if (batch->fonts == NULL) {
+        batch_error_exit(DF_ERROR_OUT_OF_MEMORY);
+    }
+
+    for (int i = 0; i < batch->num_outputs; i++) {
+        Batch_Output* output = batch->outputs + i;
+
+        int font = 0;
+        while (font < batch->num_fonts && strcmp(batch->fonts[font].path, output->args.ttf_path) != 0) {
+            font++;
+        }
+
+        if (font == batch->num_fonts) {
+            Batch_Font* batch_font = batch->fonts + batch->num_fonts;
+            batch_font->path = output->args.ttf_path;
+
+            if (tty_font_init_mapped(&batch_font->font, batch_font->path)) {
+                fprintf(stderr, "error: '%s': Failed to load\n", batch_font->path);
+                exit(1);
+            }
+            if (tty_font_init_glyph_index_map(&batch_font->font)) {
+                batch_error_exit(DF_ERROR_OUT_OF_MEMORY);
+            }
+
+            batch->num_fonts++;
+        }
+
+        output->font = font;
+    }
+}
+
+static void batch_init_output(Batch* batch, Batch_Output* output) {
+    TTY_Font* font = &batch->fonts[output->font].font;
+    Args*     args = &output->args;
+
+    if (tty_instance_init(font, &output->instance, args->ppem * args->scale, TTY_INSTANCE_NO_HINTING | TTY_INSTANCE_BINARY)) {
+        batch_error_exit(DF_ERROR_FONT);
+    }
+
+    charset_init(&output->charset, args->charset, font);
+
+    int count = output->charset.count;
+    output->glyphs    = malloc((count > 0 ? count : 1) * sizeof(TTY_Glyph));
+    output->df_glyphs = calloc(count > 0 ? count : 1, sizeof(DF_Glyph));
+    if (output->glyphs == NULL || output->df_glyphs == NULL) {
+        batch_error_exit(DF_ERROR_OUT_OF_MEMORY);
+    }
+
+    if (tty_glyphs_init(font, output->charset.glyph_indices, count, output->glyphs)) {
+        batch_error_exit(DF_ERROR_FONT);
+    }
+
+    DF_Error error;
+    if ((error = dedup_init(&output->dedup, font, output->glyphs, count, args->dedup_outlines))) {
+        batch_error_exit(error);
+    }
+
+    if (args->cache_dir != NULL && tile_cache_init(&output->tile_cache, args->cache_dir, font, args->ppem, args->scale, args->spread)) {
+        fprintf(stderr, "error: '%s': failed to create cache directory\n", args->cache_dir);
+        exit(1);
+    }
+
+    output->chunks_left = (output->dedup.num_unique + BATCH_CHUNK_SIZE - 1) / BATCH_CHUNK_SIZE;
+}
+
+static void batch_finish_output(Batch* batch, Batch_Output* output, TTY_Font* font, TTY_Instance* instance) {
+    // `font` and `instance` must belong to the calling thread, since the
+    // duplicates' metrics are loaded with them
+    DF_Error error;
+    if ((error = dedup_fill(&output->dedup, font, instance, output->glyphs, output->charset.count, output->df_glyphs))) {
+        batch_error_exit(error);
+    }
+
+    if (output->shared_image < 0) {
+        if ((error = df_write_output(&output->args, &output->charset, &output->instance, output->df_glyphs, output->dedup.sources))) {
+            df_output_error_exit(&output->args, error);
+        }
+        df_glyphs_free(output->df_glyphs, output->charset.count);
+        return;
+    }
+
+    // Outputs that share an image are packed as they finish, and the last one
+    // writes all of them
+    if ((error = df_pack_output(&output->args, &output->charset, &output->instance, output->df_glyphs,
+                                output->dedup.sources, &output->packed)))
+    {
+        df_output_error_exit(&output->args, error);
+    }
+    if (atomic_add_int(&batch->outputs[output->shared_image].shared_left, -1) != 1) {
+        return;
+    }
+
+    DF_Packed_Output packed[BATCH_MAX_SHARED_OUTPUTS];
+    int              num_packed = 0;
+    for (int i = output->shared_image; i < batch->num_outputs; i++) {
+        if (batch->outputs[i].shared_image == output->shared_image) {
+            packed[num_packed++] = batch->outputs[i].packed;
+        }
+    }
+    if ((error = df_write_shared_outputs(packed, num_packed))) {
+        df_output_error_exit(&output->args, error);
+    }
+
+    for (int i = output->shared_image; i < batch->num_outputs; i++) {
+        Batch_Output* shared = batch->outputs + i;
+        if (shared->shared_image == output->shared_image) {
+            df_packed_output_free(&shared->packed);
+            df_glyphs_free(shared->df_glyphs, shared->charset.count);
+        }
+    }
+}
+
+static void batch_init_queues(Batch* batch) {
+    // Each output's chunks are split into one contiguous run per thread, so
+    // every thread starts on the same output and they move through the
+    // outputs together. A thread that finishes early steals from the end of
+    // another thread's queue.
+    int num_workers = batch->num_workers;
+
+    batch->queues = calloc(num_workers, sizeof(Batch_Queue));
+    if (batch->queues == NULL) {
+        batch_error_exit(DF_ERROR_OUT_OF_MEMORY);
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < batch->num_outputs; i++) {
+            Batch_Output* output     = batch->outputs + i;
+            int           num_chunks = output->chunks_left;
+
+            for (int chunk = 0; chunk < num_chunks; chunk++) {
+                Batch_Queue* queue = batch->queues + (int)((long long)chunk * num_workers / num_chunks);
+
+                if (pass == 1) {
+                    Batch_Task* task  = queue->tasks + queue->tail;
+                    task->output      = i;
+                    task->first_glyph = chunk * BATCH_CHUNK_SIZE;
+                    task->num_glyphs  = output->dedup.num_unique - task->first_glyph;
+                    if (task->num_glyphs > BATCH_CHUNK_SIZE) {
+                        task->num_glyphs = BATCH_CHUNK_SIZE;
+                    }
+                }
+                queue->tail++;
+            }
+        }
+
+        if (pass == 0) {
+            for (int i = 0; i < num_workers; i++) {
+                Batch_Queue* queue = batch->queues + i;
+                queue->tasks = malloc((queue->tail > 0 ? queue->tail : 1) * sizeof(Batch_Task));
+                queue->tail  = 0;
+                if (queue->tasks == NULL || !mutex_init(&queue->mutex)) {
+                    batch_error_exit(DF_ERROR_OUT_OF_MEMORY);
+                }
+            }
+        }
+    }
+}
+
+static int batch_pop_task(Batch* batch, int worker_idx, Batch_Task* task) {
+    for (int i = 0; i < batch->num_workers; i++) {
+        int          own   = i == 0;
+        Batch_Queue* queue = batch->queues + (worker_idx + i) % batch->num_workers;
+
+        mutex_lock(&queue->mutex);
+        int found = queue->head < queue->tail;
+        if (found) {
+            *task = own ? queue->tasks[queue->head++] : queue->tasks[--queue->tail];
+        }
+        mutex_unlock(&queue->mutex);
+
+        if (found) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static TTY_Font* batch_get_worker_font(Batch_Worker* worker, int font) {
+    if (!worker->fonts_used[font]) {
+        TTY_Font* shared = &worker->batch->fonts[font].font;
+        if (tty_font_init_from_memory(worker->fonts + font, shared->fileData, shared->fileSize)) {
+            batch_error_exit(DF_ERROR_FONT);
+        }
+        worker->fonts_used[font] = 1;
+    }
+    return worker->fonts + font;
+}
+
+static Batch_Context* batch_get_context(Batch_Worker* worker, int output_idx) {
+    Batch_Context* context = NULL;
+
+    for (int i = 0; i < BATCH_NUM_CONTEXTS; i++) {
+        if (worker->contexts[i].output == output_idx) {
+            context = worker->contexts + i;
+            break;
+        }
+    }
+
+    if (context == NULL) {
+        // Replace the least recently used context
+        context = worker->contexts;
+        for (int i = 1; i < BATCH_NUM_CONTEXTS; i++) {
+            if (worker->contexts[i].last_used < context->last_used) {
+                context = worker->contexts + i;
+            }
+        }
+
+        if (context->output >= 0) {
+            df_glyph_renderer_free(&context->renderer);
+            tty_instance_free(&context->instance);
+        }
+
+        Batch_Output* output = worker->batch->outputs + output_idx;
+        Args*         args   = &output->args;
+        TTY_Font*     font   = batch_get_worker_font(worker, output->font);
+
+        context->output = -1;
+        if (tty_instance_init(font, &context->instance, args->ppem * args->scale, TTY_INSTANCE_NO_HINTING | TTY_INSTANCE_BINARY)) {
+            batch_error_exit(DF_ERROR_FONT);
+        }
+
+        DF_Error error;
+        if ((error = df_glyph_renderer_init(&context->renderer, &context->instance, args->scale, args->spread))) {
+            batch_error_exit(error);
+        }
+        context->output = output_idx;
+    }
+
+    context->last_used = worker->num_tasks_run;
+    return context;
+}
+
+static void batch_run_worker(Batch_Worker* worker) {
+    Batch*     batch = worker->batch;
+    Batch_Task task;
+
+    while (batch_pop_task(batch, worker->idx, &task)) {
+        Batch_Output*  output  = batch->outputs + task.output;
+        Batch_Context* context = batch_get_context(worker, task.output);
+        TTY_Font*      font    = batch_get_worker_font(worker, output->font);
+        Tile_Cache*    cache   = output->args.cache_dir != NULL ? &output->tile_cache : NULL;
+
+        for (int i = task.first_glyph; i < task.first_glyph + task.num_glyphs; i++) {
+            int       glyph  = output->dedup.unique[i];
+            DF_Glyph* result = output->df_glyphs + glyph;
+            result->glyph = output->glyphs[glyph];
+
+            DF_Error error;
+            if ((error = df_generate_glyph(&context->renderer, font, &context->instance, cache, result))) {
+                batch_error_exit(error);
+            }
+        }
+
+        worker->num_tasks_run++;
+
+        // Packing and writing are done by whichever thread finishes the
+        // output, while the others keep generating glyphs
+        if (atomic_add_int(&output->chunks_left, -1) == 1) {
+            batch_finish_output(batch, output, font, &context->instance);
+        }
+    }
+}
+
+static void batch_worker_main(void* arg) {
+    batch_run_worker((Batch_Worker*)arg);
+}
+
+void run_batch(const Args* args) {
+    Batch batch = {0};
+
+    char* manifest = batch_read_manifest(args->manifest_path);
+    batch_parse_manifest(&batch, args->manifest_path, manifest);
+    batch_load_fonts(&batch);
+
+    int num_chunks = 0;
+    for (int i = 0; i < batch.num_outputs; i++) {
+        Batch_Output* output = batch.outputs + i;
+        batch_init_output(&batch, output);
+
+        // Outputs without glyphs don't have any tasks to finish them
+        if (output->chunks_left == 0) {
+            batch_finish_output(&batch, output, &batch.fonts[output->font].font, &output->instance);
+        }
+        num_chunks += output->chunks_left;
+    }
+
+    // There's no point in having more threads than tasks
+    batch.num_workers = args->threads < num_chunks ? args->threads : num_chunks;
+    if (batch.num_workers < 1) {
+        batch.num_workers = 1;
+    }
+
+    batch.workers = calloc(batch.num_workers, sizeof(Batch_Worker));
+    if (batch.workers == NULL) {
+        batch_error_exit(DF_ERROR_OUT_OF_MEMORY);
+    }
+
+    for (int i = 0; i < batch.num_workers; i++) {
+        Batch_Worker* worker = batch.workers + i;
+        worker->batch      = &batch;
+        worker->idx        = i;
+        worker->fonts      = calloc(batch.num_fonts > 0 ? batch.num_fonts : 1, sizeof(TTY_Font));
+        worker->fonts_used = calloc(batch.num_fonts > 0 ? batch.num_fonts : 1, 1);
+        if (worker->fonts == NULL || worker->fonts_used == NULL) {
+            batch_error_exit(DF_ERROR_OUT_OF_MEMORY);
+        }
+        for (int j = 0; j < BATCH_NUM_CONTEXTS; j++) {
+            worker->contexts[j].output = -1;
+        }
+    }
+
+    batch_init_queues(&batch);
+
+    // The calling thread is the first worker. If a thread can't be created,
+    // its tasks are stolen by the others.
+    int num_started = 1;
+    for (; num_started < batch.num_workers; num_started++) {
+        Batch_Worker* worker = batch.workers + num_started;
+        if (!thread_create(&worker->thread, batch_worker_main, worker)) {
+            break;
+        }
+    }
+
+    batch_run_worker(batch.workers);
+
+    for (int i = 1; i < num_started; i++) {
+        thread_join(&batch.workers[i].thread);
+    }
+
+    for (int i = 0; i < batch.num_workers; i++) {
+        Batch_Worker* worker = batch.workers + i;
+        for (int j = 0; j < BATCH_NUM_CONTEXTS; j++) {
+            if (worker->contexts[j].output >= 0) {
+                df_glyph_renderer_free(&worker->contexts[j].renderer);
+                tty_instance_free(&worker->contexts[j].instance);
+            }
+        }
+        for (int j = 0; j < batch.num_fonts; j++) {
+            if (worker->fonts_used[j]) {
+                tty_font_free(worker->fonts + j);
+            }
+        }
+        free(worker->fonts);
+        free(worker->fonts_used);
+        mutex_free(&batch.queues[i].mutex);
+        free(batch.queues[i].tasks);
+    }
+
+    // Outputs can share a cache directory, in which case it's already within
+    // the size limit after the first one
+    for (int i = 0; i < batch.num_outputs; i++) {
+        Args* output_args = &batch.outputs[i].args;
+        if (output_args->cache_dir != NULL) {
+            tile_cache_evict(output_args->cache_dir, output_args->cache_size);
+        }
+    }
+
+    for (int i = 0; i < batch.num_outputs; i++) {
+        Batch_Output* output = batch.outputs + i;
+        charset_free(&output->charset);
+        tty_instance_free(&output->instance);
+        free(output->glyphs);
+        free(output->df_glyphs);
+        free(output->argv);
+        dedup_free(&output->dedup);
+    }
+
+    for (int i = 0; i < batch.num_fonts; i++) {
+        tty_font_free(&batch.fonts[i].font);
+    }
+
+    free(batch.workers);
+    free(batch.queues);
+    free(batch.outputs);
+    free(batch.fonts);
+    free(manifest);
+}
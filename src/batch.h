@@ -0,0 +1,12 @@
+#ifndef DFFONT_BATCH_H
+#define DFFONT_BATCH_H
+
+#include "args.h"
+
+/*
+ * Generates every output listed in the manifest at `args->manifest_path`
+ * using `args->threads` threads. Exits with an error message on failure.
+ */
+void run_batch(const Args* args);
+
+#endif
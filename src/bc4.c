@@ -0,0 +1,274 @@
+#include <stdlib.h>
+#include <string.h>
+#include "bc4.h"
+#include "thread.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define BC4_SSE2
+    #include <emmintrin.h>
+#endif
+
+typedef struct {
+    const uint8_t* pixels;
+    uint8_t*       blocks;
+    int            w;
+    int            h;
+    int            num_rows;
+    volatile int   next_row;
+} BC4_Job;
+
+typedef struct {
+    BC4_Job* job;
+    Thread   thread;
+} BC4_Worker;
+
+size_t bc4_get_size(int w, int h) {
+    return (size_t)((w + 3) / 4) * ((h + 3) / 4) * BC4_BLOCK_SIZE;
+}
+
+static void bc4_get_palette(int r0, int r1, uint8_t* palette) {
+    // r0 > r1 interpolates six values between the endpoints, otherwise four
+    // values are interpolated and the last two are 0 and 255
+    palette[0] = r0;
+    palette[1] = r1;
+    if (r0 > r1) {
+        for (int i = 1; i < 7; i++) {
+            palette[i + 1] = ((7 - i) * r0 + i * r1 + 3) / 7;
+        }
+    }
+    else {
+        for (int i = 1; i < 5; i++) {
+            palette[i + 1] = ((5 - i) * r0 + i * r1 + 2) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+#ifdef BC4_SSE2
+static int bc4_hmin(__m128i v) {
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 8));
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 4));
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 2));
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 1));
+    return _mm_cvtsi128_si32(v) & 0xff;
+}
+
+static int bc4_hmax(__m128i v) {
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 8));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 4));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 2));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 1));
+    return _mm_cvtsi128_si32(v) & 0xff;
+}
+#endif
+
+static void bc4_get_range(const uint8_t* block, int* min, int* max, int* inner_min, int* inner_max) {
+    // The inner range ignores 0 and 255, which the second mode has in its
+    // palette. If every pixel is 0 or 255, the inner min is greater than the
+    // inner max.
+#ifdef BC4_SSE2
+    __m128i pixels = _mm_loadu_si128((const __m128i*)block);
+    __m128i zeros  = _mm_cmpeq_epi8(pixels, _mm_setzero_si128());
+    __m128i ones   = _mm_cmpeq_epi8(pixels, _mm_set1_epi8(-1));
+    *min       = bc4_hmin(pixels);
+    *max       = bc4_hmax(pixels);
+    *inner_min = bc4_hmin(_mm_or_si128(pixels, zeros));
+    *inner_max = bc4_hmax(_mm_andnot_si128(ones, pixels));
+#else
+    *min       = 255;
+    *max       = 0;
+    *inner_min = 255;
+    *inner_max = 0;
+    for (int i = 0; i < 16; i++) {
+        int p = block[i];
+        *min = p < *min ? p : *min;
+        *max = p > *max ? p : *max;
+        if (p != 0 && p != 255) {
+            *inner_min = p < *inner_min ? p : *inner_min;
+            *inner_max = p > *inner_max ? p : *inner_max;
+        }
+    }
+#endif
+}
+
+static int bc4_select_indices(const uint8_t* block, const uint8_t* palette, uint8_t* indices) {
+    // Picks the closest palette entry for each pixel, the first one on a tie,
+    // and returns the sum of the absolute errors
+#ifdef BC4_SSE2
+    __m128i pixels   = _mm_loadu_si128((const __m128i*)block);
+    __m128i best     = _mm_set1_epi8(-1);
+    __m128i best_idx = _mm_setzero_si128();
+    for (int i = 0; i < 8; i++) {
+        __m128i value = _mm_set1_epi8((char)palette[i]);
+        __m128i dist  = _mm_or_si128(_mm_subs_epu8(pixels, value), _mm_subs_epu8(value, pixels));
+        __m128i keep  = _mm_cmpeq_epi8(_mm_min_epu8(dist, best), best);
+        best     = _mm_min_epu8(dist, best);
+        best_idx = _mm_or_si128(_mm_and_si128(keep, best_idx), _mm_andnot_si128(keep, _mm_set1_epi8((char)i)));
+    }
+    _mm_storeu_si128((__m128i*)indices, best_idx);
+
+    __m128i sum = _mm_sad_epu8(best, _mm_setzero_si128());
+    return _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+#else
+    int error = 0;
+    for (int i = 0; i < 16; i++) {
+        int best     = 255;
+        int best_idx = 0;
+        for (int j = 0; j < 8; j++) {
+            int dist = abs(block[i] - palette[j]);
+            if (dist < best) {
+                best     = dist;
+                best_idx = j;
+            }
+        }
+        indices[i] = best_idx;
+        error += best;
+    }
+    return error;
+#endif
+}
+
+static void bc4_compress_block(const uint8_t* block, uint8_t* out) {
+    // Both modes are tried and the one with the smaller error is kept. Most
+    // blocks are gradients that the six interpolated values fit best, but
+    // blocks on the edge of the spread mix a gradient with 0s, which the
+    // second mode's palette has without spending the range on them.
+    int min, max, inner_min, inner_max;
+    bc4_get_range(block, &min, &max, &inner_min, &inner_max);
+
+    uint8_t palette[8];
+    uint8_t indices[16];
+    int     r0 = max;
+    int     r1 = min;
+    bc4_get_palette(r0, r1, palette);
+    int error = bc4_select_indices(block, palette, indices);
+
+    if (error > 0 && (min == 0 || max == 255)) {
+        uint8_t other_indices[16];
+        int     other_r0 = inner_min <= inner_max ? inner_min : 0;
+        int     other_r1 = inner_min <= inner_max ? inner_max : 0;
+        bc4_get_palette(other_r0, other_r1, palette);
+
+        int other_error = bc4_select_indices(block, palette, other_indices);
+        if (other_error < error) {
+            r0 = other_r0;
+            r1 = other_r1;
+            memcpy(indices, other_indices, 16);
+        }
+    }
+
+    // The indices are packed 3 bits each, the first pixel in the lowest bits
+    uint64_t bits = 0;
+    for (int i = 15; i >= 0; i--) {
+        bits = (bits << 3) | indices[i];
+    }
+    out[0] = r0;
+    out[1] = r1;
+    for (int i = 0; i < 6; i++) {
+        out[i + 2] = (uint8_t)(bits >> (8 * i));
+    }
+}
+
+static void bc4_compress_row(const BC4_Job* job, int row) {
+    int      blocks_w = (job->w + 3) / 4;
+    uint8_t* out      = job->blocks + (size_t)row * blocks_w * BC4_BLOCK_SIZE;
+
+    for (int bx = 0; bx < blocks_w; bx++) {
+        uint8_t block[16];
+        for (int y = 0; y < 4; y++) {
+            int py = row * 4 + y < job->h ? row * 4 + y : job->h - 1;
+            for (int x = 0; x < 4; x++) {
+                int px = bx * 4 + x < job->w ? bx * 4 + x : job->w - 1;
+                block[y * 4 + x] = job->pixels[(size_t)py * job->w + px];
+            }
+        }
+        bc4_compress_block(block, out + bx * BC4_BLOCK_SIZE);
+    }
+}
+
+static void bc4_run_job(BC4_Job* job) {
+    for (;;) {
+        int row = atomic_add_int(&job->next_row, 1);
+        if (row >= job->num_rows) {
+            break;
+        }
+        bc4_compress_row(job, row);
+    }
+}
+
+static void bc4_worker_main(void* arg) {
+    bc4_run_job(((BC4_Worker*)arg)->job);
+}
+
+uint8_t* bc4_compress(const uint8_t* pixels, int w, int h, int num_threads) {
+    BC4_Job job = {
+        .pixels   = pixels,
+        .blocks   = malloc(bc4_get_size(w, h) > 0 ? bc4_get_size(w, h) : 1),
+        .w        = w,
+        .h        = h,
+        .num_rows = (h + 3) / 4,
+    };
+    if (job.blocks == NULL) {
+        return NULL;
+    }
+
+    // There's no point in having more threads than rows of blocks
+    int num_workers = (num_threads < job.num_rows ? num_threads : job.num_rows) - 1;
+    if (num_workers < 0) {
+        num_workers = 0;
+    }
+
+    BC4_Worker* workers = NULL;
+    if (num_workers > 0) {
+        workers = calloc(num_workers, sizeof(BC4_Worker));
+        if (workers == NULL) {
+            num_workers = 0;
+        }
+    }
+
+    int num_started = 0;
+    for (; num_started < num_workers; num_started++) {
+        workers[num_started].job = &job;
+        if (!thread_create(&workers[num_started].thread, bc4_worker_main, workers + num_started)) {
+            // The rows are still compressed, just with fewer threads
+            break;
+        }
+    }
+
+    bc4_run_job(&job);
+
+    for (int i = 0; i < num_started; i++) {
+        thread_join(&workers[i].thread);
+    }
+    free(workers);
+
+    return job.blocks;
+}
+
+void bc4_decompress(const uint8_t* blocks, int w, int h, uint8_t* pixels) {
+    int blocks_w = (w + 3) / 4;
+    int blocks_h = (h + 3) / 4;
+
+    for (int by = 0; by < blocks_h; by++) {
+        for (int bx = 0; bx < blocks_w; bx++) {
+            const uint8_t* block = blocks + ((size_t)by * blocks_w + bx) * BC4_BLOCK_SIZE;
+
+            uint8_t palette[8];
+            bc4_get_palette(block[0], block[1], palette);
+
+            uint64_t bits = 0;
+            for (int i = 5; i >= 0; i--) {
+                bits = (bits << 8) | block[i + 2];
+            }
+
+            for (int i = 0; i < 16; i++) {
+                int x = bx * 4 + i % 4;
+                int y = by * 4 + i / 4;
+                if (x < w && y < h) {
+                    pixels[(size_t)y * w + x] = palette[(bits >> (3 * i)) & 7];
+                }
+            }
+        }
+    }
+}
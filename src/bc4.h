@@ -0,0 +1,25 @@
+#ifndef DFFONT_BC4_H
+#define DFFONT_BC4_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Each 4x4 block of pixels is stored in 8 bytes */
+#define BC4_BLOCK_SIZE 8
+
+/* Returns the number of bytes of blocks in a w x h image */
+size_t bc4_get_size(int w, int h);
+
+/*
+ * Compresses a one channel, 8-bit image into BC4 blocks, row by row, using
+ * `num_threads` threads, one of which is the calling thread. Blocks that go
+ * past the right or bottom edge repeat the edge pixels. The blocks don't
+ * depend on the number of threads. Returns NULL if memory could not be
+ * allocated, otherwise the blocks must be freed with `free`.
+ */
+uint8_t* bc4_compress(const uint8_t* pixels, int w, int h, int num_threads);
+
+/* Decompresses the blocks of a w x h image into `pixels` */
+void bc4_decompress(const uint8_t* blocks, int w, int h, uint8_t* pixels);
+
+#endif
@@ -0,0 +1,227 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "charset.h"
+
+#define MAX_CODE_POINT  0x10FFFF
+#define NUM_BITSET_WORDS ((MAX_CODE_POINT + 1) / 32)
+
+static void out_of_memory(void) {
+    fprintf(stderr, "error: failed to allocate memory\n");
+    exit(1);
+}
+
+static void set_bit(uint32_t* bits, uint32_t cp) {
+    bits[cp >> 5] |= 1u << (cp & 31);
+}
+
+static int is_control(uint32_t cp) {
+    // C0 controls, DEL, and C1 controls, such as line breaks, don't have
+    // glyphs even if a font maps them
+    return cp < 0x20 || (cp >= 0x7F && cp <= 0x9F);
+}
+
+static int parse_code_point(const char* input, const char** next, uint32_t* cp) {
+    int base = 10;
+    if (strncmp(input, "0x", 2) == 0 || strncmp(input, "0X", 2) == 0 || 
+        strncmp(input, "U+", 2) == 0 || strncmp(input, "u+", 2) == 0) 
+    {
+        input += 2;
+        base = 16;
+    }
+
+    if ((base == 10 && (*input < '0' || *input > '9')) || (base == 16 && strchr("0123456789abcdefABCDEF", *input) == NULL) || *input == '\0') {
+        return 0;
+    }
+
+    char* end;
+    errno = 0;
+    unsigned long value = strtoul(input, &end, base);
+    if (errno != 0 || value > MAX_CODE_POINT) {
+        return 0;
+    }
+
+    *cp   = (uint32_t)value;
+    *next = end;
+    return 1;
+}
+
+static void add_range(uint32_t* bits, const char* item, const char* item_end) {
+    uint32_t first, last;
+    const char* next;
+
+    if (!parse_code_point(item, &next, &first)) {
+        goto invalid;
+    }
+    last = first;
+
+    if (next != item_end) {
+        if (*next != '-' || !parse_code_point(next + 1, &next, &last) || next != item_end || last < first) {
+            goto invalid;
+        }
+    }
+
+    for (uint32_t cp = first; cp <= last; cp++) {
+        set_bit(bits, cp);
+    }
+    return;
+
+invalid:
+    fprintf(stderr, "error: '%.*s': invalid code point or range in charset\n", (int)(item_end - item), item);
+    exit(1);
+}
+
+static void add_file(uint32_t* bits, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "error: '%s': failed to open charset file\n", path);
+        exit(1);
+    }
+
+    // Decodes UTF-8 a byte at a time, invalid sequences are skipped
+    uint32_t cp        = 0;
+    int      remaining = 0;
+    int      c;
+    while ((c = fgetc(file)) != EOF) {
+        if (remaining > 0 && (c & 0xC0) == 0x80) {
+            cp = (cp << 6) | (c & 0x3F);
+            if (--remaining > 0) {
+                continue;
+            }
+        }
+        else if (c < 0x80) {
+            cp = c;
+            remaining = 0;
+        }
+        else if ((c & 0xE0) == 0xC0) {
+            cp = c & 0x1F;
+            remaining = 1;
+            continue;
+        }
+        else if ((c & 0xF0) == 0xE0) {
+            cp = c & 0x0F;
+            remaining = 2;
+            continue;
+        }
+        else if ((c & 0xF8) == 0xF0) {
+            cp = c & 0x07;
+            remaining = 3;
+            continue;
+        }
+        else {
+            remaining = 0;
+            continue;
+        }
+
+        if (!is_control(cp) && cp <= MAX_CODE_POINT) {
+            set_bit(bits, cp);
+        }
+    }
+
+    fclose(file);
+}
+
+static void add_all(uint32_t* bits, TTY_Font* font) {
+    // Note: The font's glyph index map makes each lookup O(1)
+    for (uint32_t cp = 0; cp <= MAX_CODE_POINT; cp++) {
+        TTY_U32 idx;
+        if (!is_control(cp) && tty_get_glyph_index(font, cp, &idx) == TTY_ERROR_NONE && idx != 0) {
+            set_bit(bits, cp);
+        }
+    }
+}
+
+void charset_init(Charset* charset, const char* value, TTY_Font* font) {
+    memset(charset, 0, sizeof(Charset));
+
+    // A bitset removes duplicates and sorts the code points without comparing
+    // them to each other
+    uint32_t* bits = calloc(NUM_BITSET_WORDS, sizeof(uint32_t));
+    if (bits == NULL) {
+        out_of_memory();
+    }
+
+    for (const char* item = value; ; ) {
+        const char* item_end = strchr(item, ',');
+        if (item_end == NULL) {
+            item_end = item + strlen(item);
+        }
+
+        if (item_end - item == 3 && strncmp(item, "all", 3) == 0) {
+            add_all(bits, font);
+        }
+        else if (*item == '@') {
+            char* path = malloc(item_end - item);
+            if (path == NULL) {
+                out_of_memory();
+            }
+            memcpy(path, item + 1, item_end - item - 1);
+            path[item_end - item - 1] = '\0';
+            add_file(bits, path);
+            free(path);
+        }
+        else {
+            add_range(bits, item, item_end);
+        }
+
+        if (*item_end == '\0') {
+            break;
+        }
+        item = item_end + 1;
+    }
+
+    int num_code_points = 0;
+    for (int i = 0; i < NUM_BITSET_WORDS; i++) {
+        for (uint32_t word = bits[i]; word != 0; word &= word - 1) {
+            num_code_points++;
+        }
+    }
+
+    charset->code_points   = malloc((num_code_points > 0 ? num_code_points : 1) * sizeof(uint32_t));
+    charset->glyph_indices = malloc((num_code_points > 0 ? num_code_points : 1) * sizeof(uint32_t));
+    if (charset->code_points == NULL || charset->glyph_indices == NULL) {
+        out_of_memory();
+    }
+
+    for (int i = 0; i < NUM_BITSET_WORDS; i++) {
+        for (uint32_t word = bits[i]; word != 0; word &= word - 1) {
+            int bit = 0;
+            while (!((word >> bit) & 1)) {
+                bit++;
+            }
+            charset->code_points[charset->count++] = i * 32 + bit;
+        }
+    }
+
+    free(bits);
+
+    if (tty_get_glyph_indices(font, charset->code_points, charset->count, charset->glyph_indices)) {
+        fprintf(stderr, "error: an internal font error occurred\n");
+        exit(1);
+    }
+
+    // Remove the code points that the font doesn't have
+    int num_missing = 0;
+    for (int i = 0; i < charset->count; i++) {
+        if (charset->glyph_indices[i] == 0) {
+            num_missing++;
+            continue;
+        }
+        charset->code_points[i - num_missing]   = charset->code_points[i];
+        charset->glyph_indices[i - num_missing] = charset->glyph_indices[i];
+    }
+    charset->count -= num_missing;
+
+    if (num_missing > 0) {
+        fprintf(stderr, "warning: %d code points in the charset are not in the font\n", num_missing);
+    }
+}
+
+void charset_free(Charset* charset) {
+    free(charset->code_points);
+    free(charset->glyph_indices);
+    charset->code_points   = NULL;
+    charset->glyph_indices = NULL;
+    charset->count         = 0;
+}
@@ -0,0 +1,28 @@
+#ifndef DFFONT_CHARSET_H
+#define DFFONT_CHARSET_H
+
+#include <stdint.h>
+#include "truety.h"
+
+typedef struct {
+    uint32_t* code_points; /* Sorted in ascending order without duplicates */
+    uint32_t* glyph_indices;
+    int       count;
+} Charset;
+
+/*
+ * Creates the set of code points described by `value`, a comma separated list
+ * of items that can be:
+ *     <code point>              A decimal or hex (0x4E00 or U+4E00) code point
+ *     <code point>-<code point> An inclusive range of code points
+ *     @<path>                   Every character in a UTF-8 text file
+ *     all                       Every code point that the font maps to a glyph
+ *
+ * Code points that the font doesn't have a glyph for are left out. Exits with 
+ * an error message if `value` is invalid.
+ */
+void charset_init(Charset* charset, const char* value, TTY_Font* font);
+
+void charset_free(Charset* charset);
+
+#endif
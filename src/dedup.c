@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include <string.h>
+#include "dedup.h"
+#include "hash.h"
+
+/*
+ * An open addressing table that maps a key to the first glyph that had it.
+ * The table is at least twice as large as the number of glyphs, so probing
+ * always finds an empty slot.
+ */
+typedef struct {
+    uint64_t* keys;
+    int*      glyphs; /* -1 if the slot is empty */
+    int       mask;
+} Dedup_Table;
+
+static int dedup_table_init(Dedup_Table* table, int num_glyphs) {
+    int size = 16;
+    while (size < num_glyphs * 2) {
+        size *= 2;
+    }
+
+    table->keys   = malloc(size * sizeof(uint64_t));
+    table->glyphs = malloc(size * sizeof(int));
+    table->mask   = size - 1;
+    if (table->keys == NULL || table->glyphs == NULL) {
+        free(table->keys);
+        free(table->glyphs);
+        return 0;
+    }
+
+    memset(table->glyphs, -1, size * sizeof(int));
+    return 1;
+}
+
+static void dedup_table_free(Dedup_Table* table) {
+    free(table->keys);
+    free(table->glyphs);
+}
+
+static int dedup_table_get_slot(const Dedup_Table* table, uint64_t key) {
+    // The key is mixed so keys that only differ in their high bits still
+    // spread across the table
+    return (int)((key * 0x9e3779b97f4a7c15ULL) >> 32) & table->mask;
+}
+
+static int dedup_find_idx(Dedup_Table* table, const TTY_Glyph* glyphs, int glyph_idx) {
+    // Returns the first glyph with the same index, or glyph_idx if there
+    // isn't one
+    uint64_t key  = glyphs[glyph_idx].idx;
+    int      slot = dedup_table_get_slot(table, key);
+
+    while (table->glyphs[slot] >= 0) {
+        if (table->keys[slot] == key) {
+            return table->glyphs[slot];
+        }
+        slot = (slot + 1) & table->mask;
+    }
+
+    table->keys[slot]   = key;
+    table->glyphs[slot] = glyph_idx;
+    return glyph_idx;
+}
+
+static int dedup_find_outline(Dedup_Table* table, TTY_Font* font, const TTY_Glyph* glyphs, int glyph_idx) {
+    // Returns the first glyph with the same outline data, or glyph_idx if
+    // there isn't one. Hashes that collide are told apart by comparing the
+    // data.
+    const TTY_Glyph* glyph = glyphs + glyph_idx;
+    TTY_U32          size  = tty_get_glyph_data_size(font, glyph);
+    uint64_t         key   = fnv1a(FNV_OFFSET_BASIS, glyph->glyfBlock, size);
+    int              slot  = dedup_table_get_slot(table, key);
+
+    while (table->glyphs[slot] >= 0) {
+        const TTY_Glyph* other = glyphs + table->glyphs[slot];
+        if (table->keys[slot] == key &&
+            tty_get_glyph_data_size(font, other) == size &&
+            memcmp(other->glyfBlock, glyph->glyfBlock, size) == 0)
+        {
+            return table->glyphs[slot];
+        }
+        slot = (slot + 1) & table->mask;
+    }
+
+    table->keys[slot]   = key;
+    table->glyphs[slot] = glyph_idx;
+    return glyph_idx;
+}
+
+DF_Error dedup_init(Dedup* dedup, TTY_Font* font, const TTY_Glyph* glyphs, int num_glyphs, int by_outline) {
+    dedup->sources    = malloc((num_glyphs > 0 ? num_glyphs : 1) * sizeof(int));
+    dedup->unique     = malloc((num_glyphs > 0 ? num_glyphs : 1) * sizeof(int));
+    dedup->num_unique = 0;
+
+    Dedup_Table by_idx;
+    Dedup_Table by_data;
+    int         tables = 0;
+
+    if (dedup->sources == NULL || dedup->unique == NULL ||
+        !(tables = dedup_table_init(&by_idx, num_glyphs)) ||
+        (by_outline && !dedup_table_init(&by_data, num_glyphs)))
+    {
+        if (tables) {
+            dedup_table_free(&by_idx);
+        }
+        dedup_free(dedup);
+        return DF_ERROR_OUT_OF_MEMORY;
+    }
+
+    for (int i = 0; i < num_glyphs; i++) {
+        int source = dedup_find_idx(&by_idx, glyphs, i);
+
+        // Glyphs without outlines are all empty, but can still have
+        // different advances, so they're only merged by index
+        if (source == i && by_outline && glyphs[i].glyfBlock != NULL) {
+            source = dedup_find_outline(&by_data, font, glyphs, i);
+        }
+
+        dedup->sources[i] = source;
+        if (source == i) {
+            dedup->unique[dedup->num_unique++] = i;
+        }
+    }
+
+    dedup_table_free(&by_idx);
+    if (by_outline) {
+        dedup_table_free(&by_data);
+    }
+    return DF_ERROR_NONE;
+}
+
+void dedup_free(Dedup* dedup) {
+    free(dedup->sources);
+    free(dedup->unique);
+    dedup->sources    = NULL;
+    dedup->unique     = NULL;
+    dedup->num_unique = 0;
+}
+
+DF_Error dedup_fill(const Dedup* dedup, TTY_Font* font, TTY_Instance* instance,
+                    const TTY_Glyph* glyphs, int num_glyphs, DF_Glyph* df_glyphs)
+{
+    for (int i = 0; i < num_glyphs; i++) {
+        int source = dedup->sources[i];
+        if (source == i) {
+            continue;
+        }
+
+        DF_Glyph* result = df_glyphs + i;
+        *result        = df_glyphs[source];
+        result->pixels = NULL;
+
+        if (glyphs[i].idx != glyphs[source].idx) {
+            // The outlines are identical, so the size and offset are too, but
+            // the advance comes from the hmtx table
+            result->glyph = glyphs[i];
+            if (tty_get_glyph_metrics(font, instance, &result->glyph)) {
+                return DF_ERROR_FONT;
+            }
+        }
+    }
+    return DF_ERROR_NONE;
+}
@@ -0,0 +1,32 @@
+#ifndef DFFONT_DEDUP_H
+#define DFFONT_DEDUP_H
+
+#include "truety.h"
+#include "df_glyph.h"
+
+/*
+ * Finds glyphs that would have the same distance field, so it is only
+ * generated once and they share a rect in the atlas. Code points that map to
+ * the same glyph index are always merged. If `by_outline` is set, glyphs
+ * whose outline data is byte for byte identical are merged too.
+ */
+typedef struct {
+    int* sources;    /* sources[i] is the glyph that glyph i gets its distance field from, i if it's unique */
+    int* unique;     /* The glyphs whose source is themselves */
+    int  num_unique;
+} Dedup;
+
+/* Returns DF_ERROR_OUT_OF_MEMORY if memory could not be allocated */
+DF_Error dedup_init(Dedup* dedup, TTY_Font* font, const TTY_Glyph* glyphs, int num_glyphs, int by_outline);
+
+void dedup_free(Dedup* dedup);
+
+/*
+ * Fills in the duplicates in `df_glyphs` once the unique glyphs have been
+ * generated. Duplicates get the size and offset of their source, but keep
+ * their own advance, and their `pixels` are NULL since they aren't packed.
+ */
+DF_Error dedup_fill(const Dedup* dedup, TTY_Font* font, TTY_Instance* instance,
+                    const TTY_Glyph* glyphs, int num_glyphs, DF_Glyph* df_glyphs);
+
+#endif
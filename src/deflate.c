@@ -0,0 +1,459 @@
+#include <stdlib.h>
+#include <string.h>
+#include "deflate.h"
+#include "thread.h"
+
+/* Large enough that restarting the window at each block costs little, small enough to split an atlas between threads */
+#define DEFLATE_BLOCK_SIZE  (128 * 1024)
+
+#define DEFLATE_HASH_BITS   15
+#define DEFLATE_HASH_SIZE   (1 << DEFLATE_HASH_BITS)
+#define DEFLATE_WINDOW_SIZE 32768
+#define DEFLATE_MIN_MATCH   3
+#define DEFLATE_MAX_MATCH   258
+#define DEFLATE_MAX_STORED  65535
+#define DEFLATE_EOB         256
+
+#define ADLER_BASE 65521
+#define ADLER_NMAX 5552
+
+static const uint16_t LENGTH_BASES[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t DIST_BASES[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t DIST_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/* The fixed Huffman codes, bit reversed since deflate writes them most significant bit first */
+typedef struct {
+    uint16_t lit_codes[288];
+    uint8_t  lit_lens[288];
+    uint8_t  dist_codes[30];
+    uint8_t  length_syms[DEFLATE_MAX_MATCH + 1]; /* Index into LENGTH_BASES */
+} Deflate_Codes;
+
+typedef struct {
+    uint8_t* data;
+    size_t   size;
+    size_t   cap;
+    uint32_t bits;
+    int      num_bits;
+    int      failed;
+} Bit_Writer;
+
+typedef struct {
+    uint8_t*  data;
+    size_t    size;
+    uint32_t  adler;
+} Deflate_Block;
+
+typedef struct {
+    const uint8_t*        data;
+    size_t                size;
+    int                   level;
+    const Deflate_Codes*  codes;
+    Deflate_Block*        blocks;
+    int                   num_blocks;
+    volatile int          next_block;
+    volatile int          failed;     /* Only accessed with atomic_add_int while the workers run */
+} Deflate_Job;
+
+typedef struct {
+    Deflate_Job* job;
+    Thread       thread;
+} Deflate_Worker;
+
+static uint32_t reverse_bits(uint32_t code, int len) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < len; i++) {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    return reversed;
+}
+
+static void deflate_init_codes(Deflate_Codes* codes) {
+    for (int i = 0; i < 288; i++) {
+        uint32_t code;
+        int      len;
+        if (i < 144) {
+            code = 0x30 + i;
+            len  = 8;
+        }
+        else if (i < 256) {
+            code = 0x190 + i - 144;
+            len  = 9;
+        }
+        else if (i < 280) {
+            code = i - 256;
+            len  = 7;
+        }
+        else {
+            code = 0xc0 + i - 280;
+            len  = 8;
+        }
+        codes->lit_codes[i] = reverse_bits(code, len);
+        codes->lit_lens[i]  = len;
+    }
+
+    for (int i = 0; i < 30; i++) {
+        codes->dist_codes[i] = reverse_bits(i, 5);
+    }
+
+    int sym = 0;
+    for (int len = DEFLATE_MIN_MATCH; len <= DEFLATE_MAX_MATCH; len++) {
+        while (sym < 28 && len >= LENGTH_BASES[sym + 1]) {
+            sym++;
+        }
+        codes->length_syms[len] = sym;
+    }
+}
+
+static void bits_put_byte(Bit_Writer* writer, uint8_t byte) {
+    if (writer->size == writer->cap) {
+        size_t   cap  = writer->cap > 0 ? writer->cap * 2 : 4096;
+        uint8_t* data = realloc(writer->data, cap);
+        if (data == NULL) {
+            writer->failed = 1;
+            return;
+        }
+        writer->data = data;
+        writer->cap  = cap;
+    }
+    writer->data[writer->size++] = byte;
+}
+
+static void bits_write(Bit_Writer* writer, uint32_t value, int count) {
+    writer->bits     |= value << writer->num_bits;
+    writer->num_bits += count;
+    while (writer->num_bits >= 8) {
+        bits_put_byte(writer, writer->bits & 0xff);
+        writer->bits    >>= 8;
+        writer->num_bits -= 8;
+    }
+}
+
+static void bits_align(Bit_Writer* writer) {
+    if (writer->num_bits > 0) {
+        bits_write(writer, 0, 8 - writer->num_bits);
+    }
+}
+
+static uint32_t adler32(uint32_t adler, const uint8_t* data, size_t size) {
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    while (size > 0) {
+        size_t n = size < ADLER_NMAX ? size : ADLER_NMAX;
+        size -= n;
+        while (n-- > 0) {
+            a += *data++;
+            b += a;
+        }
+        a %= ADLER_BASE;
+        b %= ADLER_BASE;
+    }
+    return a | (b << 16);
+}
+
+static uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t size2) {
+    // The checksum of two pieces of data joined together, given the size of
+    // the second, so blocks can be checksummed in parallel
+    uint32_t rem  = (uint32_t)(size2 % ADLER_BASE);
+    uint32_t sum1 = adler1 & 0xffff;
+    uint32_t sum2 = (uint32_t)(((uint64_t)rem * sum1) % ADLER_BASE);
+    sum1 += (adler2 & 0xffff) + ADLER_BASE - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + ADLER_BASE - rem;
+    if (sum1 >= ADLER_BASE) {
+        sum1 -= ADLER_BASE;
+    }
+    if (sum1 >= ADLER_BASE) {
+        sum1 -= ADLER_BASE;
+    }
+    if (sum2 >= ADLER_BASE * 2) {
+        sum2 -= ADLER_BASE * 2;
+    }
+    if (sum2 >= ADLER_BASE) {
+        sum2 -= ADLER_BASE;
+    }
+    return sum1 | (sum2 << 16);
+}
+
+static uint32_t deflate_hash(const uint8_t* data) {
+    uint32_t value = data[0] | (data[1] << 8) | (data[2] << 16);
+    return (value * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+}
+
+static void deflate_write_literal(Bit_Writer* writer, const Deflate_Codes* codes, int lit) {
+    bits_write(writer, codes->lit_codes[lit], codes->lit_lens[lit]);
+}
+
+static void deflate_write_match(Bit_Writer* writer, const Deflate_Codes* codes, int len, int dist) {
+    int len_sym = codes->length_syms[len];
+    deflate_write_literal(writer, codes, 257 + len_sym);
+    bits_write(writer, len - LENGTH_BASES[len_sym], LENGTH_EXTRA[len_sym]);
+
+    int dist_sym = 0;
+    while (dist_sym < 29 && dist >= DIST_BASES[dist_sym + 1]) {
+        dist_sym++;
+    }
+    bits_write(writer, codes->dist_codes[dist_sym], 5);
+    bits_write(writer, dist - DIST_BASES[dist_sym], DIST_EXTRA[dist_sym]);
+}
+
+static void deflate_store(Bit_Writer* writer, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        size_t len = size < DEFLATE_MAX_STORED ? size : DEFLATE_MAX_STORED;
+
+        // BFINAL = 0, BTYPE = 00, then LEN and NLEN on a byte boundary
+        bits_write(writer, 0, 3);
+        bits_align(writer);
+        bits_write(writer, len & 0xffff, 16);
+        bits_write(writer, ~len & 0xffff, 16);
+        for (size_t i = 0; i < len; i++) {
+            bits_put_byte(writer, data[i]);
+        }
+
+        data += len;
+        size -= len;
+    }
+}
+
+static void deflate_compress(Bit_Writer* writer, const Deflate_Codes* codes, const uint8_t* data, size_t size,
+                             int level, int32_t* head, int32_t* prev)
+{
+    // Greedy matching with hash chains, using the fixed Huffman codes. Each
+    // level doubles how many earlier positions are tried.
+    int max_chain = 2 << level;
+
+    for (int i = 0; i < DEFLATE_HASH_SIZE; i++) {
+        head[i] = -1;
+    }
+
+    // BFINAL = 0, BTYPE = 01
+    bits_write(writer, 0, 1);
+    bits_write(writer, 1, 2);
+
+    size_t i = 0;
+    while (i < size) {
+        int best_len  = 0;
+        int best_dist = 0;
+
+        if (i + DEFLATE_MIN_MATCH <= size) {
+            size_t   max_len = size - i < DEFLATE_MAX_MATCH ? size - i : DEFLATE_MAX_MATCH;
+            uint32_t hash    = deflate_hash(data + i);
+            int32_t  match   = head[hash];
+
+            for (int chain = 0; match >= 0 && i - match <= DEFLATE_WINDOW_SIZE && chain < max_chain; chain++) {
+                // Matches that can't be longer than the best are skipped
+                // after comparing one byte
+                if (data[match + best_len] == data[i + best_len]) {
+                    size_t len = 0;
+                    while (len < max_len && data[match + len] == data[i + len]) {
+                        len++;
+                    }
+                    if ((int)len > best_len) {
+                        best_len  = (int)len;
+                        best_dist = (int)(i - match);
+                        if (len == max_len) {
+                            break;
+                        }
+                    }
+                }
+                match = prev[match];
+            }
+
+            prev[i]    = head[hash];
+            head[hash] = (int32_t)i;
+        }
+
+        if (best_len >= DEFLATE_MIN_MATCH) {
+            deflate_write_match(writer, codes, best_len, best_dist);
+            for (size_t j = i + 1; j < i + best_len && j + DEFLATE_MIN_MATCH <= size; j++) {
+                uint32_t hash = deflate_hash(data + j);
+                prev[j]    = head[hash];
+                head[hash] = (int32_t)j;
+            }
+            i += best_len;
+        }
+        else {
+            deflate_write_literal(writer, codes, data[i]);
+            i++;
+        }
+    }
+
+    deflate_write_literal(writer, codes, DEFLATE_EOB);
+}
+
+static void deflate_run_job(Deflate_Job* job) {
+    int32_t* head = NULL;
+    int32_t* prev = NULL;
+    if (job->level > 0) {
+        head = malloc(DEFLATE_HASH_SIZE * sizeof(int32_t));
+        prev = malloc(DEFLATE_BLOCK_SIZE * sizeof(int32_t));
+        if (head == NULL || prev == NULL) {
+            atomic_add_int(&job->failed, 1);
+        }
+    }
+
+    while (!atomic_add_int(&job->failed, 0)) {
+        int i = atomic_add_int(&job->next_block, 1);
+        if (i >= job->num_blocks) {
+            break;
+        }
+
+        const uint8_t* data = job->data + (size_t)i * DEFLATE_BLOCK_SIZE;
+        size_t         size = job->size - (size_t)i * DEFLATE_BLOCK_SIZE;
+        if (size > DEFLATE_BLOCK_SIZE) {
+            size = DEFLATE_BLOCK_SIZE;
+        }
+
+        Bit_Writer writer = {0};
+        if (job->level > 0) {
+            deflate_compress(&writer, job->codes, data, size, job->level, head, prev);
+
+            // A sync flush (an empty stored block) ends the block on a byte
+            // boundary so the blocks can be joined
+            bits_write(&writer, 0, 3);
+            bits_align(&writer);
+            bits_write(&writer, 0x0000, 16);
+            bits_write(&writer, 0xffff, 16);
+        }
+
+        // Data that doesn't compress, like noise, is stored instead since
+        // the fixed codes would make it larger
+        if (job->level == 0 || writer.size > size + 5 * (size / DEFLATE_MAX_STORED + 1)) {
+            writer.size     = 0;
+            writer.bits     = 0;
+            writer.num_bits = 0;
+            deflate_store(&writer, data, size);
+        }
+
+        if (writer.failed) {
+            free(writer.data);
+            atomic_add_int(&job->failed, 1);
+            break;
+        }
+
+        job->blocks[i].data  = writer.data;
+        job->blocks[i].size  = writer.size;
+        job->blocks[i].adler = adler32(1, data, size);
+    }
+
+    free(head);
+    free(prev);
+}
+
+static void deflate_worker_main(void* arg) {
+    deflate_run_job(((Deflate_Worker*)arg)->job);
+}
+
+uint8_t* zlib_compress(const uint8_t* data, size_t size, int level, int num_threads, size_t* out_size) {
+    Deflate_Codes codes;
+    deflate_init_codes(&codes);
+
+    Deflate_Job job = {
+        .data       = data,
+        .size       = size,
+        .level      = level < 0 ? 0 : level > DEFLATE_MAX_LEVEL ? DEFLATE_MAX_LEVEL : level,
+        .codes      = &codes,
+        .num_blocks = (int)((size + DEFLATE_BLOCK_SIZE - 1) / DEFLATE_BLOCK_SIZE),
+    };
+
+    job.blocks = calloc(job.num_blocks > 0 ? job.num_blocks : 1, sizeof(Deflate_Block));
+    if (job.blocks == NULL) {
+        return NULL;
+    }
+
+    // There's no point in having more threads than blocks
+    int num_workers = (num_threads < job.num_blocks ? num_threads : job.num_blocks) - 1;
+    if (num_workers < 0) {
+        num_workers = 0;
+    }
+
+    Deflate_Worker* workers = NULL;
+    if (num_workers > 0) {
+        workers = calloc(num_workers, sizeof(Deflate_Worker));
+        if (workers == NULL) {
+            num_workers = 0;
+        }
+    }
+
+    int num_started = 0;
+    for (; num_started < num_workers; num_started++) {
+        workers[num_started].job = &job;
+        if (!thread_create(&workers[num_started].thread, deflate_worker_main, workers + num_started)) {
+            // The blocks are still compressed, just with fewer threads
+            break;
+        }
+    }
+
+    deflate_run_job(&job);
+
+    for (int i = 0; i < num_started; i++) {
+        thread_join(&workers[i].thread);
+    }
+    free(workers);
+
+    uint8_t* out = NULL;
+    if (!job.failed) {
+        // The header, the blocks, an empty final block, and the checksum
+        size_t total = 2 + 2 + 4;
+        for (int i = 0; i < job.num_blocks; i++) {
+            total += job.blocks[i].size;
+        }
+        out = malloc(total);
+    }
+
+    if (out != NULL) {
+        // The FLEVEL bits are only a hint, and the check bits make the header
+        // a multiple of 31
+        static const uint8_t flevels[DEFLATE_MAX_LEVEL + 1] = {
+            0x01, 0x01, 0x5e, 0x5e, 0x5e, 0x5e, 0x9c, 0xda, 0xda, 0xda
+        };
+
+        size_t   off   = 0;
+        uint32_t adler = 1;
+        out[off++] = 0x78;
+        out[off++] = flevels[job.level];
+
+        for (int i = 0; i < job.num_blocks; i++) {
+            size_t block_size = size - (size_t)i * DEFLATE_BLOCK_SIZE;
+            if (block_size > DEFLATE_BLOCK_SIZE) {
+                block_size = DEFLATE_BLOCK_SIZE;
+            }
+            memcpy(out + off, job.blocks[i].data, job.blocks[i].size);
+            off  += job.blocks[i].size;
+            adler = adler32_combine(adler, job.blocks[i].adler, block_size);
+        }
+
+        // BFINAL = 1, BTYPE = 01, then the end of block code (seven 0 bits)
+        out[off++] = 0x03;
+        out[off++] = 0x00;
+
+        out[off++] = adler >> 24;
+        out[off++] = adler >> 16;
+        out[off++] = adler >> 8;
+        out[off++] = adler;
+
+        *out_size = off;
+    }
+
+    for (int i = 0; i < job.num_blocks; i++) {
+        free(job.blocks[i].data);
+    }
+    free(job.blocks);
+    return out;
+}
@@ -0,0 +1,22 @@
+#ifndef DFFONT_DEFLATE_H
+#define DFFONT_DEFLATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define DEFLATE_MAX_LEVEL 9
+
+/*
+ * Compresses `data` into a zlib stream. The data is split into blocks of
+ * DEFLATE_BLOCK_SIZE bytes that are compressed independently using
+ * `num_threads` threads, one of which is the calling thread, then joined with
+ * sync flushes. The block size doesn't depend on the number of threads, so
+ * neither does the output.
+ *
+ * Level 0 stores the data without compressing it, higher levels search
+ * further back for matches. Returns NULL if memory could not be allocated,
+ * otherwise the stream is `*out_size` bytes and must be freed with `free`.
+ */
+uint8_t* zlib_compress(const uint8_t* data, size_t size, int level, int num_threads, size_t* out_size);
+
+#endif
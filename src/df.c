@@ -80,6 +80,11 @@ static float linear_map(float x, float x0, float y0, float x1, float y1) {
     return m * x + b;
 }
 
+void calc_squared_dists(DF* df) {
+    calc_df_pass(df, 0);
+    calc_df_pass(df, 1);
+}
+
 void calc_df(DF* df) {
     float maxdist = 0.0f;
 
@@ -89,8 +94,7 @@ void calc_df(DF* df) {
             df->dists[i] = df->pixels[i] > 0 ? FLT_MAX : 0;
         }
 
-        calc_df_pass(df, 0);
-        calc_df_pass(df, 1);
+        calc_squared_dists(df);
 
         for (int i = 0; i < df->w * df->h; i++) {
             if (df->pixels[i] > 0) {
@@ -114,8 +118,7 @@ void calc_df(DF* df) {
             df->dists[i] = df->pixels[i] == 0 ? FLT_MAX : 0;
         }
 
-        calc_df_pass(df, 0);
-        calc_df_pass(df, 1);
+        calc_squared_dists(df);
 
         for (int i = 0; i < df->w * df->h; i++) {
             if (df->pixels[i] == 0) {
@@ -127,4 +130,6 @@ void calc_df(DF* df) {
             }
         }
     }
+
+    df->maxdist = maxdist;
 }
\ No newline at end of file
@@ -17,8 +17,16 @@ typedef struct {
     int      n_xinters;
     int      n_verts;
     int      spread;
+    float    maxdist; /* The distance that calc_df maps to 255 */
 } DF;
 
 void calc_df(DF* df);
 
+/*
+ * Sets each distance that is FLT_MAX to the squared distance to the nearest
+ * pixel whose distance is 0. `xinters` and `verts` must hold as many values
+ * as the larger of w and h.
+ */
+void calc_squared_dists(DF* df);
+
 #endif
@@ -0,0 +1,107 @@
+#include <string.h>
+#include "df_cache.h"
+
+DF_Error df_cache_init(DF_Cache* cache, TTY_Font* font, int ppem, int scale, int spread, int w, int h, int max_pages) {
+    memset(cache, 0, sizeof(DF_Cache));
+    cache->font = font;
+
+    if (tty_instance_init(font, &cache->instance, ppem * scale, TTY_INSTANCE_NO_HINTING | TTY_INSTANCE_BINARY)) {
+        return DF_ERROR_FONT;
+    }
+
+    DF_Error error;
+    if ((error = df_glyph_renderer_init(&cache->renderer, &cache->instance, scale, spread))) {
+        tty_instance_free(&cache->instance);
+        return error;
+    }
+
+    TTY_U32_V2 max_glyph_size = {.x = cache->renderer.down_w, .y = cache->renderer.down_h};
+    if (tty_atlas_cache_init_custom(&cache->atlas, max_glyph_size, w, h, max_pages)) {
+        df_glyph_renderer_free(&cache->renderer);
+        tty_instance_free(&cache->instance);
+        return DF_ERROR_OUT_OF_MEMORY;
+    }
+
+    return DF_ERROR_NONE;
+}
+
+void df_cache_free(DF_Cache* cache) {
+    tty_atlas_cache_free(&cache->atlas);
+    df_glyph_renderer_free(&cache->renderer);
+    tty_instance_free(&cache->instance);
+}
+
+static void df_cache_fill_entry(DF_Cache* cache, DF_Cache_Entry* entry, TTY_Atlas_Cache_Entry* atlas_entry) {
+    TTY_Glyph* glyph = &atlas_entry->glyph;
+    int        scale = cache->renderer.scale;
+
+    entry->x    = atlas_entry->atlasPos.x;
+    entry->y    = atlas_entry->atlasPos.y;
+    entry->page = atlas_entry->page;
+    entry->w    = 0;
+    entry->h    = 0;
+    entry->xoff = glyph->offset.x / scale;
+    entry->yoff = (cache->instance.ascender - glyph->offset.y) / scale;
+    entry->xadv = glyph->advance.x / scale;
+    entry->yadv = glyph->advance.y / scale;
+
+    if (glyph->size.x > 0 && glyph->size.y > 0) {
+        df_get_glyph_size(&cache->renderer, glyph, &entry->w, &entry->h);
+    }
+}
+
+DF_Error df_cache_get(DF_Cache* cache, DF_Cache_Entry* entry, uint32_t code_point) {
+    TTY_Atlas_Cache_Entry atlas_entry;
+
+    if (tty_atlas_cache_lookup(&cache->atlas, &atlas_entry, code_point)) {
+        df_cache_fill_entry(cache, entry, &atlas_entry);
+        return DF_ERROR_NONE;
+    }
+
+    // The distance field is generated before space is reserved for it, since
+    // its size isn't known until the glyph is rendered
+    {
+        TTY_Glyph* glyph = &atlas_entry.glyph;
+
+        if (tty_get_glyph_index(cache->font, code_point, &glyph->idx) ||
+            tty_glyph_init(cache->font, glyph, glyph->idx))
+        {
+            return DF_ERROR_FONT;
+        }
+
+        DF_Error error;
+        if ((error = df_render_glyph(&cache->renderer, cache->font, &cache->instance, glyph))) {
+            return error;
+        }
+    }
+
+    df_cache_fill_entry(cache, entry, &atlas_entry);
+
+    {
+        TTY_U32_V2 size = {.x = entry->w, .y = entry->h};
+
+        switch (tty_atlas_cache_reserve_entry(&cache->atlas, &atlas_entry, code_point, size)) {
+            case TTY_ERROR_NONE:
+                break;
+            case TTY_ERROR_GLYPH_DOES_NOT_FIT_IN_IMAGE:
+                return DF_ERROR_DOES_NOT_FIT;
+            default:
+                return DF_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    entry->x    = atlas_entry.atlasPos.x;
+    entry->y    = atlas_entry.atlasPos.y;
+    entry->page = atlas_entry.page;
+
+    {
+        TTY_Image* page = &cache->atlas.pages[entry->page].image;
+        for (int y = 0; y < entry->h; y++) {
+            uint8_t* dst = page->pixels + entry->x + (entry->y + y) * page->size.x;
+            uint8_t* src = cache->renderer.down_pixels + y * cache->renderer.down_w;
+            memcpy(dst, src, entry->w);
+        }
+    }
+
+    return DF_ERROR_NONE;
+}
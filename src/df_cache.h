@@ -0,0 +1,44 @@
+#ifndef DF_CACHE_H
+#define DF_CACHE_H
+
+#include <stdint.h>
+#include "truety.h"
+#include "df_glyph.h"
+
+/* Positions and metrics are in output pixels, the same as dffont's font info file */
+typedef struct {
+    int x;
+    int y;
+    int page;
+    int w;
+    int h;
+    int xoff;
+    int yoff;
+    int xadv;
+    int yadv;
+} DF_Cache_Entry;
+
+/*
+ * An atlas cache of distance field glyphs that are generated the first time
+ * they are requested, so text isn't limited to glyphs that were baked ahead
+ * of time. The pages are `atlas.pages[i].image`, and the areas that changed
+ * can be found with `tty_atlas_cache_get_dirty_rects(&cache->atlas, ...)`.
+ */
+typedef struct {
+    TTY_Font*          font;
+    TTY_Instance       instance; /* Renders glyphs at ppem * scale */
+    TTY_Atlas_Cache    atlas;
+    DF_Glyph_Renderer  renderer;
+} DF_Cache;
+
+DF_Error df_cache_init(DF_Cache* cache, TTY_Font* font, int ppem, int scale, int spread, int w, int h, int max_pages);
+
+void df_cache_free(DF_Cache* cache);
+
+/*
+ * Gets the glyph's entry, generating its distance field if it isn't cached.
+ * Glyphs that have no pixels (e.g. spaces) have a size of 0.
+ */
+DF_Error df_cache_get(DF_Cache* cache, DF_Cache_Entry* entry, uint32_t code_point);
+
+#endif
@@ -0,0 +1,269 @@
+#include <stdlib.h>
+#include <string.h>
+#include "df_glyph.h"
+#include "thread.h"
+#include "tile_cache.h"
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize.h"
+
+DF_Error df_glyph_renderer_init(DF_Glyph_Renderer* renderer, TTY_Instance* instance, int scale, int spread) {
+    int spread_size = 2 * spread;
+
+    memset(renderer, 0, sizeof(DF_Glyph_Renderer));
+    renderer->scale  = scale;
+    renderer->spread = spread;
+
+    DF* df = &renderer->df;
+    df->w = instance->maxGlyphSize.x + scale * spread_size;
+    df->h = instance->maxGlyphSize.y + scale * spread_size;
+    df->spread = scale * spread;
+
+    renderer->down_w = instance->maxGlyphSize.x / scale + spread_size;
+    renderer->down_h = instance->maxGlyphSize.y / scale + spread_size;
+
+    {
+        int off              = 0;
+        int dim              = df->w > df->h ? df->w : df->h;
+        int dists_size       = df->w * df->h * sizeof(float);
+        int xinters_size     = dim * sizeof(float);
+        int verts_size       = dim * sizeof(Vec2);
+        int df_pixels_size   = df->w * df->h;
+        int down_pixels_size = renderer->down_w * renderer->down_h;
+        renderer->mem = calloc(dists_size + xinters_size + verts_size + df_pixels_size + down_pixels_size, 1);
+        if (renderer->mem == NULL) {
+            return DF_ERROR_OUT_OF_MEMORY;
+        }
+        df->dists             = (float*)(renderer->mem);
+        df->xinters           = (float*)(renderer->mem + (off += dists_size));
+        df->verts             = (Vec2*) (renderer->mem + (off += xinters_size));
+        df->pixels            =         (renderer->mem + (off += verts_size));
+        renderer->down_pixels =         (renderer->mem + (off += df_pixels_size));
+    }
+
+    return DF_ERROR_NONE;
+}
+
+void df_glyph_renderer_free(DF_Glyph_Renderer* renderer) {
+    free(renderer->mem);
+    renderer->mem = NULL;
+}
+
+DF_Error df_render_glyph(DF_Glyph_Renderer* renderer, TTY_Font* font, TTY_Instance* instance, TTY_Glyph* glyph) {
+    DF* df = &renderer->df;
+
+    {
+        TTY_Image image = {
+            .pixels = df->pixels,
+            .size = {.x = df->w, .y = df->h}
+        };
+
+        if (tty_render_glyph_to_existing_image(font, instance, glyph, &image, df->spread, df->spread)) {
+            return DF_ERROR_FONT;
+        }
+    }
+
+    if (glyph->size.x == 0 || glyph->size.y == 0) {
+        return DF_ERROR_NONE;
+    }
+
+    calc_df(df);
+
+    int resized = stbir_resize_uint8(df->pixels, df->w, df->h, df->w,
+                                     renderer->down_pixels, renderer->down_w, renderer->down_h, renderer->down_w,
+                                     1);
+
+    // The next glyph is rendered on top of this buffer
+    memset(df->pixels, 0, df->w * df->h);
+
+    return resized ? DF_ERROR_NONE : DF_ERROR_OUT_OF_MEMORY;
+}
+
+void df_get_glyph_size(DF_Glyph_Renderer* renderer, TTY_Glyph* glyph, int* w, int* h) {
+    *w = glyph->size.x / renderer->scale + 2 * renderer->spread;
+    *h = glyph->size.y / renderer->scale + 2 * renderer->spread;
+}
+
+DF_Error df_generate_glyph(DF_Glyph_Renderer* renderer, TTY_Font* font, TTY_Instance* instance,
+                           const Tile_Cache* tile_cache, DF_Glyph* result)
+{
+    if (tile_cache != NULL && tile_cache_load(tile_cache, result)) {
+        return DF_ERROR_NONE;
+    }
+
+    DF_Error error;
+    if ((error = df_render_glyph(renderer, font, instance, &result->glyph))) {
+        return error;
+    }
+
+    df_get_glyph_size(renderer, &result->glyph, &result->w, &result->h);
+    result->pixels     = NULL;
+    result->dist_scale = 0.0f;
+
+    if (result->glyph.size.x > 0 && result->glyph.size.y > 0) {
+        result->pixels = malloc(result->w * result->h);
+        if (result->pixels == NULL) {
+            return DF_ERROR_OUT_OF_MEMORY;
+        }
+        for (int y = 0; y < result->h; y++) {
+            memcpy(result->pixels + y * result->w, renderer->down_pixels + y * renderer->down_w, result->w);
+        }
+
+        // calc_df maps distances in the scaled instance's pixels to 0-255
+        result->dist_scale = renderer->df.maxdist / (255.0f * renderer->scale);
+    }
+
+    if (tile_cache != NULL) {
+        tile_cache_store(tile_cache, result);
+    }
+
+    return DF_ERROR_NONE;
+}
+
+typedef struct {
+    TTY_Font*         font;
+    TTY_Instance*     instance;
+    const Tile_Cache* tile_cache;
+    const TTY_Glyph*  glyphs;
+    DF_Glyph*         results;
+    int               num_glyphs;
+    int               scale;
+    int               spread;
+    volatile int      next_glyph;
+    volatile int      failed;     /* Set when a thread fails so the others stop early, only accessed with atomic_add_int */
+} DF_Glyph_Job;
+
+typedef struct {
+    DF_Glyph_Job*  job;
+    Thread         thread;
+    DF_Error       error;
+} DF_Glyph_Worker;
+
+static DF_Error df_run_glyph_job(DF_Glyph_Job* job, TTY_Font* font, TTY_Instance* instance) {
+    DF_Glyph_Renderer renderer;
+
+    DF_Error error;
+    if ((error = df_glyph_renderer_init(&renderer, instance, job->scale, job->spread))) {
+        return error;
+    }
+
+    while (!atomic_add_int(&job->failed, 0)) {
+        // Glyphs are handed out one at a time since their sizes vary a lot
+        int i = atomic_add_int(&job->next_glyph, 1);
+        if (i >= job->num_glyphs) {
+            break;
+        }
+
+        DF_Glyph* result = job->results + i;
+        result->glyph = job->glyphs[i];
+
+        if ((error = df_generate_glyph(&renderer, font, instance, job->tile_cache, result))) {
+            break;
+        }
+    }
+
+    if (error) {
+        atomic_add_int(&job->failed, 1);
+    }
+
+    df_glyph_renderer_free(&renderer);
+    return error;
+}
+
+static void df_glyph_worker_main(void* arg) {
+    DF_Glyph_Worker* worker = (DF_Glyph_Worker*)arg;
+    DF_Glyph_Job*    job    = worker->job;
+
+    TTY_Font font;
+    if (tty_font_init_from_memory(&font, job->font->fileData, job->font->fileSize)) {
+        worker->error = DF_ERROR_FONT;
+        atomic_add_int(&job->failed, 1);
+        return;
+    }
+
+    TTY_Instance instance;
+    {
+        TTY_U32 flags = TTY_INSTANCE_NO_HINTING;
+        if (job->instance->useHinting) {
+            flags = TTY_INSTANCE_DEFAULT;
+        }
+        if (job->instance->useBinaryRendering) {
+            flags |= TTY_INSTANCE_BINARY;
+        }
+        if (tty_instance_init(&font, &instance, job->instance->ppem, flags)) {
+            tty_font_free(&font);
+            worker->error = DF_ERROR_FONT;
+            atomic_add_int(&job->failed, 1);
+            return;
+        }
+    }
+
+    worker->error = df_run_glyph_job(job, &font, &instance);
+
+    tty_instance_free(&instance);
+    tty_font_free(&font);
+}
+
+DF_Error df_render_glyphs(TTY_Font* font, TTY_Instance* instance, int scale, int spread, const Tile_Cache* tile_cache,
+                          const TTY_Glyph* glyphs, int num_glyphs, int num_threads, DF_Glyph* results) 
+{
+    DF_Glyph_Job job = {
+        .font       = font,
+        .instance   = instance,
+        .tile_cache = tile_cache,
+        .glyphs     = glyphs,
+        .results    = results,
+        .num_glyphs = num_glyphs,
+        .scale      = scale,
+        .spread     = spread,
+    };
+
+    memset(results, 0, num_glyphs * sizeof(DF_Glyph));
+
+    // There's no point in having more threads than glyphs
+    int num_workers = (num_threads < num_glyphs ? num_threads : num_glyphs) - 1;
+    if (num_workers < 0) {
+        num_workers = 0;
+    }
+
+    DF_Glyph_Worker* workers = NULL;
+    if (num_workers > 0) {
+        workers = calloc(num_workers, sizeof(DF_Glyph_Worker));
+        if (workers == NULL) {
+            return DF_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    int num_started = 0;
+    for (; num_started < num_workers; num_started++) {
+        DF_Glyph_Worker* worker = workers + num_started;
+        worker->job = &job;
+        if (!thread_create(&worker->thread, df_glyph_worker_main, worker)) {
+            // The glyphs are still generated, just with fewer threads
+            break;
+        }
+    }
+
+    DF_Error error = df_run_glyph_job(&job, font, instance);
+
+    for (int i = 0; i < num_started; i++) {
+        thread_join(&workers[i].thread);
+        if (!error) {
+            error = workers[i].error;
+        }
+    }
+
+    free(workers);
+
+    if (error) {
+        df_glyphs_free(results, num_glyphs);
+    }
+    return error;
+}
+
+void df_glyphs_free(DF_Glyph* glyphs, int num_glyphs) {
+    for (int i = 0; i < num_glyphs; i++) {
+        free(glyphs[i].pixels);
+        glyphs[i].pixels = NULL;
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef DF_GLYPH_H
+#define DF_GLYPH_H
+
+#include <stdint.h>
+#include "truety.h"
+#include "df.h"
+
+typedef enum {
+    DF_ERROR_NONE,
+    DF_ERROR_FONT,          /* truety failed to load or render a glyph */
+    DF_ERROR_OUT_OF_MEMORY,
+    DF_ERROR_DOES_NOT_FIT,  /* The glyph is larger than the atlas */
+    DF_ERROR_FILE,          /* An output file could not be written */
+} DF_Error;
+
+/*
+ * Turns glyphs into distance fields. Glyphs are rendered with an instance
+ * that is `scale` times larger than the output, then the distance field is
+ * downsampled. All buffers are allocated upfront and reused for every glyph.
+ */
+typedef struct {
+    DF       df;
+    uint8_t* mem;
+    uint8_t* down_pixels; /* The destination buffer for stb_image_resize */
+    int      down_w;
+    int      down_h;
+    int      scale;
+    int      spread;
+} DF_Glyph_Renderer;
+
+/* Defined in tile_cache.h */
+struct Tile_Cache;
+
+/* The distance field of a glyph generated by `df_render_glyphs` */
+typedef struct {
+    TTY_Glyph  glyph;  /* The glyph's metrics are for the scaled instance */
+    uint8_t*   pixels;     /* w * h bytes, NULL if the glyph has no pixels */
+    int        w;
+    int        h;
+    float      dist_scale; /* A pixel value v is a distance of v * dist_scale - spread output pixels from
+                              the outline, negative outside it, or less if v is 0. 0 without pixels. */
+} DF_Glyph;
+
+/* `instance` is the scaled instance that glyphs will be rendered with */
+DF_Error df_glyph_renderer_init(DF_Glyph_Renderer* renderer, TTY_Instance* instance, int scale, int spread);
+
+void df_glyph_renderer_free(DF_Glyph_Renderer* renderer);
+
+/*
+ * Renders the glyph and calculates its distance field. On success, the
+ * distance field is stored in `renderer->down_pixels` (with a stride of
+ * `renderer->down_w`) and the glyph's metrics are set. Nothing is rendered
+ * for glyphs that have no pixels.
+ */
+DF_Error df_render_glyph(DF_Glyph_Renderer* renderer, TTY_Font* font, TTY_Instance* instance, TTY_Glyph* glyph);
+
+/* The size of the glyph's distance field, including the spread on each side */
+void df_get_glyph_size(DF_Glyph_Renderer* renderer, TTY_Glyph* glyph, int* w, int* h);
+
+/*
+ * Generates the distance field of `result->glyph`, which must already be
+ * initialized, and copies it into `result->pixels`. If `tile_cache` isn't
+ * NULL, the distance field is loaded from it when possible, and stored in it
+ * when it has to be generated.
+ */
+DF_Error df_generate_glyph(DF_Glyph_Renderer* renderer, TTY_Font* font, TTY_Instance* instance,
+                           const struct Tile_Cache* tile_cache, DF_Glyph* result);
+
+/*
+ * Generates the distance fields of `num_glyphs` glyphs using `num_threads` 
+ * threads, one of which is the calling thread. The calling thread renders 
+ * with `font` and `instance`, the other threads create their own font and 
+ * instance since they can't be shared. `results[i]` is the distance field of 
+ * `glyphs[i]` no matter how many threads are used. `tile_cache` can be NULL.
+ */
+DF_Error df_render_glyphs(TTY_Font* font, TTY_Instance* instance, int scale, int spread, const struct Tile_Cache* tile_cache,
+                          const TTY_Glyph* glyphs, int num_glyphs, int num_threads, DF_Glyph* results);
+
+void df_glyphs_free(DF_Glyph* glyphs, int num_glyphs);
+
+#endif
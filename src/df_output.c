@@ -0,0 +1,849 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "df_output.h"
+#include "pack.h"
+#include "image.h"
+#include "deflate.h"
+#include "bc4.h"
+#include "mips.h"
+
+static const char* get_image_path(const Args* args) {
+    if (args->out_image_path != NULL) {
+        return args->out_image_path;
+    }
+    switch (args->image_format) {
+        case IMAGE_FORMAT_RAW:
+            return "./dffont_image.r8";
+        case IMAGE_FORMAT_KTX2:
+            return "./dffont_image.ktx2";
+        case IMAGE_FORMAT_DDS:
+            return "./dffont_image.dds";
+        default:
+            return "./dffont_image.png";
+    }
+}
+
+static char* get_page_path(const char* path, int page, int num_pages) {
+    // Pages are written to <name>_<page>.<ext> when there is more than one
+    size_t len = strlen(path);
+    char*  out = malloc(len + 16);
+    if (out == NULL) {
+        return NULL;
+    }
+
+    if (num_pages == 1) {
+        memcpy(out, path, len + 1);
+        return out;
+    }
+
+    const char* ext = strrchr(path, '.');
+    const char* sep = strrchr(path, '/');
+    if (ext == NULL || (sep != NULL && ext < sep) || ext == path || ext[-1] == '/') {
+        ext = path + len;
+    }
+
+    sprintf(out, "%.*s_%d%s", (int)(ext - path), path, page, ext);
+    return out;
+}
+
+static DF_Error pack_glyphs(const Args* args, int num_glyphs, const DF_Glyph* df_glyphs, const int* sources,
+                            Pack_Rect* rects, Pack_Page** pages, int* num_pages)
+{
+    // Glyphs without pixels don't take up space in the image
+    int num_rects = 0;
+    for (int i = 0; i < num_glyphs; i++) {
+        if (df_glyphs[i].pixels != NULL) {
+            rects[num_rects].w = df_glyphs[i].w + args->padding[0] + args->padding[1];
+            rects[num_rects].h = df_glyphs[i].h + args->padding[2] + args->padding[3];
+            num_rects++;
+        }
+    }
+
+    // Glyphs that don't fit are put on another page, so none are dropped
+    *num_pages = pack_rects_into_pages(
+        rects, num_rects, args->out_image_w, args->out_image_h, args->auto_size, args->rotate, pages);
+    if (*num_pages < 0) {
+        return DF_ERROR_OUT_OF_MEMORY;
+    }
+
+    for (int i = 0; i < num_rects; i++) {
+        if (!rects[i].packed) {
+            free(*pages);
+            return DF_ERROR_DOES_NOT_FIT;
+        }
+    }
+
+    // Move the packed rects back to their glyph's index
+    for (int i = num_glyphs - 1; i >= 0; i--) {
+        if (df_glyphs[i].pixels != NULL) {
+            rects[i] = rects[--num_rects];
+        }
+        else {
+            memset(rects + i, 0, sizeof(Pack_Rect));
+        }
+    }
+
+    for (int i = 0; i < num_glyphs; i++) {
+        Pack_Rect* rect = rects + i;
+        if (df_glyphs[i].pixels == NULL) {
+            continue;
+        }
+        if (rect->rotated) {
+            // Rotated 90 degrees clockwise, so the glyph's left edge is at
+            // the top and its bottom edge is on the left
+            rect->x += args->padding[3];
+            rect->y += args->padding[0];
+        }
+        else {
+            rect->x += args->padding[0];
+            rect->y += args->padding[2];
+        }
+    }
+
+    // Duplicates have no pixels of their own and point at their source's
+    // rect, which always comes before them
+    if (sources != NULL) {
+        for (int i = 0; i < num_glyphs; i++) {
+            if (sources[i] != i) {
+                rects[i] = rects[sources[i]];
+            }
+        }
+    }
+
+    return DF_ERROR_NONE;
+}
+
+/* The values written for each glyph. The layout matches `DFFont_Glyph` in the client, which the bundle relies on. */
+typedef struct {
+    int32_t codepoint;
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
+    int32_t xoff;
+    int32_t yoff;
+    int32_t xadv;
+    int32_t yadv;
+    int32_t rot;
+    int32_t page;
+    int32_t channel;
+} Glyph_Info;
+
+static void get_glyph_infos(const Args* args, const Charset* charset, const TTY_Instance* instance,
+                            const DF_Glyph* df_glyphs, const int* sources, const Pack_Rect* rects, Glyph_Info* infos)
+{
+    // Glyphs without pixels, like spaces, aren't packed, so they get an empty
+    // rect instead of one that overlaps the glyph at (0,0)
+    for (int i = 0; i < charset->count; i++) {
+        const TTY_Glyph* glyph = &df_glyphs[i].glyph;
+        Glyph_Info*      info  = infos + i;
+        int              blank = df_glyphs[sources != NULL ? sources[i] : i].pixels == NULL;
+        info->codepoint = (int32_t)charset->code_points[i];
+        info->x         = blank ? 0 : rects[i].x;
+        info->y         = blank ? 0 : rects[i].y;
+        info->w         = blank ? 0 : df_glyphs[i].w;
+        info->h         = blank ? 0 : df_glyphs[i].h;
+        info->xoff      = (int)glyph->offset.x / args->scale;
+        info->yoff      = (int)(instance->ascender - glyph->offset.y) / args->scale;
+        info->xadv      = (int)glyph->advance.x / args->scale;
+        info->yadv      = (int)glyph->advance.y / args->scale;
+        info->rot       = rects[i].rotated;
+        info->page      = rects[i].page;
+        info->channel   = args->channel >= 0 ? args->channel : 0;
+    }
+}
+
+static DF_Error write_info_file(const Args* args, const Charset* charset, const TTY_Instance* instance,
+                                const Glyph_Info* infos, int num_pages)
+{
+    FILE* file = fopen(args->out_font_path == NULL ? "./dffont_info" : args->out_font_path, "w");
+    if (file == NULL) {
+        return DF_ERROR_FILE;
+    }
+
+    fprintf(file, "num_glyphs=%d\n", charset->count);
+    fprintf(file, "ppem=%d\n", args->ppem);
+    fprintf(file, "line_gap=%d\n", instance->lineGap);
+
+    // Single page fonts keep the original format
+    if (num_pages > 1) {
+        fprintf(file, "num_pages=%d\n", num_pages);
+    }
+
+    for (int i = 0; i < charset->count; i++) {
+        const Glyph_Info* info = infos + i;
+        fprintf(
+            file, "char=%d, x=%d, y=%d, w=%d, h=%d, xoff=%d, yoff=%d, xadv=%d, yadv=%d",
+            (int)info->codepoint, (int)info->x, (int)info->y, (int)info->w, (int)info->h,
+            (int)info->xoff, (int)info->yoff, (int)info->xadv, (int)info->yadv);
+
+        // Only written when rotation is enabled so the file stays readable by
+        // clients that don't know about rotated glyphs
+        if (args->rotate) {
+            fprintf(file, ", rot=%d", (int)info->rot);
+        }
+        if (num_pages > 1) {
+            fprintf(file, ", page=%d", (int)info->page);
+        }
+        if (args->channel >= 0) {
+            fprintf(file, ", channel=%d", (int)info->channel);
+        }
+        fprintf(file, "\n");
+    }
+
+    return fclose(file) == 0 ? DF_ERROR_NONE : DF_ERROR_FILE;
+}
+
+static uint8_t* render_page(int num_glyphs, const DF_Glyph* df_glyphs, const Pack_Rect* rects, const Pack_Page* pages, int page) {
+    int      page_w     = pages[page].w;
+    int      page_h     = pages[page].h;
+    uint8_t* out_pixels = calloc(page_w * page_h, 1);
+    if (out_pixels == NULL) {
+        return NULL;
+    }
+
+    for (int i = 0; i < num_glyphs; i++) {
+        const DF_Glyph*  df_glyph = df_glyphs + i;
+        const Pack_Rect* rect     = rects + i;
+        int              glyph_w  = df_glyph->w;
+        int              glyph_h  = df_glyph->h;
+
+        if (df_glyph->pixels == NULL || rect->page != page) {
+            continue;
+        }
+
+        if (rect->rotated) {
+            for (int yi = 0; yi < glyph_h; yi++) {
+                uint8_t* down = df_glyph->pixels + (yi * glyph_w);
+                for (int xi = 0; xi < glyph_w; xi++) {
+                    out_pixels[(rect->x + glyph_h - 1 - yi) + (rect->y + xi) * page_w] = down[xi];
+                }
+            }
+        }
+        else {
+            for (int yi = 0; yi < glyph_h; yi++) {
+                uint8_t* out = out_pixels + (rect->x + (yi + rect->y) * page_w);
+                uint8_t* down = df_glyph->pixels + (yi * glyph_w);
+                memcpy(out, down, glyph_w);
+            }
+        }
+    }
+
+    return out_pixels;
+}
+
+static void get_bc4_errors(const uint8_t* pixels, const uint8_t* decoded, int num_glyphs, const DF_Glyph* df_glyphs,
+                           const int* sources, const Pack_Rect* rects, const Pack_Page* pages, int page, int* bc4_errors)
+{
+    // Each glyph's error is the largest difference between its pixels and
+    // the decoded blocks, in the glyph's area of the page. Duplicates are
+    // measured through their source, and glyphs without pixels have none.
+    int page_w = pages[page].w;
+    for (int i = 0; i < num_glyphs; i++) {
+        int source = sources != NULL ? sources[i] : i;
+        if (df_glyphs[source].pixels == NULL) {
+            bc4_errors[i] = 0;
+            continue;
+        }
+        if (rects[source].page != page) {
+            continue;
+        }
+
+        const Pack_Rect* rect = rects + source;
+        int              w    = rect->rotated ? df_glyphs[source].h : df_glyphs[source].w;
+        int              h    = rect->rotated ? df_glyphs[source].w : df_glyphs[source].h;
+        int              max  = 0;
+        for (int y = rect->y; y < rect->y + h; y++) {
+            for (int x = rect->x; x < rect->x + w; x++) {
+                int diff = abs(pixels[x + y * page_w] - decoded[x + y * page_w]);
+                max = diff > max ? diff : max;
+            }
+        }
+        bc4_errors[i] = max;
+    }
+}
+
+static float* render_page_dist_scales(int num_glyphs, const DF_Glyph* df_glyphs, const Pack_Rect* rects,
+                                     const Pack_Page* pages, int page)
+{
+    // The dist_scale of the glyph each pixel belongs to, 0 between glyphs
+    int    page_w      = pages[page].w;
+    float* dist_scales = calloc((size_t)page_w * pages[page].h, sizeof(float));
+    if (dist_scales == NULL) {
+        return NULL;
+    }
+
+    for (int i = 0; i < num_glyphs; i++) {
+        if (df_glyphs[i].pixels == NULL || rects[i].page != page) {
+            continue;
+        }
+
+        int w = rects[i].rotated ? df_glyphs[i].h : df_glyphs[i].w;
+        int h = rects[i].rotated ? df_glyphs[i].w : df_glyphs[i].h;
+        for (int y = rects[i].y; y < rects[i].y + h; y++) {
+            for (int x = rects[i].x; x < rects[i].x + w; x++) {
+                dist_scales[x + (size_t)y * page_w] = df_glyphs[i].dist_scale;
+            }
+        }
+    }
+
+    return dist_scales;
+}
+
+static DF_Error write_page(const Args* args, const uint8_t* pixels, int num_glyphs, const DF_Glyph* df_glyphs,
+                           const int* sources, const Pack_Rect* rects, const Pack_Page* pages, int page, int num_pages,
+                           int* bc4_errors)
+{
+    // If `bc4_errors` isn't NULL, the error of each glyph on the page is set
+    int w = pages[page].w;
+    int h = pages[page].h;
+
+    char* path = get_page_path(get_image_path(args), page, num_pages);
+    if (path == NULL) {
+        return DF_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (!args->bc4 && !args->mips) {
+        int written = image_write(path, args->image_format, pixels, w, h, IMAGE_PIXEL_FORMAT_R8, args->png_level, args->threads);
+        free(path);
+        return written ? DF_ERROR_NONE : DF_ERROR_FILE;
+    }
+
+    // Levels past 0 and BC4 blocks are allocated here
+    const uint8_t* levels[IMAGE_MAX_LEVELS] = {pixels};
+    uint8_t*       mips[IMAGE_MAX_LEVELS]   = {0};
+    uint8_t*       blocks[IMAGE_MAX_LEVELS] = {0};
+    int            num_levels               = args->mips ? mips_get_num_levels(w, h) : 1;
+    DF_Error       error                    = DF_ERROR_NONE;
+
+    if (args->mips) {
+        float* dist_scales = render_page_dist_scales(num_glyphs, df_glyphs, rects, pages, page);
+        if (dist_scales == NULL || !mips_generate(pixels, dist_scales, w, h, args->spread, mips)) {
+            error = DF_ERROR_OUT_OF_MEMORY;
+        }
+        free(dist_scales);
+        for (int level = 1; level < num_levels; level++) {
+            levels[level] = mips[level];
+        }
+    }
+
+    for (int level = 0; level < num_levels && args->bc4 && !error; level++) {
+        int level_w, level_h;
+        mips_get_level_size(w, h, level, &level_w, &level_h);
+        blocks[level] = bc4_compress(levels[level], level_w, level_h, args->threads);
+        if (blocks[level] == NULL) {
+            error = DF_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    if (args->bc4 && !error) {
+        for (int level = 0; level < num_levels; level++) {
+            levels[level] = blocks[level];
+        }
+    }
+
+    Image_Pixel_Format pixel_format = args->bc4 ? IMAGE_PIXEL_FORMAT_BC4 : IMAGE_PIXEL_FORMAT_R8;
+    if (!error && !image_write_levels(path, args->image_format, levels, num_levels, w, h, pixel_format)) {
+        error = DF_ERROR_FILE;
+    }
+
+    // Only level 0 is reported, since the other levels aren't meant to match it
+    if (bc4_errors != NULL && !error) {
+        uint8_t* decoded = malloc((size_t)w * h);
+        if (decoded == NULL) {
+            error = DF_ERROR_OUT_OF_MEMORY;
+        }
+        else {
+            bc4_decompress(blocks[0], w, h, decoded);
+            get_bc4_errors(pixels, decoded, num_glyphs, df_glyphs, sources, rects, pages, page, bc4_errors);
+            free(decoded);
+        }
+    }
+
+    for (int level = 0; level < num_levels; level++) {
+        free(mips[level]);
+        free(blocks[level]);
+    }
+    free(path);
+    return error;
+}
+
+static DF_Error write_bc4_report(const Args* args, const Charset* charset, const int* bc4_errors) {
+    FILE* file = fopen(args->bc4_report_path, "w");
+    if (file == NULL) {
+        return DF_ERROR_FILE;
+    }
+
+    int max = 0;
+    for (int i = 0; i < charset->count; i++) {
+        max = bc4_errors[i] > max ? bc4_errors[i] : max;
+    }
+
+    fprintf(file, "max_error=%d\n", max);
+    for (int i = 0; i < charset->count; i++) {
+        fprintf(file, "char=%d, max_error=%d\n", (int)charset->code_points[i], bc4_errors[i]);
+    }
+
+    return fclose(file) == 0 ? DF_ERROR_NONE : DF_ERROR_FILE;
+}
+
+/*
+ * The bundle is little endian, and every section starts on a multiple of
+ * BUNDLE_ALIGNMENT bytes so the client can use it straight from a mapped
+ * file:
+ *
+ *     header        BUNDLE_HEADER_SIZE bytes, see write_bundle
+ *     pages         num_pages records of BUNDLE_PAGE_RECORD_SIZE bytes
+ *     glyphs        num_glyphs Glyph_Infos
+ *     uvs           num_glyphs floats each of u0, v0, u1, v1, the glyph's
+ *                   rect in its page from 0 to 1
+ *     index         BUNDLE_NUM_INDEX_PAGES uint32 offsets of index pages, 0 if
+ *                   none of the page's code points have a glyph, then the
+ *                   index pages, BUNDLE_INDEX_PAGE_SIZE int32 glyph indices + 1
+ *                   (0 if the code point has no glyph)
+ *     pixels        each page's pixels, raw or compressed with zlib
+ *
+ * Keep in sync with dffont_client.c.
+ */
+#define BUNDLE_MAGIC             "DFFB"
+#define BUNDLE_VERSION           2
+#define BUNDLE_ALIGNMENT         64
+#define BUNDLE_HEADER_SIZE       64
+#define BUNDLE_PAGE_RECORD_SIZE  32
+#define BUNDLE_INDEX_PAGE_SIZE   256
+#define BUNDLE_NUM_INDEX_PAGES   (0x110000 / BUNDLE_INDEX_PAGE_SIZE)
+#define BUNDLE_COMPRESSION_NONE  0
+#define BUNDLE_COMPRESSION_ZLIB  1
+#define BUNDLE_ZLIB_LEVEL        6
+
+#define BUNDLE_ALIGN(size) (((size) + BUNDLE_ALIGNMENT - 1) & ~(uint64_t)(BUNDLE_ALIGNMENT - 1))
+
+static void write_u32(uint8_t* data, uint32_t value) {
+    data[0] = value;
+    data[1] = value >> 8;
+    data[2] = value >> 16;
+    data[3] = value >> 24;
+}
+
+static void write_u64(uint8_t* data, uint64_t value) {
+    write_u32(data, (uint32_t)value);
+    write_u32(data + 4, (uint32_t)(value >> 32));
+}
+
+static void write_f32(uint8_t* data, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, 4);
+    write_u32(data, bits);
+}
+
+static DF_Error write_bundle(const Args* args, const Charset* charset, const TTY_Instance* instance, const Glyph_Info* infos,
+                             const Pack_Page* pages, uint8_t* const* page_pixels, int num_pages)
+{
+    int num_glyphs = charset->count;
+
+    // Pages are compressed first since the size of each one is needed for
+    // the page records
+    uint8_t** compressed      = calloc(num_pages, sizeof(uint8_t*));
+    size_t*   compressed_size = calloc(num_pages, sizeof(size_t));
+    if (compressed == NULL || compressed_size == NULL) {
+        free(compressed);
+        free(compressed_size);
+        return DF_ERROR_OUT_OF_MEMORY;
+    }
+
+    DF_Error error = DF_ERROR_NONE;
+    if (args->compress_bundle) {
+        for (int i = 0; i < num_pages && !error; i++) {
+            compressed[i] = zlib_compress(page_pixels[i], (size_t)pages[i].w * pages[i].h, BUNDLE_ZLIB_LEVEL, args->threads, compressed_size + i);
+            if (compressed[i] == NULL) {
+                error = DF_ERROR_OUT_OF_MEMORY;
+            }
+        }
+    }
+
+    int num_index_pages = 0;
+    for (int i = 0; i < num_glyphs; i++) {
+        // Code points are sorted without duplicates (see charset.h), so a new
+        // index page starts whenever the page changes
+        int page = infos[i].codepoint / BUNDLE_INDEX_PAGE_SIZE;
+        if (i == 0 || page != infos[i - 1].codepoint / BUNDLE_INDEX_PAGE_SIZE) {
+            num_index_pages++;
+        }
+    }
+
+    uint64_t pages_off       = BUNDLE_HEADER_SIZE;
+    uint64_t glyphs_off      = BUNDLE_ALIGN(pages_off + (uint64_t)num_pages * BUNDLE_PAGE_RECORD_SIZE);
+    uint64_t uvs_off         = BUNDLE_ALIGN(glyphs_off + (uint64_t)num_glyphs * sizeof(Glyph_Info));
+    uint64_t index_off       = BUNDLE_ALIGN(uvs_off + (uint64_t)num_glyphs * 4 * sizeof(float));
+    uint64_t index_pages_off = BUNDLE_ALIGN(index_off + BUNDLE_NUM_INDEX_PAGES * sizeof(uint32_t));
+    uint64_t pixels_off      = BUNDLE_ALIGN(index_pages_off + (uint64_t)num_index_pages * BUNDLE_INDEX_PAGE_SIZE * sizeof(int32_t));
+
+    // Everything before the pixels is built in memory and written at once
+    uint8_t* data = error ? NULL : calloc(pixels_off, 1);
+    if (data == NULL && !error) {
+        error = DF_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (!error) {
+        memcpy(data, BUNDLE_MAGIC, 4);
+        write_u32(data + 4, BUNDLE_VERSION);
+        write_u32(data + 8, num_glyphs);
+        write_u32(data + 12, args->ppem);
+        write_u32(data + 16, instance->lineGap);
+        write_u32(data + 20, num_pages);
+        write_u32(data + 24, sizeof(Glyph_Info));
+        write_u32(data + 28, 0);
+        write_u64(data + 32, pages_off);
+        write_u64(data + 40, glyphs_off);
+        write_u64(data + 48, uvs_off);
+        write_u64(data + 56, index_off);
+
+        uint64_t page_data_off = pixels_off;
+        for (int i = 0; i < num_pages; i++) {
+            uint8_t* record = data + pages_off + i * BUNDLE_PAGE_RECORD_SIZE;
+            uint64_t size   = compressed[i] != NULL ? compressed_size[i] : (uint64_t)pages[i].w * pages[i].h;
+            write_u32(record, pages[i].w);
+            write_u32(record + 4, pages[i].h);
+            write_u32(record + 8, compressed[i] != NULL ? BUNDLE_COMPRESSION_ZLIB : BUNDLE_COMPRESSION_NONE);
+            write_u32(record + 12, 0);
+            write_u64(record + 16, page_data_off);
+            write_u64(record + 24, size);
+            page_data_off = BUNDLE_ALIGN(page_data_off + size);
+        }
+
+        uint8_t* index_page = NULL;
+        uint64_t next_index_page_off = index_pages_off;
+        for (int i = 0; i < num_glyphs; i++) {
+            const Glyph_Info* info = infos + i;
+            const int32_t*    values = &info->codepoint;
+            for (int j = 0; j < (int)(sizeof(Glyph_Info) / sizeof(int32_t)); j++) {
+                write_u32(data + glyphs_off + i * sizeof(Glyph_Info) + j * 4, values[j]);
+            }
+
+            // Rotated glyphs take up h x w pixels
+            float page_w = (float)pages[info->page].w;
+            float page_h = (float)pages[info->page].h;
+            int   area_w = info->rot ? info->h : info->w;
+            int   area_h = info->rot ? info->w : info->h;
+            write_f32(data + uvs_off + (0 * num_glyphs + i) * 4, (float)info->x / page_w);
+            write_f32(data + uvs_off + (1 * num_glyphs + i) * 4, (float)info->y / page_h);
+            write_f32(data + uvs_off + (2 * num_glyphs + i) * 4, (float)(info->x + area_w) / page_w);
+            write_f32(data + uvs_off + (3 * num_glyphs + i) * 4, (float)(info->y + area_h) / page_h);
+
+            int page = info->codepoint / BUNDLE_INDEX_PAGE_SIZE;
+            if (i == 0 || page != infos[i - 1].codepoint / BUNDLE_INDEX_PAGE_SIZE) {
+                write_u32(data + index_off + page * sizeof(uint32_t), (uint32_t)next_index_page_off);
+                index_page           = data + next_index_page_off;
+                next_index_page_off += BUNDLE_INDEX_PAGE_SIZE * sizeof(int32_t);
+            }
+            write_u32(index_page + (info->codepoint % BUNDLE_INDEX_PAGE_SIZE) * sizeof(int32_t), i + 1);
+        }
+    }
+
+    FILE* file = NULL;
+    if (!error && (file = fopen(args->out_bundle_path, "wb")) == NULL) {
+        error = DF_ERROR_FILE;
+    }
+
+    if (!error) {
+        static const uint8_t padding[BUNDLE_ALIGNMENT];
+
+        int written = fwrite(data, 1, pixels_off, file) == pixels_off;
+        for (int i = 0; i < num_pages && written; i++) {
+            const uint8_t* pixels = compressed[i] != NULL ? compressed[i] : page_pixels[i];
+            size_t         size   = compressed[i] != NULL ? compressed_size[i] : (size_t)pages[i].w * pages[i].h;
+            size_t         pad    = BUNDLE_ALIGN(size) - size;
+            written = fwrite(pixels, 1, size, file) == size && (pad == 0 || fwrite(padding, 1, pad, file) == pad);
+        }
+        written = fclose(file) == 0 && written;
+        if (!written) {
+            error = DF_ERROR_FILE;
+        }
+    }
+
+    for (int i = 0; i < num_pages; i++) {
+        free(compressed[i]);
+    }
+    free(compressed);
+    free(compressed_size);
+    free(data);
+    return error;
+}
+
+DF_Error df_pack_output(const Args* args, const Charset* charset, const TTY_Instance* instance,
+                        const DF_Glyph* df_glyphs, const int* sources, DF_Packed_Output* packed)
+{
+    // Glyphs are packed tallest first, so the order they're placed in doesn't
+    // follow the charset. Padding is included in each rect so neighbouring
+    // glyphs are kept apart.
+    memset(packed, 0, sizeof(DF_Packed_Output));
+    packed->args      = args;
+    packed->charset   = charset;
+    packed->instance  = instance;
+    packed->df_glyphs = df_glyphs;
+    packed->sources   = sources;
+    packed->rects     = calloc(charset->count > 0 ? charset->count : 1, sizeof(Pack_Rect));
+    if (packed->rects == NULL) {
+        return DF_ERROR_OUT_OF_MEMORY;
+    }
+
+    DF_Error error;
+    if ((error = pack_glyphs(args, charset->count, df_glyphs, sources, packed->rects, &packed->pages, &packed->num_pages))) {
+        free(packed->rects);
+        packed->rects = NULL;
+        packed->pages = NULL;
+        return error;
+    }
+    return DF_ERROR_NONE;
+}
+
+void df_packed_output_free(DF_Packed_Output* packed) {
+    free(packed->rects);
+    free(packed->pages);
+}
+
+static DF_Error write_packed_output(const DF_Packed_Output* packed) {
+    const Args*         args      = packed->args;
+    const Charset*      charset   = packed->charset;
+    const TTY_Instance* instance  = packed->instance;
+    const DF_Glyph*     df_glyphs = packed->df_glyphs;
+    const Pack_Rect*    rects     = packed->rects;
+    const Pack_Page*    pages     = packed->pages;
+    int                 num_pages = packed->num_pages;
+
+    Glyph_Info* infos = calloc(charset->count > 0 ? charset->count : 1, sizeof(Glyph_Info));
+    if (infos == NULL) {
+        return DF_ERROR_OUT_OF_MEMORY;
+    }
+
+    get_glyph_infos(args, charset, instance, df_glyphs, packed->sources, rects, infos);
+
+    // With a bundle, the other files are only written if they're asked for
+    int write_bundle_file = args->out_bundle_path != NULL;
+    int write_info        = !write_bundle_file || args->out_font_path != NULL;
+    int write_images      = !write_bundle_file || args->out_image_path != NULL;
+
+    DF_Error error = DF_ERROR_NONE;
+    if (write_info) {
+        error = write_info_file(args, charset, instance, infos, num_pages);
+    }
+
+    // The bundle holds every page, so they're kept until it's written
+    uint8_t** page_pixels = calloc(num_pages, sizeof(uint8_t*));
+    if (page_pixels == NULL && !error) {
+        error = DF_ERROR_OUT_OF_MEMORY;
+    }
+
+    int* bc4_errors = NULL;
+    if (write_images && args->bc4_report_path != NULL && !error) {
+        bc4_errors = calloc(charset->count > 0 ? charset->count : 1, sizeof(int));
+        if (bc4_errors == NULL) {
+            error = DF_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    for (int page = 0; page < num_pages && !error; page++) {
+        page_pixels[page] = render_page(charset->count, df_glyphs, rects, pages, page);
+        if (page_pixels[page] == NULL) {
+            error = DF_ERROR_OUT_OF_MEMORY;
+            break;
+        }
+
+        if (write_images) {
+            error = write_page(args, page_pixels[page], charset->count, df_glyphs, packed->sources, rects, pages, page,
+                               num_pages, bc4_errors);
+        }
+        if (!write_bundle_file) {
+            free(page_pixels[page]);
+            page_pixels[page] = NULL;
+        }
+    }
+
+    if (bc4_errors != NULL && !error) {
+        error = write_bc4_report(args, charset, bc4_errors);
+    }
+    if (write_bundle_file && !error) {
+        error = write_bundle(args, charset, instance, infos, pages, page_pixels, num_pages);
+    }
+
+    if (page_pixels != NULL) {
+        for (int page = 0; page < num_pages; page++) {
+            free(page_pixels[page]);
+        }
+    }
+    free(page_pixels);
+    free(bc4_errors);
+    free(infos);
+    return error;
+}
+
+DF_Error df_write_output(const Args* args, const Charset* charset, const TTY_Instance* instance,
+                         const DF_Glyph* df_glyphs, const int* sources)
+{
+    DF_Packed_Output packed;
+    DF_Error         error;
+    if ((error = df_pack_output(args, charset, instance, df_glyphs, sources, &packed))) {
+        return error;
+    }
+
+    error = write_packed_output(&packed);
+    df_packed_output_free(&packed);
+    return error;
+}
+
+static DF_Error write_shared_page(const DF_Packed_Output* packed, int num_packed, const Pack_Page* pages, int page,
+                                  int num_pages)
+{
+    // Each output is rendered into its own channel of every level. The mip
+    // levels of each channel are generated from its own distances, since
+    // the outputs can have different spreads.
+    const Args* args                     = packed[0].args;
+    int         w                        = pages[page].w;
+    int         h                        = pages[page].h;
+    int         num_levels               = args->mips ? mips_get_num_levels(w, h) : 1;
+    uint8_t*    levels[IMAGE_MAX_LEVELS] = {0};
+    DF_Error    error                    = DF_ERROR_NONE;
+
+    for (int level = 0; level < num_levels && !error; level++) {
+        int level_w, level_h;
+        mips_get_level_size(w, h, level, &level_w, &level_h);
+        levels[level] = calloc((size_t)level_w * level_h, 4);
+        if (levels[level] == NULL) {
+            error = DF_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    for (int i = 0; i < num_packed && !error; i++) {
+        const DF_Packed_Output* output                           = packed + i;
+        uint8_t*                channel_levels[IMAGE_MAX_LEVELS] = {0};
+
+        channel_levels[0] = render_page(output->charset->count, output->df_glyphs, output->rects, pages, page);
+        if (channel_levels[0] == NULL) {
+            error = DF_ERROR_OUT_OF_MEMORY;
+        }
+        if (args->mips && !error) {
+            float* dist_scales = render_page_dist_scales(output->charset->count, output->df_glyphs, output->rects, pages, page);
+            if (dist_scales == NULL || !mips_generate(channel_levels[0], dist_scales, w, h, output->args->spread, channel_levels)) {
+                error = DF_ERROR_OUT_OF_MEMORY;
+            }
+            free(dist_scales);
+        }
+
+        for (int level = 0; level < num_levels && !error; level++) {
+            int level_w, level_h;
+            mips_get_level_size(w, h, level, &level_w, &level_h);
+
+            size_t   num_pixels = (size_t)level_w * level_h;
+            uint8_t* out        = levels[level] + output->args->channel;
+            for (size_t j = 0; j < num_pixels; j++) {
+                out[j * 4] = channel_levels[level][j];
+            }
+        }
+
+        for (int level = 0; level < num_levels; level++) {
+            free(channel_levels[level]);
+        }
+    }
+
+    char* path = error ? NULL : get_page_path(get_image_path(args), page, num_pages);
+    if (path == NULL && !error) {
+        error = DF_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (!error) {
+        int written = num_levels == 1 ?
+            image_write(path, args->image_format, levels[0], w, h, IMAGE_PIXEL_FORMAT_RGBA8, args->png_level, args->threads) :
+            image_write_levels(path, args->image_format, (const uint8_t* const*)levels, num_levels, w, h, IMAGE_PIXEL_FORMAT_RGBA8);
+        if (!written) {
+            error = DF_ERROR_FILE;
+        }
+    }
+
+    for (int level = 0; level < num_levels; level++) {
+        free(levels[level]);
+    }
+    free(path);
+    return error;
+}
+
+DF_Error df_write_shared_outputs(const DF_Packed_Output* packed, int num_packed) {
+    // The image has as many pages as the output with the most, and each page
+    // is as large as the largest of the outputs' pages, so every glyph keeps
+    // the place it was packed at
+    int num_pages = 0;
+    for (int i = 0; i < num_packed; i++) {
+        num_pages = packed[i].num_pages > num_pages ? packed[i].num_pages : num_pages;
+    }
+
+    Pack_Page* pages = calloc(num_pages > 0 ? num_pages : 1, sizeof(Pack_Page));
+    if (pages == NULL) {
+        return DF_ERROR_OUT_OF_MEMORY;
+    }
+    for (int i = 0; i < num_packed; i++) {
+        for (int page = 0; page < packed[i].num_pages; page++) {
+            pages[page].w = packed[i].pages[page].w > pages[page].w ? packed[i].pages[page].w : pages[page].w;
+            pages[page].h = packed[i].pages[page].h > pages[page].h ? packed[i].pages[page].h : pages[page].h;
+        }
+    }
+
+    // Every info file has the image's number of pages, so clients load the
+    // same page files for each output
+    DF_Error error = DF_ERROR_NONE;
+    for (int i = 0; i < num_packed && !error; i++) {
+        const DF_Packed_Output* output = packed + i;
+
+        Glyph_Info* infos = calloc(output->charset->count > 0 ? output->charset->count : 1, sizeof(Glyph_Info));
+        if (infos == NULL) {
+            error = DF_ERROR_OUT_OF_MEMORY;
+            break;
+        }
+        get_glyph_infos(output->args, output->charset, output->instance, output->df_glyphs, output->sources, output->rects,
+                        infos);
+        error = write_info_file(output->args, output->charset, output->instance, infos, num_pages);
+        free(infos);
+    }
+
+    for (int page = 0; page < num_pages && !error; page++) {
+        error = write_shared_page(packed, num_packed, pages, page, num_pages);
+    }
+
+    free(pages);
+    return error;
+}
+
+void df_output_print_error(const Args* args, DF_Error error) {
+    switch (error) {
+        case DF_ERROR_DOES_NOT_FIT:
+            fprintf(stderr, "error: a glyph is larger than the maximum image size of %dx%d\n",
+                    args->out_image_w, args->out_image_h);
+            break;
+        case DF_ERROR_FILE:
+            if (args->out_bundle_path != NULL && args->out_font_path == NULL && args->out_image_path == NULL) {
+                fprintf(stderr, "error: failed to write '%s'\n", args->out_bundle_path);
+            }
+            else {
+                fprintf(stderr, "error: failed to write '%s' or '%s'",
+                        args->out_font_path  == NULL ? "./dffont_info"      : args->out_font_path,
+                        get_image_path(args));
+                if (args->out_bundle_path != NULL) {
+                    fprintf(stderr, " or '%s'", args->out_bundle_path);
+                }
+                if (args->bc4_report_path != NULL) {
+                    fprintf(stderr, " or '%s'", args->bc4_report_path);
+                }
+                fprintf(stderr, "\n");
+            }
+            break;
+        case DF_ERROR_OUT_OF_MEMORY:
+            fprintf(stderr, "error: failed to allocate memory");
+            break;
+        default:
+            fprintf(stderr, "error: an internal font error occurred");
+            break;
+    }
+}
+
+void df_output_error_exit(const Args* args, DF_Error error) {
+    df_output_print_error(args, error);
+    exit(1);
+}
@@ -0,0 +1,64 @@
+#ifndef DFFONT_DF_OUTPUT_H
+#define DFFONT_DF_OUTPUT_H
+
+#include "truety.h"
+#include "args.h"
+#include "charset.h"
+#include "df_glyph.h"
+#include "pack.h"
+
+/*
+ * An output that has been packed but not written. Outputs that share an image
+ * (see `channel` in args.h) are packed on their own, then written together
+ * once every one of them is packed.
+ */
+typedef struct {
+    const Args*         args;
+    const Charset*      charset;
+    const TTY_Instance* instance;
+    const DF_Glyph*     df_glyphs; /* Kept until the output is written */
+    const int*          sources;   /* NULL if no glyphs were deduplicated */
+    Pack_Rect*          rects;     /* Indexed the same as df_glyphs */
+    Pack_Page*          pages;
+    int                 num_pages;
+} DF_Packed_Output;
+
+/*
+ * Packs the distance fields of the charset's glyphs into one or more images,
+ * then writes the images and the font info file to the paths in `args`.
+ * `df_glyphs[i]` is the glyph of `charset->code_points[i]`. If `sources` isn't
+ * NULL, glyphs whose source isn't themselves share their source's rect (see
+ * dedup.h) and must not have pixels.
+ *
+ * Returns DF_ERROR_DOES_NOT_FIT if a glyph is larger than the maximum image
+ * size, or DF_ERROR_FILE if a file couldn't be written.
+ */
+DF_Error df_write_output(const Args* args, const Charset* charset, const TTY_Instance* instance,
+                         const DF_Glyph* df_glyphs, const int* sources);
+
+/*
+ * Packs the glyphs like `df_write_output`, without writing anything. The
+ * arguments must outlive `packed`, which is freed with `df_packed_output_free`.
+ */
+DF_Error df_pack_output(const Args* args, const Charset* charset, const TTY_Instance* instance,
+                        const DF_Glyph* df_glyphs, const int* sources, DF_Packed_Output* packed);
+
+void df_packed_output_free(DF_Packed_Output* packed);
+
+/*
+ * Writes the font info file of each output, and one RGBA image that they
+ * share, with each output's glyphs in channel `args->channel`. The outputs
+ * must have the same image path, size, format, PNG level, and mips, and
+ * different channels. The image has as many pages as the output with the
+ * most, each as large as the largest of the outputs' pages, and every info
+ * file is written with that number of pages.
+ */
+DF_Error df_write_shared_outputs(const DF_Packed_Output* packed, int num_packed);
+
+/* Prints the error that `df_write_output` returned */
+void df_output_print_error(const Args* args, DF_Error error);
+
+/* Equivalent to `df_output_print_error`, then exits */
+void df_output_error_exit(const Args* args, DF_Error error);
+
+#endif
@@ -0,0 +1,17 @@
+#include "hash.h"
+
+#define FNV_PRIME 0x100000001b3ULL
+
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t fnv1a_u32(uint64_t hash, uint32_t value) {
+    uint8_t bytes[4] = {value, value >> 8, value >> 16, value >> 24};
+    return fnv1a(hash, bytes, 4);
+}
@@ -0,0 +1,15 @@
+#ifndef DFFONT_HASH_H
+#define DFFONT_HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+
+/* Continues a 64-bit FNV-1a hash, start with FNV_OFFSET_BASIS */
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size);
+
+/* Hashes the value byte by byte so the result doesn't depend on endianness */
+uint64_t fnv1a_u32(uint64_t hash, uint32_t value);
+
+#endif
@@ -0,0 +1,437 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "image.h"
+#include "deflate.h"
+#include "bc4.h"
+#include "mips.h"
+
+#define PNG_FILTER_NONE  0
+#define PNG_FILTER_SUB   1
+#define PNG_FILTER_UP    2
+#define PNG_FILTER_AVG   3
+#define PNG_FILTER_PAETH 4
+
+#define PNG_COLOR_GRAYSCALE 0
+#define PNG_COLOR_RGBA      6
+
+#define KTX2_VK_FORMAT_R8_UNORM       9
+#define KTX2_VK_FORMAT_R8G8B8A8_UNORM 37
+#define KTX2_VK_FORMAT_BC4_UNORM      139
+#define KTX2_HEADER_SIZE              80
+#define KTX2_LEVEL_INDEX_SIZE         24
+#define KTX2_DFD_SIZE(num_samples)    (28 + 16 * (num_samples))
+
+#define DDS_HEADER_SIZE               124
+#define DDS_DX10_HEADER_SIZE          20
+#define DDS_DXGI_FORMAT_R8_UNORM      61
+#define DDS_DXGI_FORMAT_R8G8B8A8_UNORM 28
+#define DDS_DXGI_FORMAT_BC4_UNORM     80
+
+static void write_u32_le(uint8_t* data, uint32_t value) {
+    data[0] = value;
+    data[1] = value >> 8;
+    data[2] = value >> 16;
+    data[3] = value >> 24;
+}
+
+static void write_u64_le(uint8_t* data, uint64_t value) {
+    write_u32_le(data, (uint32_t)value);
+    write_u32_le(data + 4, (uint32_t)(value >> 32));
+}
+
+static void write_u32_be(uint8_t* data, uint32_t value) {
+    data[0] = value >> 24;
+    data[1] = value >> 16;
+    data[2] = value >> 8;
+    data[3] = value;
+}
+
+int image_parse_format(const char* name, Image_Format* format) {
+    if (strcmp(name, "png") == 0) {
+        *format = IMAGE_FORMAT_PNG;
+    }
+    else if (strcmp(name, "raw") == 0) {
+        *format = IMAGE_FORMAT_RAW;
+    }
+    else if (strcmp(name, "ktx2") == 0) {
+        *format = IMAGE_FORMAT_KTX2;
+    }
+    else if (strcmp(name, "dds") == 0) {
+        *format = IMAGE_FORMAT_DDS;
+    }
+    else {
+        return 0;
+    }
+    return 1;
+}
+
+static int paeth(int a, int b, int c) {
+    int p  = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+static int png_filter_row(uint8_t* out, const uint8_t* row, const uint8_t* prev_row, int size, int bpp, int filter) {
+    // Returns the sum of the absolute values of the filtered bytes. Each byte
+    // is filtered against the same channel of its neighbours, the first pixel
+    // has no left neighbour, and `prev_row` is all zeros for the first row.
+    int sum = 0;
+    switch (filter) {
+        case PNG_FILTER_SUB:
+            memcpy(out, row, bpp);
+            for (int x = bpp; x < size; x++) {
+                out[x] = row[x] - row[x - bpp];
+            }
+            break;
+        case PNG_FILTER_UP:
+            for (int x = 0; x < size; x++) {
+                out[x] = row[x] - prev_row[x];
+            }
+            break;
+        case PNG_FILTER_AVG:
+            for (int x = 0; x < bpp; x++) {
+                out[x] = row[x] - (prev_row[x] >> 1);
+            }
+            for (int x = bpp; x < size; x++) {
+                out[x] = row[x] - ((row[x - bpp] + prev_row[x]) >> 1);
+            }
+            break;
+        case PNG_FILTER_PAETH:
+            for (int x = 0; x < bpp; x++) {
+                out[x] = row[x] - prev_row[x];
+            }
+            for (int x = bpp; x < size; x++) {
+                out[x] = row[x] - paeth(row[x - bpp], prev_row[x], prev_row[x - bpp]);
+            }
+            break;
+        default:
+            memcpy(out, row, size);
+            break;
+    }
+    for (int x = 0; x < size; x++) {
+        sum += abs((int8_t)out[x]);
+    }
+    return sum;
+}
+
+static uint8_t* png_filter(const uint8_t* pixels, int w, int h, int bpp, int level) {
+    // Each row is prefixed with the filter that gives the smallest sum of
+    // absolute differences, which usually compresses best. Stored images
+    // aren't compressed, so filtering them would be wasted work.
+    int      size      = w * bpp;
+    size_t   stride    = (size_t)size + 1;
+    uint8_t* out       = malloc(stride * h);
+    uint8_t* zero_row  = calloc(size, 1);
+    uint8_t* candidate = malloc(size);
+    if (out == NULL || zero_row == NULL || candidate == NULL) {
+        free(out);
+        free(zero_row);
+        free(candidate);
+        return NULL;
+    }
+
+    for (int y = 0; y < h; y++) {
+        const uint8_t* row      = pixels + (size_t)y * size;
+        const uint8_t* prev_row = y > 0 ? row - size : zero_row;
+        uint8_t*       out_row  = out + y * stride;
+
+        out_row[0] = PNG_FILTER_NONE;
+        if (level == 0) {
+            memcpy(out_row + 1, row, size);
+            continue;
+        }
+
+        // The best row so far is kept in out_row
+        int best_sum = png_filter_row(out_row + 1, row, prev_row, size, bpp, PNG_FILTER_NONE);
+        for (int filter = PNG_FILTER_SUB; filter <= PNG_FILTER_PAETH && best_sum > 0; filter++) {
+            int sum = png_filter_row(candidate, row, prev_row, size, bpp, filter);
+            if (sum < best_sum) {
+                best_sum   = sum;
+                out_row[0] = filter;
+                memcpy(out_row + 1, candidate, size);
+            }
+        }
+    }
+
+    free(zero_row);
+    free(candidate);
+    return out;
+}
+
+static void png_crc_init(uint32_t* table) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int j = 0; j < 8; j++) {
+            crc = crc & 1 ? 0xedb88320 ^ (crc >> 1) : crc >> 1;
+        }
+        table[i] = crc;
+    }
+}
+
+static uint32_t png_crc(const uint32_t* table, uint32_t crc, const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static int png_write_chunk(FILE* file, const uint32_t* crc_table, const char* type, const uint8_t* data, size_t size) {
+    uint8_t header[8];
+    uint8_t footer[4];
+    write_u32_be(header, (uint32_t)size);
+    memcpy(header + 4, type, 4);
+
+    uint32_t crc = png_crc(crc_table, 0xffffffff, header + 4, 4);
+    crc = png_crc(crc_table, crc, data, size);
+    write_u32_be(footer, crc ^ 0xffffffff);
+
+    return fwrite(header, 1, 8, file) == 8 &&
+           (size == 0 || fwrite(data, 1, size, file) == size) &&
+           fwrite(footer, 1, 4, file) == 4;
+}
+
+static int png_write(const char* path, const uint8_t* pixels, int w, int h, int bpp, int level, int num_threads) {
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+    uint8_t* filtered = png_filter(pixels, w, h, bpp, level);
+    if (filtered == NULL) {
+        return 0;
+    }
+
+    size_t   zlib_size;
+    uint8_t* zlib = zlib_compress(filtered, ((size_t)w * bpp + 1) * h, level, num_threads, &zlib_size);
+    free(filtered);
+    if (zlib == NULL) {
+        return 0;
+    }
+
+    // Width, height, 8-bit depth, grayscale or RGBA, then the default
+    // compression, filter, and interlace methods
+    uint8_t ihdr[13] = {0};
+    write_u32_be(ihdr, w);
+    write_u32_be(ihdr + 4, h);
+    ihdr[8] = 8;
+    ihdr[9] = bpp == 4 ? PNG_COLOR_RGBA : PNG_COLOR_GRAYSCALE;
+
+    uint32_t crc_table[256];
+    png_crc_init(crc_table);
+
+    int   written = 0;
+    FILE* file    = fopen(path, "wb");
+    if (file != NULL) {
+        written = fwrite(signature, 1, 8, file) == 8 &&
+                  png_write_chunk(file, crc_table, "IHDR", ihdr, 13) &&
+                  png_write_chunk(file, crc_table, "IDAT", zlib, zlib_size) &&
+                  png_write_chunk(file, crc_table, "IEND", NULL, 0);
+        written = fclose(file) == 0 && written;
+    }
+
+    free(zlib);
+    return written;
+}
+
+static uint64_t get_level_size(int w, int h, int level, Image_Pixel_Format pixel_format) {
+    int level_w, level_h;
+    mips_get_level_size(w, h, level, &level_w, &level_h);
+    switch (pixel_format) {
+        case IMAGE_PIXEL_FORMAT_BC4:
+            return bc4_get_size(level_w, level_h);
+        case IMAGE_PIXEL_FORMAT_RGBA8:
+            return (uint64_t)level_w * level_h * 4;
+        default:
+            return (uint64_t)level_w * level_h;
+    }
+}
+
+static int write_levels(const char* path, const uint8_t* header, size_t header_size, const uint8_t* const* levels,
+                        const uint64_t* offsets, const uint64_t* sizes, int num_levels, int smallest_first)
+{
+    // Levels are written in file order, with zeros up to each one's offset
+    static const uint8_t zeros[8];
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    uint64_t pos     = header_size;
+    int      written = header_size == 0 || fwrite(header, 1, header_size, file) == header_size;
+    for (int i = 0; i < num_levels && written; i++) {
+        int level = smallest_first ? num_levels - 1 - i : i;
+        size_t pad = (size_t)(offsets[level] - pos);
+        written = (pad == 0 || fwrite(zeros, 1, pad, file) == pad) &&
+                  fwrite(levels[level], 1, (size_t)sizes[level], file) == sizes[level];
+        pos = offsets[level] + sizes[level];
+    }
+    return fclose(file) == 0 && written;
+}
+
+static int ktx2_write(const char* path, const uint8_t* const* levels, int num_levels, int w, int h,
+                      Image_Pixel_Format pixel_format)
+{
+    // The header, level index, and data format descriptor. There's no
+    // key/value data, so the levels follow the descriptor, smallest first,
+    // each aligned to 4 bytes, or 8 for BC4 blocks.
+    static const uint8_t identifier[12] = {0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n'};
+
+    int      bc4         = pixel_format == IMAGE_PIXEL_FORMAT_BC4;
+    int      num_samples = pixel_format == IMAGE_PIXEL_FORMAT_RGBA8 ? 4 : 1;
+    uint32_t dfd_size    = KTX2_DFD_SIZE(num_samples);
+    uint8_t  header[KTX2_HEADER_SIZE + IMAGE_MAX_LEVELS * KTX2_LEVEL_INDEX_SIZE + KTX2_DFD_SIZE(4)] = {0};
+    uint32_t dfd_off     = KTX2_HEADER_SIZE + num_levels * KTX2_LEVEL_INDEX_SIZE;
+    uint32_t header_size = dfd_off + dfd_size;
+    uint64_t alignment   = bc4 ? BC4_BLOCK_SIZE : 4;
+    uint64_t offsets[IMAGE_MAX_LEVELS];
+    uint64_t sizes[IMAGE_MAX_LEVELS];
+
+    uint64_t pos = header_size;
+    for (int level = num_levels - 1; level >= 0; level--) {
+        sizes[level]   = get_level_size(w, h, level, pixel_format);
+        offsets[level] = (pos + alignment - 1) / alignment * alignment;
+        pos            = offsets[level] + sizes[level];
+    }
+
+    uint32_t vk_format = bc4 ? KTX2_VK_FORMAT_BC4_UNORM :
+                         num_samples == 4 ? KTX2_VK_FORMAT_R8G8B8A8_UNORM : KTX2_VK_FORMAT_R8_UNORM;
+
+    memcpy(header, identifier, 12);
+    write_u32_le(header + 12, vk_format);
+    write_u32_le(header + 16, 1); // typeSize
+    write_u32_le(header + 20, w);
+    write_u32_le(header + 24, h);
+    write_u32_le(header + 28, 0); // pixelDepth
+    write_u32_le(header + 32, 0); // layerCount
+    write_u32_le(header + 36, 1); // faceCount
+    write_u32_le(header + 40, num_levels);
+    write_u32_le(header + 44, 0); // supercompressionScheme
+    write_u32_le(header + 48, dfd_off);
+    write_u32_le(header + 52, dfd_size);
+
+    for (int level = 0; level < num_levels; level++) {
+        uint8_t* index = header + KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_SIZE;
+        write_u64_le(index, offsets[level]);
+        write_u64_le(index + 8, sizes[level]);
+        write_u64_le(index + 16, sizes[level]);
+    }
+
+    // A basic descriptor block with a 64-bit BC4 block of 4x4 texels, or an
+    // 8-bit sample for each channel
+    uint8_t* dfd = header + dfd_off;
+    write_u32_le(dfd, dfd_size);
+    write_u32_le(dfd + 4, 0);                          // vendorId, descriptorType
+    write_u32_le(dfd + 8, 2 | ((dfd_size - 4) << 16)); // versionNumber, descriptorBlockSize
+    dfd[12] = bc4 ? 131 : 1;                           // KHR_DF_MODEL_BC4 or KHR_DF_MODEL_RGBSDA
+    dfd[13] = 1;                                       // KHR_DF_PRIMARIES_BT709
+    dfd[14] = 1;                                       // KHR_DF_TRANSFER_LINEAR
+    if (bc4) {
+        dfd[16] = 3;                                   // texelBlockDimension0 - 1
+        dfd[17] = 3;                                   // texelBlockDimension1 - 1
+    }
+    dfd[20] = bc4 ? BC4_BLOCK_SIZE : num_samples;      // bytesPlane0
+
+    for (int i = 0; i < num_samples; i++) {
+        // Channel 15 is KHR_DF_CHANNEL_RGBSDA_ALPHA, the others are red,
+        // green, and blue, or the BC4 data
+        uint8_t* sample     = dfd + 28 + i * 16;
+        uint32_t bit_length = bc4 ? 64 : 8;
+        uint32_t channel    = i == 3 ? 15 : i;
+        write_u32_le(sample, (i * 8) | ((bit_length - 1) << 16) | (channel << 24));
+        write_u32_le(sample + 8, 0);                       // sampleLower
+        write_u32_le(sample + 12, bc4 ? 0xffffffff : 255); // sampleUpper
+    }
+
+    return write_levels(path, header, header_size, levels, offsets, sizes, num_levels, 1);
+}
+
+static int dds_write(const char* path, const uint8_t* const* levels, int num_levels, int w, int h,
+                     Image_Pixel_Format pixel_format)
+{
+    uint8_t  header[4 + DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE] = {0};
+    uint64_t offsets[IMAGE_MAX_LEVELS];
+    uint64_t sizes[IMAGE_MAX_LEVELS];
+    int      bc4 = pixel_format == IMAGE_PIXEL_FORMAT_BC4;
+    int      bpp = pixel_format == IMAGE_PIXEL_FORMAT_RGBA8 ? 4 : 1;
+
+    // The levels follow the header, largest first
+    uint64_t pos = sizeof(header);
+    for (int level = 0; level < num_levels; level++) {
+        sizes[level]   = get_level_size(w, h, level, pixel_format);
+        offsets[level] = pos;
+        pos           += sizes[level];
+    }
+
+    // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT, then
+    // DDSD_LINEARSIZE with the size of the blocks or DDSD_PITCH with the
+    // size of a row, and DDSD_MIPMAPCOUNT if there's more than one level
+    memcpy(header, "DDS ", 4);
+    write_u32_le(header + 4, DDS_HEADER_SIZE);
+    write_u32_le(header + 8, 0x1 | 0x2 | 0x4 | 0x1000 | (bc4 ? 0x80000 : 0x8) | (num_levels > 1 ? 0x20000 : 0));
+    write_u32_le(header + 12, h);
+    write_u32_le(header + 16, w);
+    write_u32_le(header + 20, bc4 ? (uint32_t)sizes[0] : (uint32_t)w * bpp);
+    write_u32_le(header + 28, num_levels);
+
+    // The pixel format says the format is in the DX10 header
+    write_u32_le(header + 76, 32);
+    write_u32_le(header + 80, 0x4); // DDPF_FOURCC
+    memcpy(header + 84, "DX10", 4);
+
+    // DDSCAPS_TEXTURE, and DDSCAPS_COMPLEX | DDSCAPS_MIPMAP for mip chains
+    write_u32_le(header + 108, 0x1000 | (num_levels > 1 ? 0x8 | 0x400000 : 0));
+
+    uint8_t* dx10 = header + 4 + DDS_HEADER_SIZE;
+    write_u32_le(dx10, bc4 ? DDS_DXGI_FORMAT_BC4_UNORM : bpp == 4 ? DDS_DXGI_FORMAT_R8G8B8A8_UNORM : DDS_DXGI_FORMAT_R8_UNORM);
+    write_u32_le(dx10 + 4, 3); // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+    write_u32_le(dx10 + 12, 1); // arraySize
+
+    return write_levels(path, header, sizeof(header), levels, offsets, sizes, num_levels, 0);
+}
+
+static int raw_write(const char* path, const uint8_t* const* levels, int num_levels, int w, int h,
+                     Image_Pixel_Format pixel_format)
+{
+    uint64_t offsets[IMAGE_MAX_LEVELS];
+    uint64_t sizes[IMAGE_MAX_LEVELS];
+
+    uint64_t pos = 0;
+    for (int level = 0; level < num_levels; level++) {
+        sizes[level]   = get_level_size(w, h, level, pixel_format);
+        offsets[level] = pos;
+        pos           += sizes[level];
+    }
+    return write_levels(path, NULL, 0, levels, offsets, sizes, num_levels, 0);
+}
+
+int image_write(const char* path, Image_Format format, const uint8_t* pixels, int w, int h,
+                Image_Pixel_Format pixel_format, int png_level, int num_threads)
+{
+    if (format == IMAGE_FORMAT_PNG) {
+        return pixel_format != IMAGE_PIXEL_FORMAT_BC4 &&
+               png_write(path, pixels, w, h, pixel_format == IMAGE_PIXEL_FORMAT_RGBA8 ? 4 : 1, png_level, num_threads);
+    }
+    return image_write_levels(path, format, &pixels, 1, w, h, pixel_format);
+}
+
+int image_write_levels(const char* path, Image_Format format, const uint8_t* const* levels, int num_levels,
+                       int w, int h, Image_Pixel_Format pixel_format)
+{
+    if (num_levels < 1 || num_levels > IMAGE_MAX_LEVELS) {
+        return 0;
+    }
+    switch (format) {
+        case IMAGE_FORMAT_RAW:
+            return raw_write(path, levels, num_levels, w, h, pixel_format);
+        case IMAGE_FORMAT_KTX2:
+            return ktx2_write(path, levels, num_levels, w, h, pixel_format);
+        case IMAGE_FORMAT_DDS:
+            return dds_write(path, levels, num_levels, w, h, pixel_format);
+        default:
+            return 0;
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef DFFONT_IMAGE_H
+#define DFFONT_IMAGE_H
+
+#include <stdint.h>
+
+typedef enum {
+    IMAGE_FORMAT_PNG,  /* Grayscale or RGBA */
+    IMAGE_FORMAT_RAW,  /* The pixels or BC4 blocks of each level with no header */
+    IMAGE_FORMAT_KTX2, /* VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, or VK_FORMAT_BC4_UNORM_BLOCK */
+    IMAGE_FORMAT_DDS,  /* DXGI_FORMAT_R8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM, or DXGI_FORMAT_BC4_UNORM, using the DX10 header */
+} Image_Format;
+
+typedef enum {
+    IMAGE_PIXEL_FORMAT_R8,    /* One byte per pixel */
+    IMAGE_PIXEL_FORMAT_RGBA8, /* Four bytes per pixel, red first */
+    IMAGE_PIXEL_FORMAT_BC4,   /* Blocks from `bc4_compress` */
+} Image_Pixel_Format;
+
+#define IMAGE_DEFAULT_PNG_LEVEL 6
+#define IMAGE_MAX_LEVELS        32 /* Enough for a full mip chain of any size */
+
+/* Returns 1 and sets `format` if `name` is png, raw, ktx2, or dds, otherwise returns 0 */
+int image_parse_format(const char* name, Image_Format* format);
+
+/*
+ * Writes a one or four channel, 8-bit image. PNGs are compressed at
+ * `png_level` (0-9, 0 stores the pixels uncompressed) using `num_threads`
+ * threads. Returns 1 on success, 0 if the file couldn't be written or memory
+ * couldn't be allocated.
+ */
+int image_write(const char* path, Image_Format format, const uint8_t* pixels, int w, int h,
+                Image_Pixel_Format pixel_format, int png_level, int num_threads);
+
+/*
+ * Writes a raw, KTX2, or DDS image with `num_levels` mip levels. Level i is
+ * max(w >> i, 1) x max(h >> i, 1) pixels, and `levels[i]` holds its pixels,
+ * or its blocks if the pixel format is BC4. Raw images hold the levels one
+ * after another, largest first. PNGs can't hold mip levels or BC4 blocks.
+ * Returns 1 on success, 0 if the file couldn't be written.
+ */
+int image_write_levels(const char* path, Image_Format format, const uint8_t* const* levels, int num_levels,
+                       int w, int h, Image_Pixel_Format pixel_format);
+
+#endif
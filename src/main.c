@@ -3,171 +3,133 @@
 #include <stdio.h>
 #include "truety.h"
 #include "args.h"
-#include "df.h"
-
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
-
-#define STB_IMAGE_RESIZE_IMPLEMENTATION
-#include "stb_image_resize.h"
-
-#define FIRST_CHAR ' '
-#define LAST_CHAR  '~'
-#define NUM_CHARS  (LAST_CHAR - FIRST_CHAR + 1)
+#include "df_glyph.h"
+#include "charset.h"
+#include "df_output.h"
+#include "batch.h"
+#include "tile_cache.h"
+#include "dedup.h"
 
 int main(int argc, char** argv) {
     Args args = {0};
     parse_args(&args, argc, argv);
 
+    if (args.manifest_path != NULL) {
+        run_batch(&args);
+        return 0;
+    }
+
     TTY_Font font;
     if (tty_font_init(&font, args.ttf_path)) {
         fprintf(stderr, "error: '%s': Failed to load\n", args.ttf_path);
         exit(1);
     }
 
-    TTY_Instance instance;
-    if (tty_instance_init(&font, &instance, args.ppem * args.scale, TTY_INSTANCE_NO_HINTING)) {
-        goto internal_font_error;
+    // Everything below is freed before returning whether or not an error
+    // occurs, so it's all declared up front
+    TTY_Instance  instance         = {0};
+    Charset       charset          = {0};
+    Dedup         dedup            = {0};
+    TTY_Glyph*    glyphs           = NULL;
+    DF_Glyph*     df_glyphs        = NULL;
+    TTY_Glyph*    unique_glyphs    = NULL;
+    DF_Glyph*     unique_df_glyphs = NULL;
+    Tile_Cache    tile_cache;
+    Tile_Cache*   tile_cache_ptr   = NULL;
+    DF_Error      error            = DF_ERROR_NONE;
+
+    // Charsets can have tens of thousands of code points, so lookups should
+    // be O(1)
+    if (tty_font_init_glyph_index_map(&font)) {
+        error = DF_ERROR_OUT_OF_MEMORY;
+        goto print_error;
     }
 
-    FILE* font_info_file;
-    {
-        const char* path = args.out_font_path == NULL ? "./dffont_info" : args.out_font_path;
-        font_info_file = fopen(path, "w");
-        if (font_info_file == NULL) {
-            fprintf(stderr, "error: '%s': failed to create font info file", path);
-            exit(1);
-        }
+    if (tty_instance_init(&font, &instance, args.ppem * args.scale, TTY_INSTANCE_NO_HINTING | TTY_INSTANCE_BINARY)) {
+        error = DF_ERROR_FONT;
+        goto print_error;
     }
-    fprintf(font_info_file, "num_glyphs=%d\n", NUM_CHARS);
-    fprintf(font_info_file, "ppem=%d\n", args.ppem);
-    fprintf(font_info_file, "line_gap=%d\n", instance.lineGap);
-
-    int spread_size = 2 * args.spread;
 
-    DF df = {0};
-    df.w = instance.maxGlyphSize.x + args.scale * spread_size;
-    df.h = instance.maxGlyphSize.y + args.scale * spread_size;
-    df.spread = args.scale * args.spread;
+    charset_init(&charset, args.charset, &font);
 
-    uint8_t* down_pixels = NULL; // The destination buffer for stb_image_resize
-    int down_w = instance.maxGlyphSize.x / args.scale + spread_size;
-    int down_h = instance.maxGlyphSize.y / args.scale + spread_size;
-
-    uint8_t* out_pixels = NULL; // Size for the output image is stored in args
-
-    {
-        int off              = 0;
-        int dim              = df.w > df.h ? df.w : df.h;
-        int dists_size       = df.w * df.h * sizeof(float);
-        int xinters_size     = dim * sizeof(float);
-        int verts_size       = dim * sizeof(Vec2);
-        int df_pixels_size   = df.w * df.h;
-        int down_pixels_size = down_w * down_h;
-        int out_pixels_size  = args.out_image_w * args.out_image_h;
-        uint8_t* mem = calloc(dists_size + xinters_size + verts_size + df_pixels_size + down_pixels_size + out_pixels_size, 1);
-        if (mem == NULL) {
-            goto out_of_memory;
-        }
-        df.dists    = (float*)(mem);
-        df.xinters  = (float*)(mem + (off += dists_size));
-        df.verts    = (Vec2*) (mem + (off += xinters_size));
-        df.pixels   =         (mem + (off += verts_size));
-        down_pixels =         (mem + (off += df_pixels_size));
-        out_pixels  =         (mem + (off += down_pixels_size));
-    }
-
-    TTY_U32 x = args.padding[0];
-    TTY_U32 y = args.padding[2];
-    TTY_U32 largest_h = 0;
-    
-    #define WRITE_GLYPH()\
-    {\
-        fprintf(\
-            font_info_file, "char=%d, x=%d, y=%d, w=%d, h=%d, xoff=%d, yoff=%d, xadv=%d, yadv=%d\n",\
-            (int)c, (int)x, (int)y, glyph_w, glyph_h,\
-            (int)glyph.offset.x / args.scale, (int)(instance.ascender - glyph.offset.y) / args.scale,\
-            (int)glyph.advance.x / args.scale, (int)glyph.advance.y / args.scale);\
-    }
-
-    for (char c = FIRST_CHAR; c <= LAST_CHAR; c++) {
-        TTY_U32   glyphIdx;
-        TTY_Glyph glyph;
-
-        if (tty_get_glyph_index(&font, c, &glyphIdx) ||
-            tty_glyph_init(&font, &glyph, glyphIdx))
-        {
-            goto internal_font_error;
-        }
-        
-        {
-            TTY_Image image = {
-                .pixels = df.pixels, 
-                .size = {.x = df.w, .y = df.h}
-            };
-
-            if (tty_render_glyph_to_existing_image(&font, &instance, &glyph, &image, df.spread, df.spread)) {
-                goto internal_font_error;
-            }
-        }
-        
-        int glyph_h = glyph.size.y / args.scale + spread_size;
-        int glyph_w = glyph.size.x / args.scale + spread_size;
-        
-        if (c == ' ') {
-            WRITE_GLYPH();
-            continue;
-        }
+    // df_glyphs is zeroed so the pixels can be freed if an error occurs
+    // before all of them are generated
+    glyphs    = malloc((charset.count > 0 ? charset.count : 1) * sizeof(TTY_Glyph));
+    df_glyphs = calloc(charset.count > 0 ? charset.count : 1, sizeof(DF_Glyph));
+    if (glyphs == NULL || df_glyphs == NULL) {
+        error = DF_ERROR_OUT_OF_MEMORY;
+        goto print_error;
+    }
 
-        calc_df(&df);
+    if (tty_glyphs_init(&font, charset.glyph_indices, charset.count, glyphs)) {
+        error = DF_ERROR_FONT;
+        goto print_error;
+    }
 
-        if (!stbir_resize_uint8(df.pixels, df.w, df.h, df.w, 
-                                down_pixels, down_w, down_h, down_w, 
-                                1))
-        {
-            goto out_of_memory;
+    if (args.cache_dir != NULL) {
+        if ((error = tile_cache_init(&tile_cache, args.cache_dir, &font, args.ppem, args.scale, args.spread))) {
+            fprintf(stderr, "error: '%s': failed to create cache directory\n", args.cache_dir);
+            goto cleanup;
         }
+        tile_cache_ptr = &tile_cache;
+    }
 
-        memset(df.pixels, 0, df.w * df.h);
-
-        if (x + glyph_w > args.out_image_w) {
-            x = args.padding[0];
-            y += largest_h + args.padding[2] + args.padding[3];
-            largest_h = 0;
-        }
-        
-        // if (x + (y + glyph_h - 1) * args.out_image_w >= args.out_image_w * args.out_image_h)
-        if (y + glyph_h > args.out_image_h) {
-            fprintf(stderr, "warning: output image not large enough to hold all glyphs\n");
-            break;
-        }
+    // Code points that map to the same glyph, and optionally glyphs with the
+    // same outline, only have their distance field generated once
+    if ((error = dedup_init(&dedup, &font, glyphs, charset.count, args.dedup_outlines))) {
+        goto print_error;
+    }
 
-        for (int yi = 0; yi < glyph_h; yi++) {
-            uint8_t* out = out_pixels + (x + (yi + y) * args.out_image_w);
-            uint8_t* down = down_pixels + (yi * down_w);
-            memcpy(out, down, glyph_w);
-        }
+    unique_glyphs    = malloc((dedup.num_unique > 0 ? dedup.num_unique : 1) * sizeof(TTY_Glyph));
+    unique_df_glyphs = malloc((dedup.num_unique > 0 ? dedup.num_unique : 1) * sizeof(DF_Glyph));
+    if (unique_glyphs == NULL || unique_df_glyphs == NULL) {
+        error = DF_ERROR_OUT_OF_MEMORY;
+        goto print_error;
+    }
+    for (int i = 0; i < dedup.num_unique; i++) {
+        unique_glyphs[i] = glyphs[dedup.unique[i]];
+    }
 
-        if (glyph_h > largest_h) {
-            largest_h = glyph_h;
-        }
-        
-        WRITE_GLYPH();
+    // The distance fields are generated in parallel, then packed on this
+    // thread so the output doesn't depend on the number of threads. The
+    // unique glyphs' pixels are owned by df_glyphs once they're copied.
+    if ((error = df_render_glyphs(&font, &instance, args.scale, args.spread, tile_cache_ptr,
+                                  unique_glyphs, dedup.num_unique, args.threads, unique_df_glyphs)))
+    {
+        goto print_error;
+    }
 
-        x += glyph_w + args.padding[0] + args.padding[1];
+    for (int i = 0; i < dedup.num_unique; i++) {
+        df_glyphs[dedup.unique[i]] = unique_df_glyphs[i];
+    }
+    if ((error = dedup_fill(&dedup, &font, &instance, glyphs, charset.count, df_glyphs))) {
+        goto print_error;
     }
 
-    stbi_write_png(
-        args.out_image_path == NULL ? "./dffont_image.png" : args.out_image_path, 
-        args.out_image_w, args.out_image_h, 1, out_pixels, args.out_image_w);
+    if ((error = df_write_output(&args, &charset, &instance, df_glyphs, dedup.sources))) {
+        goto print_error;
+    }
 
-    return 0;
+    if (args.cache_dir != NULL) {
+        tile_cache_evict(args.cache_dir, args.cache_size);
+    }
+    goto cleanup;
 
-internal_font_error:
-    fprintf(stderr, "error: an internal font error occurred");
-    exit(1);
+print_error:
+    df_output_print_error(&args, error);
 
-out_of_memory:
-    fprintf(stderr, "error: failed to allocate memory");
-    exit(1);
+cleanup:
+    if (df_glyphs != NULL) {
+        df_glyphs_free(df_glyphs, charset.count);
+    }
+    free(glyphs);
+    free(df_glyphs);
+    free(unique_glyphs);
+    free(unique_df_glyphs);
+    dedup_free(&dedup);
+    charset_free(&charset);
+    tty_instance_free(&instance);
+    tty_font_free(&font);
+
+    return error == DF_ERROR_NONE ? 0 : 1;
 }
@@ -0,0 +1,216 @@
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include "mips.h"
+#include "df.h"
+
+/*
+ * The sums over the level 0 pixels that each pixel of a level covers. Sums
+ * are kept instead of averages so pixels on odd edges, which cover fewer
+ * level 0 pixels, are weighted correctly.
+ */
+typedef struct {
+    float* dists;        /* Signed distances in level 0 pixels */
+    float* scales;       /* dist_scales, of pixels that have one */
+    float* counts;       /* Level 0 pixels */
+    float* scale_counts; /* Level 0 pixels that have a dist_scale */
+    int    w;
+    int    h;
+} Mip_Sums;
+
+int mips_get_num_levels(int w, int h) {
+    int num_levels = 1;
+    while (w > 1 || h > 1) {
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+        num_levels++;
+    }
+    return num_levels;
+}
+
+void mips_get_level_size(int w, int h, int level, int* level_w, int* level_h) {
+    *level_w = w >> level > 0 ? w >> level : 1;
+    *level_h = h >> level > 0 ? h >> level : 1;
+}
+
+static int mip_sums_init(Mip_Sums* sums, int w, int h) {
+    size_t size = (size_t)w * h * sizeof(float);
+    sums->dists        = malloc(size);
+    sums->scales       = malloc(size);
+    sums->counts       = malloc(size);
+    sums->scale_counts = malloc(size);
+    sums->w            = w;
+    sums->h            = h;
+    return sums->dists != NULL && sums->scales != NULL && sums->counts != NULL && sums->scale_counts != NULL;
+}
+
+static void mip_sums_free(Mip_Sums* sums) {
+    free(sums->dists);
+    free(sums->scales);
+    free(sums->counts);
+    free(sums->scale_counts);
+}
+
+static int mips_get_dists(const uint8_t* pixels, const float* dist_scales, int w, int h, int spread, float* dists) {
+    // Pixels inside the spread are decoded, the others get their distance to
+    // the nearest decoded pixel past the spread
+    int    dim     = w > h ? w : h;
+    float* xinters = malloc(dim * sizeof(float));
+    Vec2*  verts   = malloc(dim * sizeof(Vec2));
+    if (xinters == NULL || verts == NULL) {
+        free(xinters);
+        free(verts);
+        return 0;
+    }
+
+    size_t num_pixels = (size_t)w * h;
+    for (size_t i = 0; i < num_pixels; i++) {
+        dists[i] = pixels[i] > 0 && dist_scales[i] > 0.0f ? 0.0f : FLT_MAX;
+    }
+
+    DF df = {
+        .dists   = dists,
+        .xinters = xinters,
+        .verts   = verts,
+        .w       = w,
+        .h       = h,
+    };
+    calc_squared_dists(&df);
+
+    for (size_t i = 0; i < num_pixels; i++) {
+        if (dists[i] == 0.0f) {
+            dists[i] = pixels[i] * dist_scales[i] - spread;
+        }
+        else {
+            dists[i] = dists[i] == FLT_MAX ? -FLT_MAX : -spread - sqrtf(dists[i]);
+        }
+    }
+
+    free(xinters);
+    free(verts);
+    return 1;
+}
+
+static void mips_sum_level_1(const float* dists, const float* dist_scales, int w, int h, Mip_Sums* out) {
+    for (int y = 0; y < out->h; y++) {
+        for (int x = 0; x < out->w; x++) {
+            float dist        = 0.0f;
+            float scale       = 0.0f;
+            float count       = 0.0f;
+            float scale_count = 0.0f;
+            for (int sy = 2 * y; sy < 2 * y + 2 && sy < h; sy++) {
+                for (int sx = 2 * x; sx < 2 * x + 2 && sx < w; sx++) {
+                    size_t i = (size_t)sy * w + sx;
+                    dist  += dists[i];
+                    count += 1;
+                    if (dist_scales[i] > 0.0f) {
+                        scale       += dist_scales[i];
+                        scale_count += 1;
+                    }
+                }
+            }
+            size_t i = (size_t)y * out->w + x;
+            out->dists[i]        = dist;
+            out->scales[i]       = scale;
+            out->counts[i]       = count;
+            out->scale_counts[i] = scale_count;
+        }
+    }
+}
+
+static void mips_sum_level(const Mip_Sums* in, Mip_Sums* out) {
+    for (int y = 0; y < out->h; y++) {
+        for (int x = 0; x < out->w; x++) {
+            float dist        = 0.0f;
+            float scale       = 0.0f;
+            float count       = 0.0f;
+            float scale_count = 0.0f;
+            for (int sy = 2 * y; sy < 2 * y + 2 && sy < in->h; sy++) {
+                for (int sx = 2 * x; sx < 2 * x + 2 && sx < in->w; sx++) {
+                    size_t i = (size_t)sy * in->w + sx;
+                    dist        += in->dists[i];
+                    scale       += in->scales[i];
+                    count       += in->counts[i];
+                    scale_count += in->scale_counts[i];
+                }
+            }
+            size_t i = (size_t)y * out->w + x;
+            out->dists[i]        = dist;
+            out->scales[i]       = scale;
+            out->counts[i]       = count;
+            out->scale_counts[i] = scale_count;
+        }
+    }
+}
+
+static void mips_encode_level(const Mip_Sums* sums, int level, int spread, uint8_t* pixels) {
+    // The average distance is measured in this level's pixels, then encoded
+    // with the average dist_scale of the glyphs it covers
+    float  level_size = (float)(1 << level);
+    size_t num_pixels = (size_t)sums->w * sums->h;
+    for (size_t i = 0; i < num_pixels; i++) {
+        if (sums->scale_counts[i] == 0) {
+            pixels[i] = 0;
+            continue;
+        }
+
+        float dist  = sums->dists[i] / sums->counts[i] / level_size;
+        float scale = sums->scales[i] / sums->scale_counts[i];
+        float value = (dist + spread) / scale + 0.5f;
+        pixels[i] = value <= 0.0f ? 0 : value >= 255.0f ? 255 : (uint8_t)value;
+    }
+}
+
+int mips_generate(const uint8_t* pixels, const float* dist_scales, int w, int h, int spread, uint8_t** levels) {
+    int num_levels = mips_get_num_levels(w, h);
+    for (int level = 1; level < num_levels; level++) {
+        levels[level] = NULL;
+    }
+    if (num_levels == 1) {
+        return 1;
+    }
+
+    float* dists = malloc((size_t)w * h * sizeof(float));
+    if (dists == NULL || !mips_get_dists(pixels, dist_scales, w, h, spread, dists)) {
+        free(dists);
+        return 0;
+    }
+
+    // Each level is summed from the one above it, so only two are kept
+    Mip_Sums sums[2] = {0};
+    int      ok      = 1;
+    for (int level = 1; level < num_levels && ok; level++) {
+        Mip_Sums* cur  = sums + level % 2;
+        Mip_Sums* prev = sums + (level + 1) % 2;
+
+        int level_w, level_h;
+        mips_get_level_size(w, h, level, &level_w, &level_h);
+        mip_sums_free(cur);
+
+        levels[level] = malloc((size_t)level_w * level_h);
+        ok = levels[level] != NULL && mip_sums_init(cur, level_w, level_h);
+        if (!ok) {
+            break;
+        }
+
+        if (level == 1) {
+            mips_sum_level_1(dists, dist_scales, w, h, cur);
+        }
+        else {
+            mips_sum_level(prev, cur);
+        }
+        mips_encode_level(cur, level, spread, levels[level]);
+    }
+
+    mip_sums_free(&sums[0]);
+    mip_sums_free(&sums[1]);
+    free(dists);
+
+    if (!ok) {
+        for (int level = 1; level < num_levels; level++) {
+            free(levels[level]);
+            levels[level] = NULL;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,29 @@
+#ifndef DFFONT_MIPS_H
+#define DFFONT_MIPS_H
+
+#include <stdint.h>
+
+/* The number of levels in a full mip chain of a w x h image, down to 1x1 */
+int mips_get_num_levels(int w, int h);
+
+/* The size of a level, which is never smaller than 1x1 */
+void mips_get_level_size(int w, int h, int level, int* level_w, int* level_h);
+
+/*
+ * Generates levels 1 and up of a page's mip chain into `levels[1]` and up,
+ * which must be freed with `free`. `pixels` is level 0, and `dist_scales`
+ * holds the dist_scale (see DF_Glyph) of the glyph each pixel belongs to, or
+ * 0 for pixels between glyphs.
+ *
+ * Averaging the pixel values would pull glyphs' edges outwards, since values
+ * are clamped to 0 past the spread. Instead, the pixels are turned back into
+ * distances, pixels past the spread get their distance to the nearest pixel
+ * that isn't, and the distances are averaged. Each level's distances are then
+ * measured in its own pixels, so every level has the same spread and edge
+ * value as level 0, like a font rendered at that size.
+ *
+ * Returns 0 if memory couldn't be allocated.
+ */
+int mips_generate(const uint8_t* pixels, const float* dist_scales, int w, int h, int spread, uint8_t** levels);
+
+#endif
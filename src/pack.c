@@ -0,0 +1,314 @@
+#include <stdlib.h>
+#include <string.h>
+#include "pack.h"
+
+/* A horizontal segment of the skyline, everything below it is used */
+typedef struct {
+    int x;
+    int y;
+    int w;
+} Skyline_Node;
+
+typedef struct {
+    Skyline_Node* nodes;
+    int           num_nodes;
+    int           bin_w;
+    int           bin_h;
+} Skyline;
+
+/* What rects are sorted by, stored next to the index since qsort has no user data parameter */
+typedef struct {
+    int h;
+    int w;
+    int idx;
+} Pack_Sort_Key;
+
+static int compare_rects(const void* a, const void* b) {
+    const Pack_Sort_Key* ka = (const Pack_Sort_Key*)a;
+    const Pack_Sort_Key* kb = (const Pack_Sort_Key*)b;
+
+    // Tallest first, then widest first. The index breaks ties so the order
+    // doesn't depend on the qsort implementation.
+    if (ka->h != kb->h) {
+        return kb->h - ka->h;
+    }
+    if (ka->w != kb->w) {
+        return kb->w - ka->w;
+    }
+    return ka->idx - kb->idx;
+}
+
+static int skyline_fit(Skyline* skyline, int node_idx, int w, int h, int* y) {
+    // Gets the lowest y that a w x h rect can be placed at with its left edge
+    // at the start of the node
+
+    int x = skyline->nodes[node_idx].x;
+    if (x + w > skyline->bin_w) {
+        return 0;
+    }
+
+    *y = 0;
+    for (int i = node_idx, width_left = w; width_left > 0; i++) {
+        if (skyline->nodes[i].y > *y) {
+            *y = skyline->nodes[i].y;
+        }
+        if (*y + h > skyline->bin_h) {
+            return 0;
+        }
+        width_left -= skyline->nodes[i].w;
+    }
+    return 1;
+}
+
+static void skyline_add(Skyline* skyline, int node_idx, int x, int y, int w, int h) {
+    Skyline_Node* nodes = skyline->nodes;
+
+    memmove(nodes + node_idx + 1, nodes + node_idx, (skyline->num_nodes - node_idx) * sizeof(Skyline_Node));
+    skyline->num_nodes++;
+    nodes[node_idx].x = x;
+    nodes[node_idx].y = y + h;
+    nodes[node_idx].w = w;
+
+    // Shrink or remove the nodes that are now covered
+    for (int i = node_idx + 1; i < skyline->num_nodes; ) {
+        int prev_end = nodes[i - 1].x + nodes[i - 1].w;
+        if (nodes[i].x >= prev_end) {
+            break;
+        }
+
+        int shrink = prev_end - nodes[i].x;
+        if (nodes[i].w > shrink) {
+            nodes[i].x += shrink;
+            nodes[i].w -= shrink;
+            break;
+        }
+
+        memmove(nodes + i, nodes + i + 1, (skyline->num_nodes - i - 1) * sizeof(Skyline_Node));
+        skyline->num_nodes--;
+    }
+
+    // Merge neighbouring nodes at the same height
+    for (int i = 0; i < skyline->num_nodes - 1; ) {
+        if (nodes[i].y == nodes[i + 1].y) {
+            nodes[i].w += nodes[i + 1].w;
+            memmove(nodes + i + 1, nodes + i + 2, (skyline->num_nodes - i - 2) * sizeof(Skyline_Node));
+            skyline->num_nodes--;
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+static int skyline_place(Skyline* skyline, Pack_Rect* rect, int allow_rotation) {
+    int best_node  = -1;
+    int best_top   = 0;
+    int best_width = 0;
+    int best_y     = 0;
+    int best_rot   = 0;
+
+    for (int rot = 0; rot <= allow_rotation; rot++) {
+        int w = rot ? rect->h : rect->w;
+        int h = rot ? rect->w : rect->h;
+
+        for (int i = 0; i < skyline->num_nodes; i++) {
+            int y;
+            if (!skyline_fit(skyline, i, w, h, &y)) {
+                continue;
+            }
+            // The lowest top edge wins, narrower nodes break ties since they
+            // leave fewer gaps
+            if (best_node < 0 || y + h < best_top || (y + h == best_top && skyline->nodes[i].w < best_width)) {
+                best_node  = i;
+                best_top   = y + h;
+                best_width = skyline->nodes[i].w;
+                best_y     = y;
+                best_rot   = rot;
+            }
+        }
+    }
+
+    if (best_node < 0) {
+        return 0;
+    }
+
+    rect->x       = skyline->nodes[best_node].x;
+    rect->y       = best_y;
+    rect->rotated = best_rot;
+    skyline_add(skyline, best_node, rect->x, rect->y, best_rot ? rect->h : rect->w, best_rot ? rect->w : rect->h);
+    return 1;
+}
+
+int pack_rects(Pack_Rect* rects, int num_rects, int bin_w, int bin_h, int allow_rotation) {
+    // The skyline gains at most one node per rect
+    Skyline skyline;
+    skyline.nodes     = malloc((num_rects + 1) * sizeof(Skyline_Node));
+    skyline.num_nodes = 1;
+    skyline.bin_w     = bin_w;
+    skyline.bin_h     = bin_h;
+
+    Pack_Sort_Key* order = malloc((num_rects > 0 ? num_rects : 1) * sizeof(Pack_Sort_Key));
+
+    if (skyline.nodes == NULL || order == NULL) {
+        free(skyline.nodes);
+        free(order);
+        return -1;
+    }
+
+    skyline.nodes[0].x = 0;
+    skyline.nodes[0].y = 0;
+    skyline.nodes[0].w = bin_w;
+
+    // If rects can be rotated, their longest side is used as the height
+    for (int i = 0; i < num_rects; i++) {
+        int w = rects[i].w;
+        int h = rects[i].h;
+        if (allow_rotation && w > h) {
+            w = rects[i].h;
+            h = rects[i].w;
+        }
+        order[i].h   = h;
+        order[i].w   = w;
+        order[i].idx = i;
+    }
+    qsort(order, num_rects, sizeof(Pack_Sort_Key), compare_rects);
+
+    int num_packed = 0;
+    for (int i = 0; i < num_rects; i++) {
+        Pack_Rect* rect = rects + order[i].idx;
+        rect->packed  = skyline_place(&skyline, rect, allow_rotation ? 1 : 0);
+        num_packed   += rect->packed;
+    }
+
+    free(skyline.nodes);
+    free(order);
+    return num_packed;
+}
+
+static int rect_fits_in_page(const Pack_Rect* rect, int page_w, int page_h, int allow_rotation) {
+    if (rect->w <= page_w && rect->h <= page_h) {
+        return 1;
+    }
+    return allow_rotation && rect->h <= page_w && rect->w <= page_h;
+}
+
+static int pack_rects_auto_size(Pack_Rect* rects, int num_rects, int max_w, int max_h, 
+                                int allow_rotation, Pack_Page* page)
+{
+    // Tries power of two sizes from smallest to largest area, square first 
+    // then twice as wide, until one holds every rect. Sizes that are smaller
+    // than the total area of the rects are skipped without packing.
+    long long area = 0;
+    for (int i = 0; i < num_rects; i++) {
+        area += (long long)rects[i].w * rects[i].h;
+    }
+
+    for (int w = 1, h = 1; ; ) {
+        int cw = w < max_w ? w : max_w;
+        int ch = h < max_h ? h : max_h;
+
+        if ((long long)cw * ch >= area) {
+            int num_packed = pack_rects(rects, num_rects, cw, ch, allow_rotation);
+            if (num_packed < 0) {
+                return -1;
+            }
+            if (num_packed == num_rects) {
+                page->w = cw;
+                page->h = ch;
+                return 1;
+            }
+        }
+
+        if (cw == max_w && ch == max_h) {
+            return 0;
+        }
+
+        if (w == h) {
+            w *= 2;
+        }
+        else {
+            h *= 2;
+        }
+    }
+}
+
+int pack_rects_into_pages(Pack_Rect* rects, int num_rects, int page_w, int page_h, 
+                          int auto_size, int allow_rotation, Pack_Page** pages)
+{
+    // Rects that haven't been packed are copied into `remaining` so each
+    // page only looks at them
+    Pack_Rect* remaining = malloc((num_rects > 0 ? num_rects : 1) * sizeof(Pack_Rect));
+    int*       indices   = malloc((num_rects > 0 ? num_rects : 1) * sizeof(int));
+    int        cap_pages = 4;
+    int        num_pages = 0;
+
+    *pages = malloc(cap_pages * sizeof(Pack_Page));
+
+    if (remaining == NULL || indices == NULL || *pages == NULL) {
+        goto out_of_memory;
+    }
+
+    for (int i = 0; i < num_rects; i++) {
+        rects[i].packed = 0;
+        rects[i].page   = 0;
+    }
+
+    for (;;) {
+        int num_remaining = 0;
+        for (int i = 0; i < num_rects; i++) {
+            if (!rects[i].packed && rect_fits_in_page(rects + i, page_w, page_h, allow_rotation)) {
+                indices[num_remaining]   = i;
+                remaining[num_remaining] = rects[i];
+                num_remaining++;
+            }
+        }
+
+        if (num_remaining == 0 && num_pages > 0) {
+            break;
+        }
+
+        if (num_pages == cap_pages) {
+            cap_pages *= 2;
+            Pack_Page* new_pages = realloc(*pages, cap_pages * sizeof(Pack_Page));
+            if (new_pages == NULL) {
+                goto out_of_memory;
+            }
+            *pages = new_pages;
+        }
+
+        Pack_Page* page = *pages + num_pages;
+        page->w = page_w;
+        page->h = page_h;
+
+        int packed_all = 0;
+        if (auto_size) {
+            if ((packed_all = pack_rects_auto_size(remaining, num_remaining, page_w, page_h, allow_rotation, page)) < 0) {
+                goto out_of_memory;
+            }
+        }
+
+        if (!packed_all && pack_rects(remaining, num_remaining, page_w, page_h, allow_rotation) < 0) {
+            goto out_of_memory;
+        }
+
+        for (int i = 0; i < num_remaining; i++) {
+            if (remaining[i].packed) {
+                remaining[i].page = num_pages;
+                rects[indices[i]] = remaining[i];
+            }
+        }
+
+        num_pages++;
+    }
+
+    free(remaining);
+    free(indices);
+    return num_pages;
+
+out_of_memory:
+    free(remaining);
+    free(indices);
+    free(*pages);
+    *pages = NULL;
+    return -1;
+}
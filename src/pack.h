@@ -0,0 +1,42 @@
+#ifndef DFFONT_PACK_H
+#define DFFONT_PACK_H
+
+typedef struct {
+    int w;        /* Set by the caller */
+    int h;        /* Set by the caller */
+    int x;
+    int y;
+    int rotated;  /* 1 if the rect was placed rotated by 90 degrees, so it takes up h x w */
+    int packed;   /* 0 if the rect didn't fit */
+    int page;     /* Set by `pack_rects_into_pages` */
+} Pack_Rect;
+
+typedef struct {
+    int w;
+    int h;
+} Pack_Page;
+
+/*
+ * Packs the rects into a `bin_w` x `bin_h` area using a skyline bottom-left
+ * packer. Rects are placed from tallest to shortest, and each one goes where
+ * its top edge ends up lowest. The result only depends on the input.
+ *
+ * Returns the number of rects that were packed, or -1 if memory could not be
+ * allocated.
+ */
+int pack_rects(Pack_Rect* rects, int num_rects, int bin_w, int bin_h, int allow_rotation);
+
+/*
+ * Packs the rects into as many `page_w` x `page_h` pages as are needed. If
+ * `auto_size` is set, `page_w` and `page_h` are the largest a page can be, 
+ * and each page is shrunk to the smallest power of two size that holds its 
+ * rects. Rects that can't fit in an empty page are not packed. There is 
+ * always at least one page.
+ *
+ * Returns the number of pages, or -1 if memory could not be allocated. The
+ * page sizes are stored in `*pages`, which must be freed with `free`.
+ */
+int pack_rects_into_pages(Pack_Rect* rects, int num_rects, int page_w, int page_h, 
+                          int auto_size, int allow_rotation, Pack_Page** pages);
+
+#endif
@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include "thread.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+#ifdef _WIN32
+static DWORD WINAPI thread_main(LPVOID arg) {
+    Thread* thread = (Thread*)arg;
+    thread->func(thread->arg);
+    return 0;
+}
+#else
+static void* thread_main(void* arg) {
+    Thread* thread = (Thread*)arg;
+    thread->func(thread->arg);
+    return NULL;
+}
+#endif
+
+int thread_create(Thread* thread, Thread_Func func, void* arg) {
+    thread->func = func;
+    thread->arg  = arg;
+#ifdef _WIN32
+    thread->handle = CreateThread(NULL, 0, thread_main, thread, 0, NULL);
+    return thread->handle != NULL;
+#else
+    pthread_t* handle = malloc(sizeof(pthread_t));
+    if (handle == NULL) {
+        return 0;
+    }
+    if (pthread_create(handle, NULL, thread_main, thread) != 0) {
+        free(handle);
+        return 0;
+    }
+    thread->handle = handle;
+    return 1;
+#endif
+}
+
+void thread_join(Thread* thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(*(pthread_t*)thread->handle, NULL);
+    free(thread->handle);
+#endif
+    thread->handle = NULL;
+}
+
+int mutex_init(Mutex* mutex) {
+#ifdef _WIN32
+    CRITICAL_SECTION* handle = malloc(sizeof(CRITICAL_SECTION));
+    if (handle == NULL) {
+        return 0;
+    }
+    InitializeCriticalSection(handle);
+#else
+    pthread_mutex_t* handle = malloc(sizeof(pthread_mutex_t));
+    if (handle == NULL) {
+        return 0;
+    }
+    if (pthread_mutex_init(handle, NULL) != 0) {
+        free(handle);
+        return 0;
+    }
+#endif
+    mutex->handle = handle;
+    return 1;
+}
+
+void mutex_free(Mutex* mutex) {
+    if (mutex->handle == NULL) {
+        return;
+    }
+#ifdef _WIN32
+    DeleteCriticalSection((CRITICAL_SECTION*)mutex->handle);
+#else
+    pthread_mutex_destroy((pthread_mutex_t*)mutex->handle);
+#endif
+    free(mutex->handle);
+    mutex->handle = NULL;
+}
+
+void mutex_lock(Mutex* mutex) {
+#ifdef _WIN32
+    EnterCriticalSection((CRITICAL_SECTION*)mutex->handle);
+#else
+    pthread_mutex_lock((pthread_mutex_t*)mutex->handle);
+#endif
+}
+
+void mutex_unlock(Mutex* mutex) {
+#ifdef _WIN32
+    LeaveCriticalSection((CRITICAL_SECTION*)mutex->handle);
+#else
+    pthread_mutex_unlock((pthread_mutex_t*)mutex->handle);
+#endif
+}
+
+int get_num_cpus(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+int atomic_add_int(volatile int* value, int amount) {
+#ifdef _WIN32
+    return (int)InterlockedExchangeAdd((volatile LONG*)value, amount);
+#else
+    return __atomic_fetch_add(value, amount, __ATOMIC_SEQ_CST);
+#endif
+}
@@ -0,0 +1,36 @@
+#ifndef DFFONT_THREAD_H
+#define DFFONT_THREAD_H
+
+typedef void (*Thread_Func)(void* arg);
+
+typedef struct {
+    void*        handle;
+    Thread_Func  func;
+    void*        arg;
+} Thread;
+
+/* Returns 1 on success, 0 if the thread could not be created */
+int thread_create(Thread* thread, Thread_Func func, void* arg);
+
+void thread_join(Thread* thread);
+
+typedef struct {
+    void* handle;
+} Mutex;
+
+/* Returns 1 on success, 0 if the mutex could not be created */
+int mutex_init(Mutex* mutex);
+
+void mutex_free(Mutex* mutex);
+
+void mutex_lock(Mutex* mutex);
+
+void mutex_unlock(Mutex* mutex);
+
+/* The number of logical processors, at least 1 */
+int get_num_cpus(void);
+
+/* Atomically adds `amount` to `*value` and returns the previous value */
+int atomic_add_int(volatile int* value, int amount);
+
+#endif
@@ -0,0 +1,295 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "tile_cache.h"
+#include "hash.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #include <direct.h>
+    #include <process.h>
+    #include <sys/utime.h>
+    #define tile_cache_mkdir(path) _mkdir(path)
+    #define tile_cache_getpid()    _getpid()
+#else
+    #include <dirent.h>
+    #include <unistd.h>
+    #include <utime.h>
+    #define tile_cache_mkdir(path) mkdir(path, 0755)
+    #define tile_cache_getpid()    getpid()
+#endif
+
+#define TILE_CACHE_MAGIC       "DFT1"
+#define TILE_CACHE_EXT         ".dft"
+#define TILE_CACHE_HEADER_SIZE (4 + 8 + 9 * 4)
+
+static void write_u32(uint8_t* data, uint32_t value) {
+    data[0] = value;
+    data[1] = value >> 8;
+    data[2] = value >> 16;
+    data[3] = value >> 24;
+}
+
+static uint32_t read_u32(const uint8_t* data) {
+    return (uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+static uint64_t tile_cache_get_key(const Tile_Cache* cache, uint32_t glyph_idx) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hash = fnv1a_u32(hash, (uint32_t)cache->font_hash);
+    hash = fnv1a_u32(hash, (uint32_t)(cache->font_hash >> 32));
+    hash = fnv1a_u32(hash, glyph_idx);
+    hash = fnv1a_u32(hash, cache->ppem);
+    hash = fnv1a_u32(hash, cache->scale);
+    hash = fnv1a_u32(hash, cache->spread);
+    hash = fnv1a_u32(hash, TILE_CACHE_VERSION);
+    return hash;
+}
+
+static char* tile_cache_get_path(const Tile_Cache* cache, uint64_t key) {
+    char* path = malloc(strlen(cache->dir) + 32);
+    if (path != NULL) {
+        sprintf(path, "%s/%016llx" TILE_CACHE_EXT, cache->dir, (unsigned long long)key);
+    }
+    return path;
+}
+
+DF_Error tile_cache_init(Tile_Cache* cache, const char* dir, const TTY_Font* font, int ppem, int scale, int spread) {
+    cache->dir       = dir;
+    cache->font_hash = fnv1a(FNV_OFFSET_BASIS, font->fileData, font->fileSize);
+    cache->ppem      = ppem;
+    cache->scale     = scale;
+    cache->spread    = spread;
+
+    struct stat info;
+    if (stat(dir, &info) == 0) {
+        return (info.st_mode & S_IFMT) == S_IFDIR ? DF_ERROR_NONE : DF_ERROR_FILE;
+    }
+    return tile_cache_mkdir(dir) == 0 ? DF_ERROR_NONE : DF_ERROR_FILE;
+}
+
+int tile_cache_load(const Tile_Cache* cache, DF_Glyph* result) {
+    uint64_t key  = tile_cache_get_key(cache, result->glyph.idx);
+    char*    path = tile_cache_get_path(cache, key);
+    if (path == NULL) {
+        return 0;
+    }
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        free(path);
+        return 0;
+    }
+
+    uint8_t header[TILE_CACHE_HEADER_SIZE];
+    int     loaded = 0;
+
+    if (fread(header, 1, TILE_CACHE_HEADER_SIZE, file) == TILE_CACHE_HEADER_SIZE &&
+        memcmp(header, TILE_CACHE_MAGIC, 4) == 0 &&
+        read_u32(header + 4) == (uint32_t)key && read_u32(header + 8) == (uint32_t)(key >> 32))
+    {
+        const uint8_t* values = header + 12;
+        int w = (int)read_u32(values + 24);
+        int h = (int)read_u32(values + 28);
+
+        result->glyph.offset.x  = (int32_t)read_u32(values);
+        result->glyph.offset.y  = (int32_t)read_u32(values + 4);
+        result->glyph.advance.x = (int32_t)read_u32(values + 8);
+        result->glyph.advance.y = (int32_t)read_u32(values + 12);
+        result->glyph.size.x    = (int32_t)read_u32(values + 16);
+        result->glyph.size.y    = (int32_t)read_u32(values + 20);
+        result->w               = w;
+        result->h               = h;
+        result->pixels          = NULL;
+
+        uint32_t dist_scale_bits = read_u32(values + 32);
+        memcpy(&result->dist_scale, &dist_scale_bits, sizeof(float));
+
+        if (result->glyph.size.x == 0 || result->glyph.size.y == 0) {
+            loaded = 1;
+        }
+        else if (w > 0 && h > 0 && (result->pixels = malloc(w * h)) != NULL) {
+            loaded = fread(result->pixels, 1, w * h, file) == (size_t)(w * h);
+            if (!loaded) {
+                free(result->pixels);
+                result->pixels = NULL;
+            }
+        }
+    }
+
+    fclose(file);
+
+    // Tiles are evicted by their modification time, so hits are touched
+    if (loaded) {
+        utime(path, NULL);
+    }
+
+    free(path);
+    return loaded;
+}
+
+void tile_cache_store(const Tile_Cache* cache, const DF_Glyph* glyph) {
+    uint64_t key  = tile_cache_get_key(cache, glyph->glyph.idx);
+    char*    path = tile_cache_get_path(cache, key);
+    char*    temp = malloc(strlen(cache->dir) + 64);
+    if (path == NULL || temp == NULL) {
+        free(path);
+        free(temp);
+        return;
+    }
+
+    // Tiles are written to a unique file, then renamed, so other threads and
+    // processes never see a partial tile
+    sprintf(temp, "%s/%016llx.%d.%p.tmp", cache->dir, (unsigned long long)key, (int)tile_cache_getpid(), (const void*)glyph);
+
+    uint8_t header[TILE_CACHE_HEADER_SIZE];
+    memcpy(header, TILE_CACHE_MAGIC, 4);
+    write_u32(header + 4, (uint32_t)key);
+    write_u32(header + 8, (uint32_t)(key >> 32));
+    write_u32(header + 12, glyph->glyph.offset.x);
+    write_u32(header + 16, glyph->glyph.offset.y);
+    write_u32(header + 20, glyph->glyph.advance.x);
+    write_u32(header + 24, glyph->glyph.advance.y);
+    write_u32(header + 28, glyph->glyph.size.x);
+    write_u32(header + 32, glyph->glyph.size.y);
+    write_u32(header + 36, glyph->w);
+    write_u32(header + 40, glyph->h);
+
+    uint32_t dist_scale_bits;
+    memcpy(&dist_scale_bits, &glyph->dist_scale, sizeof(float));
+    write_u32(header + 44, dist_scale_bits);
+
+    FILE* file = fopen(temp, "wb");
+    if (file != NULL) {
+        int written = fwrite(header, 1, TILE_CACHE_HEADER_SIZE, file) == TILE_CACHE_HEADER_SIZE;
+        if (glyph->pixels != NULL) {
+            written = written && fwrite(glyph->pixels, 1, glyph->w * glyph->h, file) == (size_t)(glyph->w * glyph->h);
+        }
+        written = fclose(file) == 0 && written;
+
+        // If the rename fails, another thread or process already stored the
+        // same tile
+        if (!written || rename(temp, path) != 0) {
+            remove(temp);
+        }
+    }
+
+    free(path);
+    free(temp);
+}
+
+typedef struct {
+    char*      name;
+    long long  size;
+    time_t     mtime;
+} Tile_File;
+
+static int compare_tile_files(const void* a, const void* b) {
+    const Tile_File* fa = (const Tile_File*)a;
+    const Tile_File* fb = (const Tile_File*)b;
+    if (fa->mtime != fb->mtime) {
+        return fa->mtime < fb->mtime ? -1 : 1;
+    }
+    return strcmp(fa->name, fb->name);
+}
+
+static int tile_cache_add_file(Tile_File** files, int* num_files, int* cap_files, const char* dir, const char* name) {
+    size_t len     = strlen(name);
+    size_t ext_len = strlen(TILE_CACHE_EXT);
+    if (len <= ext_len || strcmp(name + len - ext_len, TILE_CACHE_EXT) != 0) {
+        return 1;
+    }
+
+    if (*num_files == *cap_files) {
+        int        cap       = *cap_files > 0 ? *cap_files * 2 : 256;
+        Tile_File* new_files = realloc(*files, cap * sizeof(Tile_File));
+        if (new_files == NULL) {
+            return 0;
+        }
+        *files     = new_files;
+        *cap_files = cap;
+    }
+
+    Tile_File* file = *files + *num_files;
+    file->name = malloc(strlen(dir) + len + 2);
+    if (file->name == NULL) {
+        return 0;
+    }
+    sprintf(file->name, "%s/%s", dir, name);
+
+    struct stat info;
+    if (stat(file->name, &info) != 0) {
+        free(file->name);
+        return 1;
+    }
+    file->size  = info.st_size;
+    file->mtime = info.st_mtime;
+    (*num_files)++;
+    return 1;
+}
+
+void tile_cache_evict(const char* dir, long long max_size) {
+    Tile_File* files     = NULL;
+    int        num_files = 0;
+    int        cap_files = 0;
+    int        listed    = 1;
+
+#ifdef _WIN32
+    {
+        char* pattern = malloc(strlen(dir) + 8);
+        if (pattern == NULL) {
+            return;
+        }
+        sprintf(pattern, "%s/*" TILE_CACHE_EXT, dir);
+
+        WIN32_FIND_DATAA data;
+        HANDLE find = FindFirstFileA(pattern, &data);
+        free(pattern);
+        if (find == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        do {
+            listed = tile_cache_add_file(&files, &num_files, &cap_files, dir, data.cFileName);
+        } while (listed && FindNextFileA(find, &data));
+        FindClose(find);
+    }
+#else
+    {
+        DIR* handle = opendir(dir);
+        if (handle == NULL) {
+            return;
+        }
+        struct dirent* entry;
+        while (listed && (entry = readdir(handle)) != NULL) {
+            listed = tile_cache_add_file(&files, &num_files, &cap_files, dir, entry->d_name);
+        }
+        closedir(handle);
+    }
+#endif
+
+    // Nothing is deleted if the directory couldn't be fully listed, since
+    // the total size isn't known
+    if (listed) {
+        long long total_size = 0;
+        for (int i = 0; i < num_files; i++) {
+            total_size += files[i].size;
+        }
+
+        qsort(files, num_files, sizeof(Tile_File), compare_tile_files);
+
+        for (int i = 0; i < num_files && total_size > max_size; i++) {
+            if (remove(files[i].name) == 0) {
+                total_size -= files[i].size;
+            }
+        }
+    }
+
+    for (int i = 0; i < num_files; i++) {
+        free(files[i].name);
+    }
+    free(files);
+}
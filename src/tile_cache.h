@@ -0,0 +1,44 @@
+#ifndef DFFONT_TILE_CACHE_H
+#define DFFONT_TILE_CACHE_H
+
+#include <stdint.h>
+#include "truety.h"
+#include "df_glyph.h"
+
+/* Bump whenever a change to the renderer or distance field changes the tiles */
+#define TILE_CACHE_VERSION 2
+
+/*
+ * A directory of distance field tiles that persists between runs. Each tile
+ * is one glyph's distance field and metrics, stored in a file named after a
+ * hash of the font file's bytes, the glyph index, ppem, scale, spread, and
+ * TILE_CACHE_VERSION. Options that only affect packing (padding, image size,
+ * rotation) don't change the hash, so tiles can be reused when they change.
+ */
+struct Tile_Cache {
+    const char*  dir;
+    uint64_t     font_hash;
+    int          ppem;
+    int          scale;
+    int          spread;
+};
+
+typedef struct Tile_Cache Tile_Cache;
+
+/* Creates the directory if it doesn't exist. Returns DF_ERROR_FILE if the directory can't be created. */
+DF_Error tile_cache_init(Tile_Cache* cache, const char* dir, const TTY_Font* font, int ppem, int scale, int spread);
+
+/*
+ * Loads the tile of `result->glyph.idx`. On success, the glyph's metrics,
+ * `result->w`, `result->h`, and `result->pixels` are set. Returns 0 if the
+ * tile isn't cached or can't be read.
+ */
+int tile_cache_load(const Tile_Cache* cache, DF_Glyph* result);
+
+/* Stores the tile of a glyph generated by `df_generate_glyph`. Failures are ignored since the tile can be regenerated. */
+void tile_cache_store(const Tile_Cache* cache, const DF_Glyph* glyph);
+
+/* Deletes the least recently used tiles in `dir` until the tiles take up at most `max_size` bytes */
+void tile_cache_evict(const char* dir, long long max_size);
+
+#endif
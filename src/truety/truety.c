@@ -5,6 +5,18 @@
 #include <math.h>
 #include "truety.h"
 
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
 
 /* --------- */
 /* Constants */
@@ -15,6 +27,13 @@
 #define TTY_SUBDIVIDE_SQRD_ERROR   0x1  /* 26.6 */
 #define TTY_PIXELS_PER_SCANLINE    0x10 /* 26.6 */
 
+#define TTY_ATLAS_CACHE_SHELF_ALIGN      4 /* Shelf heights are a multiple of this              */
+#define TTY_ATLAS_CACHE_PADDING          1 /* Empty pixels between glyphs in the atlas          */
+#define TTY_ATLAS_CACHE_GLYPHS_PER_SLOT  4 /* Entries per maximum-sized glyph that fits        */
+
+#define TTY_PREFETCH_NUM_CODE_POINTS 0x110000 /* Code points that the prefetcher tracks, U+0000 to U+10FFFF */
+#define TTY_CACHE_LINE_SIZE          64       /* Data written by different threads is kept this far apart */
+
 
 /* --------- */
 /* Debugging */
@@ -127,12 +146,230 @@ static size_t tty_pad_to_align(size_t size, size_t alignment) {
 
 static size_t tty_calc_mem_size(size_t* total, size_t amount, size_t alignment) {
     size_t totalCopy = ((*total) += amount);
-    (*total) += tty_pad_to_align(*total, alignment);
+    (*total)  = tty_pad_to_align(*total, alignment);
     amount   += *total - totalCopy;
     return amount;
 }
 
 
+/* -------- */
+/* Platform */
+/* -------- */
+static TTY_U8* tty_map_file(const char* path, TTY_S32* size) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0 || fileSize.QuadPart > INT32_MAX) {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    // The view keeps the mapping (and the file) alive, so the handles can be
+    // closed immediately
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+        return NULL;
+    }
+
+    TTY_U8* data = (TTY_U8*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    *size = (TTY_S32)fileSize.QuadPart;
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || st.st_size > INT32_MAX) {
+        close(fd);
+        return NULL;
+    }
+
+    // The mapping keeps the file alive, so the descriptor can be closed
+    // immediately
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+
+    *size = (TTY_S32)st.st_size;
+    return (TTY_U8*)data;
+#endif
+}
+
+static void tty_unmap_file(TTY_U8* data, TTY_S32 size) {
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+#ifdef _WIN32
+    typedef HANDLE             TTY_Thread;
+    typedef CRITICAL_SECTION   TTY_Mutex;
+    typedef CONDITION_VARIABLE TTY_Cond;
+    typedef DWORD              TTY_Thread_Result;
+    #define TTY_THREAD_CALL    WINAPI
+#else
+    typedef pthread_t          TTY_Thread;
+    typedef pthread_mutex_t    TTY_Mutex;
+    typedef pthread_cond_t     TTY_Cond;
+    typedef void*              TTY_Thread_Result;
+    #define TTY_THREAD_CALL
+#endif
+
+typedef TTY_Thread_Result (TTY_THREAD_CALL *TTY_Thread_Func)(void*);
+
+static TTY_Bool tty_thread_create(TTY_Thread* thread, TTY_Thread_Func func, void* arg) {
+#ifdef _WIN32
+    *thread = CreateThread(NULL, 0, func, arg, 0, NULL);
+    return *thread != NULL;
+#else
+    return pthread_create(thread, NULL, func, arg) == 0;
+#endif
+}
+
+static void tty_thread_join(TTY_Thread thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+static TTY_Bool tty_mutex_init(TTY_Mutex* mutex) {
+#ifdef _WIN32
+    InitializeCriticalSection(mutex);
+    return TTY_TRUE;
+#else
+    return pthread_mutex_init(mutex, NULL) == 0;
+#endif
+}
+
+static void tty_mutex_free(TTY_Mutex* mutex) {
+#ifdef _WIN32
+    DeleteCriticalSection(mutex);
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+static void tty_mutex_lock(TTY_Mutex* mutex) {
+#ifdef _WIN32
+    EnterCriticalSection(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+static void tty_mutex_unlock(TTY_Mutex* mutex) {
+#ifdef _WIN32
+    LeaveCriticalSection(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+static TTY_Bool tty_cond_init(TTY_Cond* cond) {
+#ifdef _WIN32
+    InitializeConditionVariable(cond);
+    return TTY_TRUE;
+#else
+    return pthread_cond_init(cond, NULL) == 0;
+#endif
+}
+
+static void tty_cond_free(TTY_Cond* cond) {
+#ifdef _WIN32
+    (void)cond;
+#else
+    pthread_cond_destroy(cond);
+#endif
+}
+
+static void tty_cond_wait(TTY_Cond* cond, TTY_Mutex* mutex) {
+#ifdef _WIN32
+    SleepConditionVariableCS(cond, mutex, INFINITE);
+#else
+    pthread_cond_wait(cond, mutex);
+#endif
+}
+
+static void tty_cond_signal(TTY_Cond* cond) {
+#ifdef _WIN32
+    WakeConditionVariable(cond);
+#else
+    pthread_cond_signal(cond);
+#endif
+}
+
+static void tty_cond_broadcast(TTY_Cond* cond) {
+#ifdef _WIN32
+    WakeAllConditionVariable(cond);
+#else
+    pthread_cond_broadcast(cond);
+#endif
+}
+
+/* Memory ordering for data that is read without a lock */
+#ifdef _MSC_VER
+    #define TTY_ATOMIC_LOAD_ACQUIRE(ptr)       (*(volatile TTY_U32*)(ptr))
+    #define TTY_ATOMIC_LOAD_RELAXED(ptr)       (*(volatile TTY_U32*)(ptr))
+    #define TTY_ATOMIC_STORE_RELEASE(ptr, val) (*(volatile TTY_U32*)(ptr) = (val))
+    #define TTY_ATOMIC_STORE_RELAXED(ptr, val) (*(volatile TTY_U32*)(ptr) = (val))
+    #define TTY_ATOMIC_STORE_U8(ptr, val)      (*(volatile TTY_U8*)(ptr) = (val))
+    #define TTY_ATOMIC_LOAD_U8(ptr)            (*(volatile TTY_U8*)(ptr))
+    #define TTY_ATOMIC_FENCE_ACQUIRE()         MemoryBarrier()
+    #define TTY_ATOMIC_FENCE_RELEASE()         MemoryBarrier()
+#else
+    #define TTY_ATOMIC_LOAD_ACQUIRE(ptr)       __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+    #define TTY_ATOMIC_LOAD_RELAXED(ptr)       __atomic_load_n(ptr, __ATOMIC_RELAXED)
+    #define TTY_ATOMIC_STORE_RELEASE(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+    #define TTY_ATOMIC_STORE_RELAXED(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELAXED)
+    #define TTY_ATOMIC_STORE_U8(ptr, val)      __atomic_store_n(ptr, val, __ATOMIC_RELAXED)
+    #define TTY_ATOMIC_LOAD_U8(ptr)            __atomic_load_n(ptr, __ATOMIC_RELAXED)
+    #define TTY_ATOMIC_FENCE_ACQUIRE()         __atomic_thread_fence(__ATOMIC_ACQUIRE)
+    #define TTY_ATOMIC_FENCE_RELEASE()         __atomic_thread_fence(__ATOMIC_RELEASE)
+#endif
+
+/* Copies structs that are read without a lock one 32-bit word at a time,
+   since the structs are larger than a single atomic */
+static void tty_atomic_load_words(void* dst, const void* src, size_t size) {
+    TTY_ASSERT(size % sizeof(TTY_U32) == 0);
+    for (size_t i = 0; i < size / sizeof(TTY_U32); i++) {
+        ((TTY_U32*)dst)[i] = TTY_ATOMIC_LOAD_RELAXED((const TTY_U32*)src + i);
+    }
+}
+
+static void tty_atomic_store_words(void* dst, const void* src, size_t size) {
+    TTY_ASSERT(size % sizeof(TTY_U32) == 0);
+    for (size_t i = 0; i < size / sizeof(TTY_U32); i++) {
+        TTY_ATOMIC_STORE_RELAXED((TTY_U32*)dst + i, ((const TTY_U32*)src)[i]);
+    }
+}
+
+#ifdef _WIN32
+    #define TTY_THREAD_YIELD() SwitchToThread()
+#else
+    #define TTY_THREAD_YIELD() sched_yield()
+#endif
+
+
 /* ---- */
 /* Math */
 /* ---- */
@@ -2500,41 +2737,97 @@ static void tty_execute_next_font_program_ins(TTY_Program_Context* ctx) {
     }
 }
 
+enum {
+    TTY_FILE_DATA_ALLOCATED,
+    TTY_FILE_DATA_BORROWED ,
+    TTY_FILE_DATA_MAPPED   ,
+};
+
+static void tty_font_free_file_data(TTY_Font* font) {
+    switch (font->fileDataSource) {
+        case TTY_FILE_DATA_ALLOCATED:
+            free(font->fileData);
+            break;
+        case TTY_FILE_DATA_MAPPED:
+            if (font->fileData != NULL) {
+                tty_unmap_file(font->fileData, font->fileSize);
+            }
+            break;
+    }
+    font->fileData = NULL;
+}
+
+static TTY_Error tty_font_init_from_file_data(TTY_Font* font);
+
 TTY_Error tty_font_init(TTY_Font* font, const char* path) {
     memset(font, 0, sizeof(TTY_Font));
 
+    // Open the font file
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return TTY_ERROR_FAILED_TO_READ_FILE;
+    }
 
+    // Calculate the size of the file
+    if (fseek(f, 0, SEEK_END)       != 0  ||
+        (font->fileSize = ftell(f)) <  0  ||
+        fseek(f, 0, SEEK_SET)       != 0)
     {
-        // Open the font file
-        FILE* f = fopen(path, "rb");
-        if (f == NULL) {
-            return TTY_ERROR_FAILED_TO_READ_FILE;
-        }
-
-        // Calculate the size of the file
-        if (fseek(f, 0, SEEK_END)       != 0  ||
-            (font->fileSize = ftell(f)) <  0  ||
-            fseek(f, 0, SEEK_SET)       != 0)
-        {
-            fclose(f);
-            return TTY_ERROR_FAILED_TO_READ_FILE;
-        }
+        fclose(f);
+        return TTY_ERROR_FAILED_TO_READ_FILE;
+    }
 
-        // Allocate a buffer that will store the contents of the file
-        font->fileData = calloc(font->fileSize, 1);
-        if (font->fileData == NULL) {
-            fclose(f);
-            return TTY_ERROR_OUT_OF_MEMORY;
-        }
+    // Allocate a buffer that will store the contents of the file
+    font->fileData       = calloc(font->fileSize, 1);
+    font->fileDataSource = TTY_FILE_DATA_ALLOCATED;
+    if (font->fileData == NULL) {
+        fclose(f);
+        return TTY_ERROR_OUT_OF_MEMORY;
+    }
 
-        // Read the file contents into the buffer
-        if ((TTY_S32)fread(font->fileData, 1, font->fileSize, f) != font->fileSize) {
-            fclose(f);
-            free(font->fileData);
-            font->fileData = NULL;
-            return TTY_ERROR_FAILED_TO_READ_FILE;
-        }
+    // Read the file contents into the buffer
+    if ((TTY_S32)fread(font->fileData, 1, font->fileSize, f) != font->fileSize) {
         fclose(f);
+        tty_font_free_file_data(font);
+        return TTY_ERROR_FAILED_TO_READ_FILE;
+    }
+    fclose(f);
+
+    return tty_font_init_from_file_data(font);
+}
+
+TTY_Error tty_font_init_mapped(TTY_Font* font, const char* path) {
+    memset(font, 0, sizeof(TTY_Font));
+
+    font->fileData       = tty_map_file(path, &font->fileSize);
+    font->fileDataSource = TTY_FILE_DATA_MAPPED;
+    if (font->fileData == NULL) {
+        return TTY_ERROR_FAILED_TO_READ_FILE;
+    }
+
+    return tty_font_init_from_file_data(font);
+}
+
+TTY_Error tty_font_init_from_memory(TTY_Font* font, const void* data, TTY_U32 size) {
+    memset(font, 0, sizeof(TTY_Font));
+
+    if (size > INT32_MAX) {
+        return TTY_ERROR_FAILED_TO_READ_FILE;
+    }
+
+    // The font data is never written to, so it is safe to drop the const
+    font->fileData       = (TTY_U8*)data;
+    font->fileSize       = (TTY_S32)size;
+    font->fileDataSource = TTY_FILE_DATA_BORROWED;
+
+    return tty_font_init_from_file_data(font);
+}
+
+static TTY_Error tty_font_init_from_file_data(TTY_Font* font) {
+    if (font->fileSize < 12) {
+        // The file is too small to contain the offset table
+        tty_font_free_file_data(font);
+        return TTY_ERROR_FILE_IS_CORRUPTED;
     }
 
 
@@ -2546,8 +2839,7 @@ TTY_Error tty_font_init(TTY_Font* font, const char* path) {
             !TTY_TAG_EQUALS(&sfntVersion, "true") &&
             !TTY_TAG_EQUALS(&sfntVersion, "typ1"))
         {
-            free(font->fileData);
-            font->fileData = NULL;
+            tty_font_free_file_data(font);
             return TTY_ERROR_FILE_IS_NOT_TTF;   
         }
     }
@@ -2617,8 +2909,7 @@ TTY_Error tty_font_init(TTY_Font* font, const char* path) {
             !font->loca.exists ||
             !font->maxp.exists)
         {
-            free(font->fileData);
-            font->fileData = NULL;
+            tty_font_free_file_data(font);
             return TTY_ERROR_FILE_IS_CORRUPTED;
         }
     }
@@ -2626,8 +2917,8 @@ TTY_Error tty_font_init(TTY_Font* font, const char* path) {
 
     // Extract the character encoding
     {
-        TTY_U16  numTables          = tty_get_u16(font->fileData + font->cmap.off + 2);
-        TTY_Bool foundPlatAndFormat = TTY_FALSE;
+        TTY_U16 numTables = tty_get_u16(font->fileData + font->cmap.off + 2);
+        TTY_U8  bestRank  = 0;
     
         for (TTY_U16 i = 0; i < numTables; i++) {
             TTY_U8*  data              = font->fileData + font->cmap.off + 4 + i * 8;
@@ -2645,37 +2936,57 @@ TTY_Error tty_font_init(TTY_Font* font, const char* path) {
             }
 
             if (platformIdIsValid) {
-                font->encoding.platformId = platformId;
-                font->encoding.encodingId = encodingId;
-                font->encoding.off        = tty_get_u32(data + 4);
-
-                TTY_U8* subtable = font->fileData + font->cmap.off + font->encoding.off;
-                TTY_U16 format   = tty_get_u16(subtable);
+                TTY_U32 off    = tty_get_u32(data + 4);
+                TTY_U16 format = tty_get_u16(font->fileData + font->cmap.off + off);
+                TTY_U8  rank;
+
+                // Format 12 covers all of Unicode, so it is preferred over 
+                // format 4 which only covers the BMP. Format 13 is only used
+                // by last resort fonts.
+                //
+                // TODO: support formats 6, 8, 10, and 14
+                switch (format) {
+                    case 12:
+                        rank = 3;
+                        break;
+                    case 4:
+                        rank = 2;
+                        break;
+                    case 13:
+                        rank = 1;
+                        break;
+                    default:
+                        rank = 0;
+                        break;
+                }
 
-                // TODO: support formats 6, 8, 10, 12, 13, and 14
-                foundPlatAndFormat = format == 4;
-                if (foundPlatAndFormat) {
-                    break;
+                if (rank > bestRank) {
+                    bestRank                  = rank;
+                    font->encoding.platformId = platformId;
+                    font->encoding.encodingId = encodingId;
+                    font->encoding.off        = off;
+                    font->encoding.format     = format;
                 }
             }
         }
         
-        if (!foundPlatAndFormat) {
-            free(font->fileData);
-            font->fileData = NULL;
+        if (bestRank == 0) {
+            tty_font_free_file_data(font);
             return TTY_ERROR_UNSUPPORTED_FEATURE;
         }
     }
 
 
-    font->startingEdgeCap = 100;
-    font->upem            = tty_get_u16(font->fileData + font->head.off + 18);
-    font->numGlyphs       = tty_get_u16(font->fileData + font->maxp.off + 4);
-    font->ascender        = tty_get_s16(font->fileData + font->hhea.off + 4);
-    font->descender       = tty_get_s16(font->fileData + font->hhea.off + 6);
-    font->lineGap         = tty_get_s16(font->fileData + font->hhea.off + 8);
-    font->maxHoriExtent   = tty_get_s16(font->fileData + font->hhea.off + 16);
-    font->hasHinting      = font->cvt.exists && font->fpgm.exists && font->prep.exists;
+    font->startingEdgeCap  = 100;
+    font->upem             = tty_get_u16(font->fileData + font->head.off + 18);
+    font->numGlyphs        = tty_get_u16(font->fileData + font->maxp.off + 4);
+    font->ascender         = tty_get_s16(font->fileData + font->hhea.off + 4);
+    font->descender        = tty_get_s16(font->fileData + font->hhea.off + 6);
+    font->lineGap          = tty_get_s16(font->fileData + font->hhea.off + 8);
+    font->maxHoriExtent    = tty_get_s16(font->fileData + font->hhea.off + 16);
+    font->numHMetrics      = tty_get_u16(font->fileData + font->hhea.off + 34);
+    font->indexToLocFormat = tty_get_s16(font->fileData + font->head.off + 50);
+    font->hasHinting       = font->cvt.exists && font->fpgm.exists && font->prep.exists;
 
 
     // Allocate hinting data
@@ -2717,8 +3028,7 @@ TTY_Error tty_font_init(TTY_Font* font, const char* path) {
         
         font->hint.mem = (TTY_U8*)calloc(totalSize, 1);
         if (font->hint.mem == NULL) {
-            free(font->fileData);
-            font->fileData = NULL;
+            tty_font_free_file_data(font);
             return TTY_ERROR_OUT_OF_MEMORY;
         }
         
@@ -2762,9 +3072,14 @@ TTY_Error tty_font_init(TTY_Font* font, const char* path) {
     return TTY_ERROR_NONE;
 }
 
+static void tty_glyph_index_map_free(TTY_Glyph_Index_Map* map);
+
+static void tty_outline_cache_free(TTY_Outline_Cache* cache);
+
 void tty_font_free(TTY_Font* font) {
-    free(font->fileData);
-    font->fileData = NULL;
+    tty_font_free_file_data(font);
+    tty_glyph_index_map_free(&font->glyphIndexMap);
+    tty_outline_cache_free(&font->outlineCache);
 
     free(font->hint.mem);
     font->hint.mem = NULL;
@@ -2828,8 +3143,9 @@ static void tty_execute_next_cv_program_ins(TTY_Program_Context* ctx) {
 TTY_Error tty_instance_init(TTY_Font* font, TTY_Instance* instance, TTY_U32 ppem, TTY_U32 flags) {
     memset(instance, 0, sizeof(TTY_Instance));
     
-    instance->useHinting           = font->hasHinting && (flags ^ TTY_INSTANCE_NO_HINTING);
-    instance->useSubpixelRendering = flags & TTY_INSTANCE_SUBPIXEL_RENDERING_RGB;
+    instance->useHinting           = font->hasHinting && !(flags & TTY_INSTANCE_NO_HINTING);
+    instance->useSubpixelRendering = (flags & TTY_INSTANCE_SUBPIXEL_RENDERING_RGB) != 0;
+    instance->useBinaryRendering   = (flags & TTY_INSTANCE_BINARY) != 0;
     instance->isRotated            = TTY_FALSE;
     instance->isStretched          = TTY_FALSE;
 
@@ -2922,12 +3238,116 @@ void tty_instance_free(TTY_Instance* instance) {
 /* ------------- */
 /* Glyph Loading */
 /* ------------- */
+#define TTY_GLYPH_INDEX_MAP_NUM_PAGES ((0x110000 - 0x10000) >> 8)
+
+typedef struct TTY_Component_Offset {
+    TTY_V2   offset;     /* 2.14, unscaled */
+    TTY_U32  firstPoint;
+    TTY_U32  numPoints;
+    TTY_U16  flags;
+} TTY_Component_Offset;
+
+typedef struct TTY_Outline {
+    TTY_V2*                points;
+    TTY_Component_Offset*  offsets; /* Only used by composite glyphs */
+    TTY_U16*               endPointIndices;
+    TTY_U8*                pointTypes;
+    struct TTY_Outline*    lruPrev;
+    struct TTY_Outline*    lruNext;
+    TTY_U32                glyphIdx;
+    TTY_U32                size;
+    TTY_U32                numPoints;
+    TTY_U32                numOffsets;
+    TTY_U16                numEndPoints;
+} TTY_Outline;
+
+static TTY_U16 tty_glyph_index_map_get(TTY_Glyph_Index_Map* map, TTY_U32 cp) {
+    if (cp <= 0xFFFF) {
+        return map->bmp[cp];
+    }
+    if (cp > 0x10FFFF) {
+        return 0;
+    }
+    TTY_U16* page = map->pages[(cp - 0x10000) >> 8];
+    return page == NULL ? 0 : page[cp & 0xFF];
+}
+
+static TTY_Error tty_glyph_index_map_set(TTY_Glyph_Index_Map* map, TTY_U32 cp, TTY_U16 glyphIdx) {
+    if (cp <= 0xFFFF) {
+        map->bmp[cp] = glyphIdx;
+        return TTY_ERROR_NONE;
+    }
+
+    TTY_U16** page = map->pages + ((cp - 0x10000) >> 8);
+    if (*page == NULL) {
+        if (glyphIdx == 0) {
+            return TTY_ERROR_NONE;
+        }
+        *page = (TTY_U16*)calloc(0x100, sizeof(TTY_U16));
+        if (*page == NULL) {
+            return TTY_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    (*page)[cp & 0xFF] = glyphIdx;
+    return TTY_ERROR_NONE;
+}
+
+static void tty_glyph_index_map_free(TTY_Glyph_Index_Map* map) {
+    if (map->pages != NULL) {
+        for (TTY_U32 i = 0; i < TTY_GLYPH_INDEX_MAP_NUM_PAGES; i++) {
+            free(map->pages[i]);
+        }
+    }
+    free(map->pages);
+    free(map->bmp);
+    map->pages = NULL;
+    map->bmp   = NULL;
+}
+
+static void tty_outline_cache_free(TTY_Outline_Cache* cache) {
+    TTY_Outline* outline = cache->lruHead;
+    while (outline != NULL) {
+        TTY_Outline* next = outline->lruNext;
+        free(outline);
+        outline = next;
+    }
+    free(cache->outlines);
+    free(cache->offsetBuff);
+    memset(cache, 0, sizeof(TTY_Outline_Cache));
+}
+
+static TTY_U16 tty_get_glyph_index_format_4_segment(TTY_U8* subtable, TTY_U16 segCount, TTY_U16 seg, TTY_U32 cp) {
+    // Note: cp must be within the segment's start and end codes
+
+    TTY_U32 off            = 16 + 2 * seg;
+    TTY_U8* idRangeOffsets = subtable + 6 * segCount + off;
+    TTY_U16 idRangeOffset  = tty_get_u16(idRangeOffsets);
+    TTY_U16 idDelta        = tty_get_s16(subtable + 4 * segCount + off);
+
+    if (idRangeOffset == 0) {
+        return cp + idDelta;
+    }
+
+    TTY_U16 startCode = tty_get_u16(subtable + 2 * segCount + off);
+    TTY_U16 glyphIdx  = tty_get_u16(idRangeOffset + 2 * (cp - startCode) + idRangeOffsets);
+
+    // "If the value obtained from the subscript is not 0 (which indicates the
+    //  missing glyph), you should add idDelta to it in order to get the 
+    //  glyphIndex."
+    return glyphIdx == 0 ? 0 : glyphIdx + idDelta;
+}
+
 static TTY_U16 tty_get_glyph_index_format_4(TTY_U8* subtable, TTY_U32 cp) {
     #define TTY_GET_END_CODE(index) tty_get_u16(subtable + 14 + 2 * (index))
     
+    if (cp > 0xFFFF) {
+        return 0;
+    }
+
     TTY_U16 segCount = tty_get_u16(subtable + 6) >> 1;
-    TTY_U16 left     = 0;
-    TTY_U16 right    = segCount - 1;
+    TTY_S32 left     = 0;
+    TTY_S32 right    = segCount - 1;
 
     while (left <= right) {
         TTY_U16 mid     = (left + right) / 2;
@@ -2935,21 +3355,11 @@ static TTY_U16 tty_get_glyph_index_format_4(TTY_U8* subtable, TTY_U32 cp) {
 
         if (endCode >= cp) {
             if (mid == 0 || TTY_GET_END_CODE(mid - 1) < cp) {
-                TTY_U32 off            = 16 + 2 * mid;
-                TTY_U8* idRangeOffsets = subtable + 6 * segCount + off;
-                TTY_U16 idRangeOffset  = tty_get_u16(idRangeOffsets);
-                TTY_U16 startCode      = tty_get_u16(subtable + 2 * segCount + off);
-
+                TTY_U16 startCode = tty_get_u16(subtable + 2 * segCount + 16 + 2 * mid);
                 if (startCode > cp) {
                     return 0;
                 }
-                
-                if (idRangeOffset == 0) {
-                    TTY_U16 idDelta = tty_get_s16(subtable + 4 * segCount + off);
-                    return cp + idDelta;
-                }
-
-                return tty_get_u16(idRangeOffset + 2 * (cp - startCode) + idRangeOffsets);
+                return tty_get_glyph_index_format_4_segment(subtable, segCount, mid, cp);
             }
             right = mid - 1;
         }
@@ -2963,6 +3373,33 @@ static TTY_U16 tty_get_glyph_index_format_4(TTY_U8* subtable, TTY_U32 cp) {
     #undef TTY_GET_END_CODE
 }
 
+static TTY_U32 tty_get_glyph_index_format_12_or_13(TTY_U8* subtable, TTY_U32 cp, TTY_Bool isFormat13) {
+    TTY_U32 numGroups = tty_get_u32(subtable + 12);
+    TTY_U8* groups    = subtable + 16;
+    TTY_U32 left      = 0;
+    TTY_U32 right     = numGroups;
+
+    while (left < right) {
+        TTY_U32 mid       = left + (right - left) / 2;
+        TTY_U8* group     = groups + 12 * mid;
+        TTY_U32 startCode = tty_get_u32(group);
+        TTY_U32 endCode   = tty_get_u32(group + 4);
+
+        if (cp < startCode) {
+            right = mid;
+        }
+        else if (cp > endCode) {
+            left = mid + 1;
+        }
+        else {
+            TTY_U32 glyphIdx = tty_get_u32(group + 8);
+            return isFormat13 ? glyphIdx : glyphIdx + (cp - startCode);
+        }
+    }
+
+    return 0;
+}
+
 static TTY_U8* tty_get_glyf_data_block(TTY_Font* font, TTY_U32 glyphIdx) {
     #define TTY_GET_OFF_16(idx)\
         (tty_get_u16(font->fileData + font->loca.off + (2 * (idx))) * 2)
@@ -2970,7 +3407,7 @@ static TTY_U8* tty_get_glyf_data_block(TTY_Font* font, TTY_U32 glyphIdx) {
     #define TTY_GET_OFF_32(idx)\
         tty_get_u32(font->fileData + font->loca.off + (4 * (idx)))
 
-    TTY_S16 version = tty_get_s16(font->fileData + font->head.off + 50);
+    TTY_S16 version = font->indexToLocFormat;
     TTY_U32 blockOff;
     TTY_U32 nextBlockOff;
 
@@ -3000,9 +3437,14 @@ static TTY_U8* tty_get_glyf_data_block(TTY_Font* font, TTY_U32 glyphIdx) {
 }
 
 TTY_Error tty_get_glyph_index(TTY_Font* font, TTY_U32 codePoint, TTY_U32* idx) {
+    if (font->glyphIndexMap.bmp != NULL) {
+        *idx = tty_glyph_index_map_get(&font->glyphIndexMap, codePoint);
+        return TTY_ERROR_NONE;
+    }
+
     TTY_U8* subtable = font->fileData + font->cmap.off + font->encoding.off;
 
-    switch (tty_get_u16(subtable)) {
+    switch (font->encoding.format) {
         case 4:
             *idx = tty_get_glyph_index_format_4(subtable, codePoint);
             return TTY_ERROR_NONE;
@@ -3016,11 +3458,11 @@ TTY_Error tty_get_glyph_index(TTY_Font* font, TTY_U32 codePoint, TTY_U32* idx) {
             // TODO
             return TTY_ERROR_UNSUPPORTED_FEATURE;
         case 12:
-            // TODO
-            return TTY_ERROR_UNSUPPORTED_FEATURE;
+            *idx = tty_get_glyph_index_format_12_or_13(subtable, codePoint, TTY_FALSE);
+            return TTY_ERROR_NONE;
         case 13:
-            // TODO
-            return TTY_ERROR_UNSUPPORTED_FEATURE;
+            *idx = tty_get_glyph_index_format_12_or_13(subtable, codePoint, TTY_TRUE);
+            return TTY_ERROR_NONE;
         case 14:
             // TODO
             return TTY_ERROR_UNSUPPORTED_FEATURE;
@@ -3032,49 +3474,187 @@ TTY_Error tty_get_glyph_index(TTY_Font* font, TTY_U32 codePoint, TTY_U32* idx) {
     return TTY_ERROR_UNSUPPORTED_FEATURE;
 }
 
-TTY_Error tty_glyph_init(TTY_Font* font, TTY_Glyph* glyph, TTY_U32 idx) {
-    // Note: Glyph advance, offset, and size are calculated when the glyph is rendered
-    
-    memset(glyph, 0, sizeof(TTY_Glyph));
-
-    glyph->idx       = idx;
-    glyph->glyfBlock = tty_get_glyf_data_block(font, idx);
-    
-    // If glyfBlock is NULL, the glyph is an empty glyph (i.e. space)
-    if (glyph->glyfBlock != NULL) {
-        glyph->numContours = tty_get_s16(glyph->glyfBlock);
+TTY_Error tty_get_glyph_indices(TTY_Font* font, const TTY_U32* codePoints, TTY_U32 count, TTY_U32* indices) {
+    if (font->glyphIndexMap.bmp != NULL) {
+        for (TTY_U32 i = 0; i < count; i++) {
+            indices[i] = tty_glyph_index_map_get(&font->glyphIndexMap, codePoints[i]);
+        }
+        return TTY_ERROR_NONE;
     }
-    
-    return TTY_ERROR_NONE;
-}
 
+    TTY_U8* subtable = font->fileData + font->cmap.off + font->encoding.off;
 
-/* ------------- */
-/* Image Loading */
-/* ------------- */
-TTY_Error tty_image_init(TTY_Image* image, TTY_U8* pixels, TTY_U32 w, TTY_U32 h) {
-    if (pixels == NULL) {
-        image->pixels = (TTY_U8*)calloc((size_t)w * h, 1);
-        if (image->pixels == NULL) {
-            return TTY_ERROR_OUT_OF_MEMORY;
+    switch (font->encoding.format) {
+        case 4:
+            for (TTY_U32 i = 0; i < count; i++) {
+                indices[i] = tty_get_glyph_index_format_4(subtable, codePoints[i]);
+            }
+            return TTY_ERROR_NONE;
+        case 12:
+        case 13:
+        {
+            TTY_Bool isFormat13 = font->encoding.format == 13;
+            for (TTY_U32 i = 0; i < count; i++) {
+                indices[i] = tty_get_glyph_index_format_12_or_13(subtable, codePoints[i], isFormat13);
+            }
+            return TTY_ERROR_NONE;
         }
     }
-    else {
-        image->pixels = pixels;
-    }
-    image->size.x = w;
-    image->size.y = h;
-    return TTY_ERROR_NONE;
-}
 
-void tty_image_free(TTY_Image* image) {
-    free(image->pixels);
-    image->pixels = NULL;
+    return TTY_ERROR_UNSUPPORTED_FEATURE;
 }
 
+TTY_Error tty_font_init_glyph_index_map(TTY_Font* font) {
+    TTY_Glyph_Index_Map* map = &font->glyphIndexMap;
+    if (map->bmp != NULL) {
+        return TTY_ERROR_NONE;
+    }
 
-/* --------- */
-/* Rendering */
+    map->bmp   = (TTY_U16*) calloc(0x10000, sizeof(TTY_U16));
+    map->pages = (TTY_U16**)calloc(TTY_GLYPH_INDEX_MAP_NUM_PAGES, sizeof(TTY_U16*));
+    if (map->bmp == NULL || map->pages == NULL) {
+        tty_glyph_index_map_free(map);
+        return TTY_ERROR_OUT_OF_MEMORY;
+    }
+
+    TTY_U8* subtable = font->fileData + font->cmap.off + font->encoding.off;
+
+    switch (font->encoding.format) {
+        case 4:
+        {
+            TTY_U16 segCount = tty_get_u16(subtable + 6) >> 1;
+
+            for (TTY_U16 seg = 0; seg < segCount; seg++) {
+                TTY_U32 startCode = tty_get_u16(subtable + 2 * segCount + 16 + 2 * seg);
+                TTY_U32 endCode   = tty_get_u16(subtable + 14 + 2 * seg);
+
+                for (TTY_U32 cp = startCode; cp <= endCode; cp++) {
+                    map->bmp[cp] = tty_get_glyph_index_format_4_segment(subtable, segCount, seg, cp);
+                }
+            }
+            
+            return TTY_ERROR_NONE;
+        }
+        case 12:
+        case 13:
+        {
+            TTY_U32 numGroups  = tty_get_u32(subtable + 12);
+            TTY_Bool isFormat13 = font->encoding.format == 13;
+
+            for (TTY_U32 i = 0; i < numGroups; i++) {
+                TTY_U8* group     = subtable + 16 + 12 * i;
+                TTY_U32 startCode = tty_get_u32(group);
+                TTY_U32 endCode   = TTY_MIN(tty_get_u32(group + 4), 0x10FFFFu);
+                TTY_U32 glyphIdx  = tty_get_u32(group + 8);
+
+                for (TTY_U32 cp = startCode; cp <= endCode; cp++) {
+                    TTY_U16 val = isFormat13 ? glyphIdx : glyphIdx + (cp - startCode);
+                    TTY_Error error;
+                    if ((error = tty_glyph_index_map_set(map, cp, val))) {
+                        tty_glyph_index_map_free(map);
+                        return error;
+                    }
+                }
+            }
+
+            return TTY_ERROR_NONE;
+        }
+    }
+
+    // Other formats are rejected by 'tty_font_init'
+    TTY_ASSERT(TTY_FALSE);
+    tty_glyph_index_map_free(map);
+    return TTY_ERROR_UNSUPPORTED_FEATURE;
+}
+
+TTY_Error tty_font_init_outline_cache(TTY_Font* font, TTY_U32 maxSize) {
+    TTY_Outline_Cache* cache = &font->outlineCache;
+    if (cache->outlines != NULL) {
+        cache->maxSize = maxSize;
+        return TTY_ERROR_NONE;
+    }
+
+    cache->outlines = (TTY_Outline**)calloc(font->numGlyphs, sizeof(TTY_Outline*));
+    if (cache->outlines == NULL) {
+        return TTY_ERROR_OUT_OF_MEMORY;
+    }
+
+    cache->maxSize = maxSize;
+    return TTY_ERROR_NONE;
+}
+
+TTY_Error tty_glyph_init(TTY_Font* font, TTY_Glyph* glyph, TTY_U32 idx) {
+    // Note: Glyph advance, offset, and size are calculated when the glyph is rendered
+    
+    memset(glyph, 0, sizeof(TTY_Glyph));
+
+    glyph->idx       = idx;
+    glyph->glyfBlock = tty_get_glyf_data_block(font, idx);
+    
+    // If glyfBlock is NULL, the glyph is an empty glyph (i.e. space)
+    if (glyph->glyfBlock != NULL) {
+        glyph->numContours = tty_get_s16(glyph->glyfBlock);
+    }
+    
+    return TTY_ERROR_NONE;
+}
+
+
+TTY_Error tty_glyphs_init(TTY_Font* font, const TTY_U32* indices, TTY_U32 count, TTY_Glyph* glyphs) {
+    for (TTY_U32 i = 0; i < count; i++) {
+        TTY_Error error;
+        if ((error = tty_glyph_init(font, glyphs + i, indices[i]))) {
+            return error;
+        }
+    }
+    return TTY_ERROR_NONE;
+}
+
+TTY_U32 tty_get_glyph_data_size(TTY_Font* font, const TTY_Glyph* glyph) {
+    if (glyph->glyfBlock == NULL) {
+        return 0;
+    }
+
+    TTY_U32 blockOff = glyph->glyfBlock - (font->fileData + font->glyf.off);
+
+    if (glyph->idx == font->numGlyphs - 1u) {
+        return font->glyf.size > blockOff ? font->glyf.size - blockOff : 0;
+    }
+
+    TTY_U32 nextBlockOff = font->indexToLocFormat == 0 ?
+        tty_get_u16(font->fileData + font->loca.off + 2 * (glyph->idx + 1)) * 2 :
+        tty_get_u32(font->fileData + font->loca.off + 4 * (glyph->idx + 1));
+
+    return nextBlockOff > blockOff ? nextBlockOff - blockOff : 0;
+}
+
+
+/* ------------- */
+/* Image Loading */
+/* ------------- */
+TTY_Error tty_image_init(TTY_Image* image, TTY_U8* pixels, TTY_U32 w, TTY_U32 h) {
+    if (pixels == NULL) {
+        image->pixels = (TTY_U8*)calloc((size_t)w * h, 1);
+        if (image->pixels == NULL) {
+            return TTY_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    else {
+        image->pixels = pixels;
+    }
+    image->size.x = w;
+    image->size.y = h;
+    return TTY_ERROR_NONE;
+}
+
+void tty_image_free(TTY_Image* image) {
+    free(image->pixels);
+    image->pixels = NULL;
+}
+
+
+/* --------- */
+/* Rendering */
 /* --------- */
 enum {
     TTY_ON_CURVE_POINT ,
@@ -3146,7 +3726,7 @@ static TTY_Error tty_add_glyph_points_to_zone_1(TTY_Font* font, TTY_Instance* in
 
 static TTY_U16 tty_get_glyph_advance_width(TTY_Font* font, TTY_U32 glyphIdx) {
     TTY_U8* hmtxData    = font->fileData + font->hmtx.off;
-    TTY_U16 numHMetrics = tty_get_u16(font->fileData + font->hhea.off + 34);
+    TTY_U16 numHMetrics = font->numHMetrics;
     if (numHMetrics == 0) {
         TTY_ASSERT(0);
         return 0;
@@ -3179,7 +3759,7 @@ static TTY_S32 tty_get_glyph_advance_height(TTY_Font* font) {
 
 static TTY_S16 tty_get_glyph_left_side_bearing(TTY_Font* font, TTY_U32 glyphIdx) {
     TTY_U8* hmtxData    = font->fileData + font->hmtx.off;
-    TTY_U16 numHMetrics = tty_get_u16(font->fileData + font->hhea.off + 34);
+    TTY_U16 numHMetrics = font->numHMetrics;
     if (glyphIdx < numHMetrics) {
         return tty_get_s16(hmtxData + 4 * glyphIdx + 2);
     }
@@ -3368,78 +3948,128 @@ static TTY_S16 tty_get_next_simple_glyph_coord_off(TTY_U8** data, TTY_U8 dualFla
     return coord;
 }
 
-static TTY_Error tty_add_simple_glyph_points_to_zone1(TTY_Font* font, TTY_Instance* instance, TTY_Glyph* glyph) {
-    font->hint.zone1.numOutlinePoints = tty_get_u16(glyph->glyfBlock + 8 + 2 * glyph->numContours) + 1;
-    font->hint.zone1.numPoints        = font->hint.zone1.numOutlinePoints + TTY_NUM_PHANTOM_POINTS;
-    font->hint.zone1.numEndPoints     = glyph->numContours;
+static void tty_get_simple_glyph_data(TTY_Glyph* glyph, TTY_U32 numPoints, TTY_U8** flagData, TTY_U8** xData, TTY_U8** yData) {
+    // Calculate pointers to the glyph's flag data, x-coordinate data, and
+    // y-coordinate data
+    
+    TTY_U32 flagsSize = 0;
+    TTY_U32 xfileSize = 0;
+    
+    *flagData  = glyph->glyfBlock + (10 + 2 * glyph->numContours);
+    *flagData += 2 + tty_get_u16(*flagData);
+    
+    for (TTY_U32 i = 0; i < numPoints;) {
+        TTY_U8 flags = (*flagData)[flagsSize];
+        TTY_U8 xSize = flags & TTY_GLYF_X_SHORT_VECTOR ? 1 : flags & TTY_GLYF_X_DUAL ? 0 : 2;
+        TTY_U8 flagsReps;
+
+        if (flags & TTY_GLYF_REPEAT_FLAG) {
+            flagsReps = 1 + (*flagData)[flagsSize + 1];
+            flagsSize += 2;
+        }
+        else {
+            flagsReps = 1;
+            flagsSize++;
+        }
+
+        i += flagsReps;
+
+        while (flagsReps > 0) {
+            xfileSize += xSize;
+            flagsReps--;
+        }
+    }
+    
+    *xData = *flagData + flagsSize;
+    *yData = *xData    + xfileSize;
+}
+
+static void tty_get_simple_glyph_point_bounds(TTY_Glyph* glyph, TTY_V2* min, TTY_V2* max) {
+    // Equivalent to the bounds of the glyph's points once they are added to
+    // zone1, but without storing or scaling the points
 
+    TTY_U32 numPoints = tty_get_u16(glyph->glyfBlock + 8 + 2 * glyph->numContours) + 1;
     TTY_U8* flagData, *xData, *yData;
+    tty_get_simple_glyph_data(glyph, numPoints, &flagData, &xData, &yData);
+
+    TTY_V2 absPos = { 0 };
     
-    {
-        // Calculate pointers to the glyph's flag data, x-coordinate data, and
-        // y-coordinate data
+    for (TTY_U32 i = 0; i < numPoints;) {
+        TTY_U8 flags = *flagData;
+        TTY_U8 flagsReps;
         
-        TTY_U32 flagsSize = 0;
-        TTY_U32 xfileSize = 0;
-        
-        flagData  = glyph->glyfBlock + (10 + 2 * font->hint.zone1.numEndPoints);
-        flagData += 2 + tty_get_u16(flagData);
+        if (flags & TTY_GLYF_REPEAT_FLAG) {
+            flagsReps = 1 + flagData[1];
+            flagData += 2;
+        }
+        else {
+            flagsReps = 1;
+            flagData++;
+        }
         
-        for (TTY_U32 i = 0; i < font->hint.zone1.numOutlinePoints;) {
-            TTY_U8 flags = flagData[flagsSize];
-            TTY_U8 xSize = flags & TTY_GLYF_X_SHORT_VECTOR ? 1 : flags & TTY_GLYF_X_DUAL ? 0 : 2;
-            TTY_U8 flagsReps;
-
-            if (flags & TTY_GLYF_REPEAT_FLAG) {
-                flagsReps = 1 + flagData[flagsSize + 1];
-                flagsSize += 2;
-            }
-            else {
-                flagsReps = 1;
-                flagsSize++;
+        for (; flagsReps > 0; ++i, --flagsReps) {
+            absPos.x += tty_get_next_simple_glyph_coord_off(&xData, TTY_GLYF_X_DUAL, TTY_GLYF_X_SHORT_VECTOR, flags);
+            absPos.y += tty_get_next_simple_glyph_coord_off(&yData, TTY_GLYF_Y_DUAL, TTY_GLYF_Y_SHORT_VECTOR, flags);
+
+            if (i == 0) {
+                *min = absPos;
+                *max = absPos;
+                continue;
             }
 
-            i += flagsReps;
-
-            while (flagsReps > 0) {
-                xfileSize += xSize;
-                flagsReps--;
-            }
+            min->x = TTY_MIN(min->x, absPos.x);
+            min->y = TTY_MIN(min->y, absPos.y);
+            max->x = TTY_MAX(max->x, absPos.x);
+            max->y = TTY_MAX(max->y, absPos.y);
         }
-        
-        xData = flagData + flagsSize;
-        yData = xData    + xfileSize;
     }
+}
+
+static void tty_decode_simple_glyph_points(TTY_Glyph* glyph, TTY_U32 numPoints, TTY_V2* points, TTY_U8* pointTypes) {
+    TTY_U8* flagData, *xData, *yData;
+    tty_get_simple_glyph_data(glyph, numPoints, &flagData, &xData, &yData);
+
+    TTY_V2 absPos = { 0 };
     
-    {
-        // Add the points that make up the glyph's contours (i.e. outline points)
+    for (TTY_U32 i = 0; i < numPoints;) {
+        TTY_U8 flags = *flagData;
+        TTY_U8 flagsReps;
         
-        TTY_V2 absPos = { 0 };
+        if (flags & TTY_GLYF_REPEAT_FLAG) {
+            flagsReps = 1 + flagData[1];
+            flagData += 2;
+        }
+        else {
+            flagsReps = 1;
+            flagData++;
+        }
         
-        for (TTY_U32 i = 0; i < font->hint.zone1.numOutlinePoints;) {
-            TTY_U8 flags = *flagData;
-            TTY_U8 flagsReps;
-            
-            if (flags & TTY_GLYF_REPEAT_FLAG) {
-                flagsReps = 1 + flagData[1];
-                flagData += 2;
-            }
-            else {
-                flagsReps = 1;
-                flagData++;
-            }
-            
-            for (; flagsReps > 0; ++i, --flagsReps) {
-                TTY_S16 xOff = tty_get_next_simple_glyph_coord_off(&xData, TTY_GLYF_X_DUAL, TTY_GLYF_X_SHORT_VECTOR, flags);
-                TTY_S16 yOff = tty_get_next_simple_glyph_coord_off(&yData, TTY_GLYF_Y_DUAL, TTY_GLYF_Y_SHORT_VECTOR, flags);
-
-                font->hint.zone1.pointTypes[i] = flags & TTY_GLYF_ON_CURVE_POINT ? TTY_ON_CURVE_POINT : TTY_OFF_CURVE_POINT;
-                font->hint.zone1.org[i].x      = absPos.x + xOff;
-                font->hint.zone1.org[i].y      = absPos.y + yOff;
-                absPos                         = font->hint.zone1.org[i];
-            }
+        for (; flagsReps > 0; ++i, --flagsReps) {
+            TTY_S16 xOff = tty_get_next_simple_glyph_coord_off(&xData, TTY_GLYF_X_DUAL, TTY_GLYF_X_SHORT_VECTOR, flags);
+            TTY_S16 yOff = tty_get_next_simple_glyph_coord_off(&yData, TTY_GLYF_Y_DUAL, TTY_GLYF_Y_SHORT_VECTOR, flags);
+
+            pointTypes[i] = flags & TTY_GLYF_ON_CURVE_POINT ? TTY_ON_CURVE_POINT : TTY_OFF_CURVE_POINT;
+            points[i].x   = absPos.x + xOff;
+            points[i].y   = absPos.y + yOff;
+            absPos        = points[i];
         }
     }
+}
+
+static TTY_Error tty_execute_simple_glyph_program(TTY_Font* font, TTY_Instance* instance, TTY_Glyph* glyph) {
+    TTY_U32 off      = 10 + glyph->numContours * 2;
+    TTY_U16 insCount = tty_get_u16(glyph->glyfBlock + off);
+    TTY_U8* insBuff  = glyph->glyfBlock + off + 2;
+    return tty_execute_glyph_program(font, instance, glyph, insBuff, insCount);
+}
+
+static TTY_Error tty_add_simple_glyph_points_to_zone1(TTY_Font* font, TTY_Instance* instance, TTY_Glyph* glyph) {
+    font->hint.zone1.numOutlinePoints = tty_get_u16(glyph->glyfBlock + 8 + 2 * glyph->numContours) + 1;
+    font->hint.zone1.numPoints        = font->hint.zone1.numOutlinePoints + TTY_NUM_PHANTOM_POINTS;
+    font->hint.zone1.numEndPoints     = glyph->numContours;
+
+    // Add the points that make up the glyph's contours (i.e. outline points)
+    tty_decode_simple_glyph_points(glyph, font->hint.zone1.numOutlinePoints, font->hint.zone1.org, font->hint.zone1.pointTypes);
 
     tty_get_phantom_points_and_types(font, glyph, font->hint.zone1.org + font->hint.zone1.numOutlinePoints, font->hint.zone1.pointTypes + font->hint.zone1.numOutlinePoints);
     tty_scale_points(font->hint.zone1.org, font->hint.zone1.numPoints, instance->scale, font->hint.zone1.orgScaled);
@@ -3451,10 +4081,7 @@ static TTY_Error tty_add_simple_glyph_points_to_zone1(TTY_Font* font, TTY_Instan
     }
 
     if (instance->useHinting) {
-        TTY_U32 off      = 10 + glyph->numContours * 2;
-        TTY_U16 insCount = tty_get_u16(glyph->glyfBlock + off);
-        TTY_U8* insBuff  = glyph->glyfBlock + off + 2;
-        return tty_execute_glyph_program(font, instance, glyph, insBuff, insCount);
+        return tty_execute_simple_glyph_program(font, instance, glyph);
     }
 
     return TTY_ERROR_NONE;
@@ -3469,129 +4096,146 @@ static void tty_offset_zone1_buffs(TTY_Zone* zone1, TTY_S32 pointOff, TTY_S32 en
     zone1->endPointIndices += endPointOff;
 }
 
+static TTY_Error tty_get_component_offset(TTY_Glyph* glyph, TTY_U32* off, TTY_U16 flags, TTY_V2* offset) {
+    // Gets the offset of a composite glyph's component in font units (2.14) 
+    // and moves `off` past the component's arguments and transform
+
+    if (!(flags & TTY_GLYF_ARGS_ARE_XY_VALUES)) {
+        // TODO: Handle point matching (stb_truetype doesn't even
+        //       bother implementing this)
+        return TTY_ERROR_UNSUPPORTED_FEATURE;
+    }
+
+    TTY_S32 arg1, arg2;
+            
+    if (flags & TTY_GLYF_ARG_1_AND_2_ARE_WORDS) {
+        arg1 = tty_get_s16(glyph->glyfBlock + *off);
+        arg2 = tty_get_s16(glyph->glyfBlock + *off + 2);
+        *off += 4;
+    }
+    else {
+        arg1 = (TTY_S8)glyph->glyfBlock[*off];
+        arg2 = (TTY_S8)glyph->glyfBlock[*off + 1];
+        *off += 2;
+    }
+    
+    if ((flags & TTY_GLYF_UNSCALED_COMPONENT_OFFSET) == 0 && 
+        (flags & TTY_GLYF_SCALED_COMPONENT_OFFSET)) 
+    {
+        // TODO: This needs testing
+        TTY_ASSERT(TTY_FALSE);
+        
+        // TODO: Spec says to apply the transform to the glyph's points,
+        //       however, FreeType only applies it to the offset (when the
+        //       flags say to).
+        TTY_F2Dot14 transform[4] = {0};
+
+        if (flags & TTY_GLYF_WE_HAVE_A_SCALE) {
+            transform[0] = tty_get_s16(glyph->glyfBlock + *off);
+            transform[3] = 0x4000;
+            *off += 2;
+        }
+        else if (flags & TTY_GLYF_WE_HAVE_AN_X_AND_Y_SCALE) {
+            transform[0] = tty_get_s16(glyph->glyfBlock + *off    );
+            transform[3] = tty_get_s16(glyph->glyfBlock + *off + 2);
+            *off += 4;
+        }
+        else if (flags & TTY_GLYF_WE_HAVE_A_TWO_BY_TWO) {
+            transform[0] = tty_get_s16(glyph->glyfBlock + *off    );
+            transform[1] = tty_get_s16(glyph->glyfBlock + *off + 2);
+            transform[2] = tty_get_s16(glyph->glyfBlock + *off + 4);
+            transform[3] = tty_get_s16(glyph->glyfBlock + *off + 6);
+            *off += 8;
+        }
+        else {
+            transform[0] = 0x4000;
+            transform[3] = 0x4000;
+        }
+
+        offset->x = transform[0] * arg1 + transform[1] * arg2;
+        offset->y = transform[2] * arg1 + transform[3] * arg2;
+    }
+    else {
+        if (flags & TTY_GLYF_WE_HAVE_A_SCALE) {
+            *off += 2;
+        }
+        else if (flags & TTY_GLYF_WE_HAVE_AN_X_AND_Y_SCALE) {
+            *off += 4;
+        }
+        else if (flags & TTY_GLYF_WE_HAVE_A_TWO_BY_TWO) {
+            *off += 8;
+        }
+        offset->x = arg1 << 14;
+        offset->y = arg2 << 14;
+    }
+
+    return TTY_ERROR_NONE;
+}
+
+static TTY_F26Dot6_V2 tty_scale_component_offset(TTY_V2 offset, TTY_U16 flags, TTY_F10Dot22 scale) {
+    TTY_F26Dot6_V2 scaled;
+    scaled.x = TTY_F10DOT22_MUL(offset.x, scale);
+    scaled.y = TTY_F10DOT22_MUL(offset.y, scale);
+    
+    if (flags & TTY_GLYF_ROUND_XY_TO_GRID) {
+        scaled.x = tty_f2dot14_round_to_grid(scaled.x) >> 8;
+        scaled.y = tty_f2dot14_round_to_grid(scaled.y) >> 8;
+    }
+    else {
+        scaled.x = TTY_ROUNDED_DIV_POW2(scaled.x, 0x80, 8);
+        scaled.y = TTY_ROUNDED_DIV_POW2(scaled.y, 0x80, 8);
+    }
+
+    return scaled;
+}
+
 static TTY_Error tty_add_composite_glyph_points_to_zone1(TTY_Font* font, TTY_Instance* instance, TTY_Glyph* glyph) {
     TTY_U32  off             = 10;
     TTY_U32  totalPoints     = 0;
     TTY_U32  totalEndPoints  = 0;
-    TTY_U32  endPointOff     = 0;
     TTY_Bool hasInstructions = TTY_FALSE;
     
     while (TTY_TRUE) {
         TTY_U16 flags         = tty_get_u16(glyph->glyfBlock + off);
         TTY_U16 childGlyphIdx = tty_get_u16(glyph->glyfBlock + off + 2);
         off += 4;
+
+        TTY_V2 offset;
+        {
+            TTY_Error error;
+            if ((error = tty_get_component_offset(glyph, &off, flags, &offset))) {
+                return error;
+            }
+        }
         
         TTY_Glyph childGlyph;
         tty_glyph_init(font, &childGlyph, childGlyphIdx);
         
-        if (childGlyph.glyfBlock == NULL) {
-            // The glyph is an empty glyph (I don't see why this would ever occur)
-            continue;
-        }
-        
-        tty_add_glyph_points_to_zone_1(font, instance, &childGlyph);
-        
-        // Make the end point indices of the current child glyph a continuation
-        // of the end point indices of the prev child glyph
-        for (TTY_U32 i = 0; i < font->hint.zone1.numEndPoints; i++) {
-            font->hint.zone1.endPointIndices[i] += endPointOff;
-        }
-
-        totalPoints    += font->hint.zone1.numOutlinePoints;
-        totalEndPoints += font->hint.zone1.numEndPoints;
-        endPointOff     = font->hint.zone1.endPointIndices[totalEndPoints - 1];
-        
-        {
-            TTY_S32 arg1, arg2;
+        // Note: The child glyph can be an empty glyph (I don't see why this 
+        //       would ever occur)
+        if (childGlyph.glyfBlock != NULL) {
+            tty_add_glyph_points_to_zone_1(font, instance, &childGlyph);
             
-            if (flags & TTY_GLYF_ARGS_ARE_XY_VALUES) {
-                if (flags & TTY_GLYF_ARG_1_AND_2_ARE_WORDS) {
-                    arg1 = tty_get_s16(glyph->glyfBlock + off);
-                    arg2 = tty_get_s16(glyph->glyfBlock + off + 2);
-                    off += 4;
-                }
-                else {
-                    arg1 = (TTY_S8)glyph->glyfBlock[off];
-                    arg2 = (TTY_S8)glyph->glyfBlock[off + 1];
-                    off += 2;
-                }
-                
-                if ((flags & TTY_GLYF_UNSCALED_COMPONENT_OFFSET) == 0 && 
-                    (flags & TTY_GLYF_SCALED_COMPONENT_OFFSET)) 
-                {
-                    // TODO: This needs testing
-                    TTY_ASSERT(TTY_FALSE);
-                    
-                    // TODO: Spec says to apply the transform to the glyph's points,
-                    //       however, FreeType only applies it to the offset (when the
-                    //       flags say to).
-                    TTY_F2Dot14 transform[4] = {0};
-
-                    if (flags & TTY_GLYF_WE_HAVE_A_SCALE) {
-                        transform[0] = tty_get_s16(glyph->glyfBlock + off);
-                        transform[3] = 0x4000;
-                        off += 2;
-                    }
-                    else if (flags & TTY_GLYF_WE_HAVE_AN_X_AND_Y_SCALE) {
-                        transform[0] = tty_get_s16(glyph->glyfBlock + off    );
-                        transform[3] = tty_get_s16(glyph->glyfBlock + off + 2);
-                        off += 4;
-                    }
-                    else if (flags & TTY_GLYF_WE_HAVE_A_TWO_BY_TWO) {
-                        transform[0] = tty_get_s16(glyph->glyfBlock + off    );
-                        transform[1] = tty_get_s16(glyph->glyfBlock + off + 2);
-                        transform[2] = tty_get_s16(glyph->glyfBlock + off + 4);
-                        transform[3] = tty_get_s16(glyph->glyfBlock + off + 6);
-                        off += 8;
-                    }
-                    else {
-                        transform[0] = 0x4000;
-                        transform[3] = 0x4000;
-                    }
-
-                    arg1 = transform[0] * arg1 + transform[1] * arg2;
-                    arg2 = transform[2] * arg1 + transform[3] * arg2;
-                    arg1 = TTY_F10DOT22_MUL(arg1, instance->scale);
-                    arg2 = TTY_F10DOT22_MUL(arg2, instance->scale);
-                }
-                else {
-                    if (flags & TTY_GLYF_WE_HAVE_A_SCALE) {
-                        off += 2;
-                    }
-                    else if (flags & TTY_GLYF_WE_HAVE_AN_X_AND_Y_SCALE) {
-                        off += 4;
-                    }
-                    else if (flags & TTY_GLYF_WE_HAVE_A_TWO_BY_TWO) {
-                        off += 8;
-                    }
-                    arg1 = TTY_F10DOT22_MUL(arg1 << 14, instance->scale);
-                    arg2 = TTY_F10DOT22_MUL(arg2 << 14, instance->scale);
-                }
-                
-                if (flags & TTY_GLYF_ROUND_XY_TO_GRID) {
-                    arg1 = tty_f2dot14_round_to_grid(arg1) >> 8;
-                    arg2 = tty_f2dot14_round_to_grid(arg2) >> 8;
-                }
-                else {
-                    arg1 = TTY_ROUNDED_DIV_POW2(arg1, 0x80, 8);
-                    arg2 = TTY_ROUNDED_DIV_POW2(arg2, 0x80, 8);
-                }
-                
-                for (TTY_U32 i = 0; i < font->hint.zone1.numPoints; i++) {
-                    font->hint.zone1.cur[i].x += arg1;
-                    font->hint.zone1.cur[i].y += arg2;
-                }
+            // Make the end point indices of the current child glyph a 
+            // continuation of the end point indices of the prev child glyph
+            for (TTY_U32 i = 0; i < font->hint.zone1.numEndPoints; i++) {
+                font->hint.zone1.endPointIndices[i] += totalPoints;
             }
-            else {
-                // TODO: Handle point matching (stb_truetype doesn't even
-                //       bother implementing this)
-                return TTY_ERROR_UNSUPPORTED_FEATURE;
+
+            TTY_F26Dot6_V2 scaledOffset = tty_scale_component_offset(offset, flags, instance->scale);
+
+            for (TTY_U32 i = 0; i < font->hint.zone1.numPoints; i++) {
+                font->hint.zone1.cur[i].x += scaledOffset.x;
+                font->hint.zone1.cur[i].y += scaledOffset.y;
             }
-        }
 
-        // Temporarily offset the zone1 buffers so the data of the next
-        // child glyph can be added successively
-        tty_offset_zone1_buffs(&font->hint.zone1, font->hint.zone1.numOutlinePoints, font->hint.zone1.numEndPoints);
+            totalPoints    += font->hint.zone1.numOutlinePoints;
+            totalEndPoints += font->hint.zone1.numEndPoints;
+
+            // Temporarily offset the zone1 buffers so the data of the next
+            // child glyph can be added successively
+            tty_offset_zone1_buffs(&font->hint.zone1, font->hint.zone1.numOutlinePoints, font->hint.zone1.numEndPoints);
+        }
         
         if (!(flags & TTY_GLYF_MORE_COMPONENTS)) {
             hasInstructions = (flags & TTY_GLYF_WE_HAVE_INSTRUCTIONS) != 0;
@@ -3606,9 +4250,9 @@ static TTY_Error tty_add_composite_glyph_points_to_zone1(TTY_Font* font, TTY_Ins
     memcpy(font->hint.zone1.cur, font->hint.zone1.orgScaled, TTY_NUM_PHANTOM_POINTS * sizeof(TTY_F26Dot6_V2));
     tty_round_phantom_points(font->hint.zone1.cur);
     
+    // Undo the temporary offset applied to the zone1 buffers
     tty_offset_zone1_buffs(&font->hint.zone1, -(TTY_S32)totalPoints, -(TTY_S32)totalEndPoints);
 
-    // Undo the temporary offset applied to the zone1 buffers
     font->hint.zone1.numPoints        = totalPoints + TTY_NUM_PHANTOM_POINTS;
     font->hint.zone1.numOutlinePoints = totalPoints;
     font->hint.zone1.numEndPoints     = totalEndPoints;
@@ -3622,27 +4266,252 @@ static TTY_Error tty_add_composite_glyph_points_to_zone1(TTY_Font* font, TTY_Ins
     return TTY_ERROR_NONE;
 }
 
-static TTY_Error tty_add_glyph_points_to_zone_1(TTY_Font* font, TTY_Instance* instance, TTY_Glyph* glyph) {
-    if (glyph->glyfBlock == NULL) {
+static TTY_Error tty_decode_outline_into_zone1(TTY_Font* font, TTY_Glyph* glyph, TTY_U32* numPoints, TTY_U32* numEndPoints, TTY_U32* numOffsets) {
+    // Decodes the unscaled points of the glyph into zone1, starting at 
+    // `numPoints`. The components of composite glyphs are merged together, 
+    // but their offsets are recorded separately since they are scaled and 
+    // rounded independently of the glyph's points.
+
+    TTY_Outline_Cache* cache = &font->outlineCache;
+
+    if (glyph->numContours >= 0) {
+        TTY_U32 glyphPoints = tty_get_u16(glyph->glyfBlock + 8 + 2 * glyph->numContours) + 1;
+        
+        tty_decode_simple_glyph_points(glyph, glyphPoints, font->hint.zone1.org + *numPoints, font->hint.zone1.pointTypes + *numPoints);
+
+        for (TTY_S16 i = 0; i < glyph->numContours; i++) {
+            font->hint.zone1.endPointIndices[*numEndPoints + i] = *numPoints + tty_get_u16(glyph->glyfBlock + 10 + 2 * i);
+        }
+
+        *numPoints    += glyphPoints;
+        *numEndPoints += glyph->numContours;
         return TTY_ERROR_NONE;
     }
-    if (glyph->numContours < 0) {
-        return tty_add_composite_glyph_points_to_zone1(font, instance, glyph);
-    }
-    return tty_add_simple_glyph_points_to_zone1(font, instance, glyph);
-}
 
-static void tty_convert_zone1_points_into_curves(TTY_Font* font) {
-    TTY_U32 startPointIdx    = 0;
-    font->hint.curves.count = 0;
+    TTY_U32 off = 10;
 
-    for (TTY_U32 i = 0; i < font->hint.zone1.numEndPoints; i++) {
-        TTY_U32  endPointIdx   = font->hint.zone1.endPointIndices[i];
-        TTY_Bool addFinalCurve = TTY_TRUE;
+    while (TTY_TRUE) {
+        TTY_U16 flags         = tty_get_u16(glyph->glyfBlock + off);
+        TTY_U16 childGlyphIdx = tty_get_u16(glyph->glyfBlock + off + 2);
+        off += 4;
 
-        TTY_F26Dot6_V2* startPoint = font->hint.zone1.cur + startPointIdx;
-        TTY_F26Dot6_V2* nextP0     = startPoint;
-        
+        TTY_V2 offset;
+        TTY_Error error;
+        if ((error = tty_get_component_offset(glyph, &off, flags, &offset))) {
+            return error;
+        }
+        
+        TTY_Glyph childGlyph;
+        tty_glyph_init(font, &childGlyph, childGlyphIdx);
+        
+        if (childGlyph.glyfBlock != NULL) {
+            TTY_U32 firstPoint = *numPoints;
+            if ((error = tty_decode_outline_into_zone1(font, &childGlyph, numPoints, numEndPoints, numOffsets))) {
+                return error;
+            }
+
+            if (*numOffsets == cache->offsetCap) {
+                TTY_U32               newCap  = cache->offsetCap == 0 ? 8 : 2 * cache->offsetCap;
+                TTY_Component_Offset* newBuff = (TTY_Component_Offset*)realloc(cache->offsetBuff, newCap * sizeof(TTY_Component_Offset));
+                if (newBuff == NULL) {
+                    return TTY_ERROR_OUT_OF_MEMORY;
+                }
+                cache->offsetBuff = newBuff;
+                cache->offsetCap  = newCap;
+            }
+
+            TTY_Component_Offset* componentOffset = cache->offsetBuff + (*numOffsets)++;
+            componentOffset->offset     = offset;
+            componentOffset->firstPoint = firstPoint;
+            componentOffset->numPoints  = *numPoints - firstPoint;
+            componentOffset->flags      = flags;
+        }
+        
+        if (!(flags & TTY_GLYF_MORE_COMPONENTS)) {
+            return TTY_ERROR_NONE;
+        }
+    }
+}
+
+static void tty_outline_cache_remove_from_lru_list(TTY_Outline_Cache* cache, TTY_Outline* outline) {
+    if (outline->lruPrev == NULL) {
+        cache->lruHead = outline->lruNext;
+    }
+    else {
+        outline->lruPrev->lruNext = outline->lruNext;
+    }
+
+    if (outline->lruNext == NULL) {
+        cache->lruTail = outline->lruPrev;
+    }
+    else {
+        outline->lruNext->lruPrev = outline->lruPrev;
+    }
+}
+
+static void tty_outline_cache_add_to_lru_list(TTY_Outline_Cache* cache, TTY_Outline* outline) {
+    outline->lruPrev = NULL;
+    outline->lruNext = cache->lruHead;
+
+    if (cache->lruHead == NULL) {
+        cache->lruTail = outline;
+    }
+    else {
+        cache->lruHead->lruPrev = outline;
+    }
+    cache->lruHead = outline;
+}
+
+static void tty_outline_cache_evict_lru_outline(TTY_Outline_Cache* cache) {
+    TTY_Outline* outline = cache->lruTail;
+    tty_outline_cache_remove_from_lru_list(cache, outline);
+    cache->outlines[outline->glyphIdx] = NULL;
+    cache->size -= outline->size;
+    free(outline);
+}
+
+static TTY_Error tty_outline_cache_insert(TTY_Outline_Cache* cache, TTY_U32 glyphIdx, TTY_Zone* zone1, TTY_U32 numOffsets) {
+    // Copies the outline that was just decoded into zone1 into the cache
+
+    size_t off             = 0;
+    size_t totalSize       = 0;
+    size_t outlineSize     = tty_calc_mem_size(&totalSize, sizeof(TTY_Outline)                            , _Alignof(TTY_V2));
+    size_t pointsSize      = tty_calc_mem_size(&totalSize, zone1->numOutlinePoints * sizeof(TTY_V2)      , _Alignof(TTY_Component_Offset));
+    size_t offsetsSize     = tty_calc_mem_size(&totalSize, numOffsets * sizeof(TTY_Component_Offset)      , _Alignof(TTY_U16));
+    size_t endPointsSize   = tty_calc_mem_size(&totalSize, zone1->numEndPoints * sizeof(TTY_U16)         , 1);
+    /* size_t typesSize = */ tty_calc_mem_size(&totalSize, zone1->numOutlinePoints * sizeof(TTY_U8)      , 1);
+
+    if (totalSize > cache->maxSize) {
+        // The outline is too large to ever be cached
+        return TTY_ERROR_NONE;
+    }
+
+    while (cache->size + totalSize > cache->maxSize) {
+        tty_outline_cache_evict_lru_outline(cache);
+    }
+
+    TTY_U8* mem = (TTY_U8*)malloc(totalSize);
+    if (mem == NULL) {
+        return TTY_ERROR_OUT_OF_MEMORY;
+    }
+
+    TTY_Outline* outline     = (TTY_Outline*)mem;
+    outline->points          = (TTY_V2*)              (mem + (off += outlineSize));
+    outline->offsets         = (TTY_Component_Offset*)(mem + (off += pointsSize));
+    outline->endPointIndices = (TTY_U16*)             (mem + (off += offsetsSize));
+    outline->pointTypes      = (TTY_U8*)              (mem + (off += endPointsSize));
+    outline->glyphIdx        = glyphIdx;
+    outline->size            = totalSize;
+    outline->numPoints       = zone1->numOutlinePoints;
+    outline->numOffsets      = numOffsets;
+    outline->numEndPoints    = zone1->numEndPoints;
+
+    memcpy(outline->points         , zone1->org            , outline->numPoints    * sizeof(TTY_V2));
+    if (numOffsets > 0) {
+        memcpy(outline->offsets, cache->offsetBuff, numOffsets * sizeof(TTY_Component_Offset));
+    }
+    memcpy(outline->endPointIndices, zone1->endPointIndices, outline->numEndPoints * sizeof(TTY_U16));
+    memcpy(outline->pointTypes     , zone1->pointTypes     , outline->numPoints    * sizeof(TTY_U8));
+
+    cache->outlines[glyphIdx]  = outline;
+    cache->size               += totalSize;
+    tty_outline_cache_add_to_lru_list(cache, outline);
+
+    return TTY_ERROR_NONE;
+}
+
+static TTY_Error tty_add_cached_outline_points_to_zone1(TTY_Font* font, TTY_Instance* instance, TTY_Glyph* glyph) {
+    TTY_Outline_Cache*    cache   = &font->outlineCache;
+    TTY_Outline*          outline = cache->outlines[glyph->idx];
+    TTY_Zone*             zone1   = &font->hint.zone1;
+    TTY_Component_Offset* offsets;
+    TTY_U32               numOffsets;
+
+    if (outline != NULL) {
+        tty_outline_cache_remove_from_lru_list(cache, outline);
+        tty_outline_cache_add_to_lru_list(cache, outline);
+
+        zone1->numOutlinePoints = outline->numPoints;
+        zone1->numEndPoints     = outline->numEndPoints;
+        memcpy(zone1->org            , outline->points         , outline->numPoints    * sizeof(TTY_V2));
+        memcpy(zone1->pointTypes     , outline->pointTypes     , outline->numPoints    * sizeof(TTY_U8));
+        memcpy(zone1->endPointIndices, outline->endPointIndices, outline->numEndPoints * sizeof(TTY_U16));
+        
+        offsets    = outline->offsets;
+        numOffsets = outline->numOffsets;
+    }
+    else {
+        TTY_U32 numPoints    = 0;
+        TTY_U32 numEndPoints = 0;
+        
+        numOffsets = 0;
+
+        TTY_Error error;
+        if ((error = tty_decode_outline_into_zone1(font, glyph, &numPoints, &numEndPoints, &numOffsets))) {
+            return error;
+        }
+
+        zone1->numOutlinePoints = numPoints;
+        zone1->numEndPoints     = numEndPoints;
+
+        if ((error = tty_outline_cache_insert(cache, glyph->idx, zone1, numOffsets))) {
+            return error;
+        }
+
+        offsets = cache->offsetBuff;
+    }
+    
+    zone1->numPoints = zone1->numOutlinePoints + TTY_NUM_PHANTOM_POINTS;
+
+    tty_get_phantom_points_and_types(font, glyph, zone1->org + zone1->numOutlinePoints, zone1->pointTypes + zone1->numOutlinePoints);
+    tty_scale_points(zone1->org, zone1->numPoints, instance->scale, zone1->orgScaled);
+    memcpy(zone1->cur, zone1->orgScaled, zone1->numPoints * sizeof(TTY_V2));
+    tty_round_phantom_points(zone1->cur + zone1->numOutlinePoints);
+
+    for (TTY_U32 i = 0; i < numOffsets; i++) {
+        TTY_F26Dot6_V2  scaledOffset = tty_scale_component_offset(offsets[i].offset, offsets[i].flags, instance->scale);
+        TTY_F26Dot6_V2* points       = zone1->cur + offsets[i].firstPoint;
+        
+        for (TTY_U32 j = 0; j < offsets[i].numPoints; j++) {
+            points[j].x += scaledOffset.x;
+            points[j].y += scaledOffset.y;
+        }
+    }
+
+    if (instance->useHinting) {
+        TTY_ASSERT(glyph->numContours >= 0);
+        return tty_execute_simple_glyph_program(font, instance, glyph);
+    }
+
+    return TTY_ERROR_NONE;
+}
+
+static TTY_Error tty_add_glyph_points_to_zone_1(TTY_Font* font, TTY_Instance* instance, TTY_Glyph* glyph) {
+    if (glyph->glyfBlock == NULL) {
+        return TTY_ERROR_NONE;
+    }
+    if (font->outlineCache.outlines != NULL && glyph->idx < font->numGlyphs && (glyph->numContours >= 0 || !instance->useHinting)) {
+        // Note: Hinted composite glyphs can't use the cache since the glyph 
+        //       program of each component needs to be executed
+        return tty_add_cached_outline_points_to_zone1(font, instance, glyph);
+    }
+    if (glyph->numContours < 0) {
+        return tty_add_composite_glyph_points_to_zone1(font, instance, glyph);
+    }
+    return tty_add_simple_glyph_points_to_zone1(font, instance, glyph);
+}
+
+static void tty_convert_zone1_points_into_curves(TTY_Font* font) {
+    TTY_U32 startPointIdx    = 0;
+    font->hint.curves.count = 0;
+
+    for (TTY_U32 i = 0; i < font->hint.zone1.numEndPoints; i++) {
+        TTY_U32  endPointIdx   = font->hint.zone1.endPointIndices[i];
+        TTY_Bool addFinalCurve = TTY_TRUE;
+
+        TTY_F26Dot6_V2* startPoint = font->hint.zone1.cur + startPointIdx;
+        TTY_F26Dot6_V2* nextP0     = startPoint;
+        
         for (TTY_U32 j = startPointIdx + 1; j <= endPointIdx; j++) {
             TTY_ASSERT(font->hint.curves.count < font->hint.curves.cap);
             TTY_Curve* curve = font->hint.curves.buff + font->hint.curves.count;
@@ -3701,6 +4570,23 @@ static void tty_edge_init(TTY_Edge* edge, TTY_F26Dot6_V2 p0, TTY_F26Dot6_V2 p1)
     tty_max_min(p0.y, p1.y, &edge->yMax, &edge->yMin);
 }
 
+static TTY_Error tty_add_edge(TTY_Edges* edges, TTY_F26Dot6_V2 p0, TTY_F26Dot6_V2 p1) {
+    if (edges->count == edges->cap) {
+        TTY_U32   newCap  = edges->cap * 2;
+        TTY_Edge* newBuff = (TTY_Edge*)realloc(edges->buff, newCap * sizeof(TTY_Edge));
+        if (newBuff == NULL) {
+            return TTY_ERROR_OUT_OF_MEMORY;
+        }
+
+        edges->cap  = newCap;
+        edges->buff = newBuff;
+    }
+
+    tty_edge_init(edges->buff + edges->count, p0, p1);
+    edges->count++;
+    return TTY_ERROR_NONE;
+}
+
 static TTY_Error tty_subdivide_curve_into_edges(TTY_Edges* edges, TTY_F26Dot6_V2 p0, TTY_F26Dot6_V2 p1, TTY_F26Dot6_V2 p2) {
     #define TTY_SUBDIVIDE(a, b)\
         { TTY_F26DOT6_MUL((a.x + b.x), 0x20),\
@@ -3718,20 +4604,7 @@ static TTY_Error tty_subdivide_curve_into_edges(TTY_Edges* edges, TTY_F26Dot6_V2
         TTY_F26Dot6 sqrdError = TTY_F26DOT6_MUL(d.x, d.x) + TTY_F26DOT6_MUL(d.y, d.y);
 
         if (sqrdError <= TTY_SUBDIVIDE_SQRD_ERROR) {
-            if (edges->count == edges->cap) {
-                TTY_U32   newCap  = edges->cap * 2;
-                TTY_Edge* newBuff = (TTY_Edge*)realloc(edges->buff, newCap * sizeof(TTY_Edge));
-                if (newBuff == NULL) {
-                    return TTY_ERROR_OUT_OF_MEMORY;
-                }
-
-                edges->cap  = newCap;
-                edges->buff = newBuff;
-            }
-
-            tty_edge_init(edges->buff + edges->count, p0, p2);
-            edges->count++;
-            return TTY_ERROR_NONE;
+            return tty_add_edge(edges, p0, p2);
         }
     }
 
@@ -3764,8 +4637,10 @@ static TTY_Error tty_subdivide_curves_into_edges(TTY_Font* font, TTY_Edges* edge
             // The curve is a already straight line, no need to flatten it
 
             if (curve->p0.y != curve->p2.y) { // Horizontal lines can be ignored 
-                tty_edge_init(edges->buff + edges->count, curve->p0, curve->p2);
-                edges->count++;
+                TTY_Error error;
+                if ((error = tty_add_edge(edges, curve->p0, curve->p2))) {
+                    return error;
+                }
             }
         }
         else {
@@ -4132,6 +5007,40 @@ static void tty_rasterize_using_active_edges(TTY_Active_Edge_List* activeEdges,
     }
 }
 
+static void tty_fill_spans_using_active_edges(TTY_Active_Edge_List* activeEdges, TTY_U8* row, TTY_S32 rowLen, TTY_S32 rowOff) {
+    // Each pixel is sampled once at its center. A pixel is filled if its
+    // center lies between two x-intersections and the winding number between
+    // them is non-zero.
+
+    memset(row, 0, rowLen);
+
+    if (activeEdges->headEdge == NULL || activeEdges->headEdge->next == NULL) {
+        return;
+    }
+
+    TTY_Active_Edge* activeEdge    = activeEdges->headEdge;
+    TTY_S32          windingNumber = 0;
+
+    while (activeEdge->next != NULL) {
+        windingNumber += activeEdge->edge->direction;
+
+        if (windingNumber != 0) {
+            // The pixel at index i has its center at i * 0x40 + 0x20
+            TTY_S32 start = (tty_f26dot6_ceil(activeEdge->xIntersection       - 0x20) >> 6) - rowOff;
+            TTY_S32 end   = (tty_f26dot6_ceil(activeEdge->next->xIntersection - 0x20) >> 6) - rowOff;
+            
+            start = TTY_MAX(start, 0);
+            end   = TTY_MIN(end, rowLen);
+
+            if (start < end) {
+                memset(row + start, 0xFF, end - start);
+            }
+        }
+
+        activeEdge = activeEdge->next;
+    }
+}
+
 static TTY_Error tty_render_glyph_impl(TTY_Font* font, TTY_Instance* instance, TTY_Glyph* glyph, TTY_Image* image, TTY_U32 x, TTY_U32 y) {
     if (glyph->glyfBlock == NULL) {
         // The glyph is an empty glyph (i.e. space)
@@ -4167,6 +5076,10 @@ static TTY_Error tty_render_glyph_impl(TTY_Font* font, TTY_Instance* instance, T
     TTY_F26Dot6* pixelBuff    = NULL;
     TTY_U32      pixelBuffLen = 0;
 
+    // The index of the pixel buffer (or x-intersection pixel) that maps to
+    // the first pixel of each image row.
+    TTY_U32 pixelBuffOff = 0;
+
     // If the image's pixels were allocated by this function, this function
     // needs to free them if an error occurs.
     TTY_Bool imagePixelsWereAllocated = TTY_FALSE;
@@ -4237,14 +5150,20 @@ static TTY_Error tty_render_glyph_impl(TTY_Font* font, TTY_Instance* instance, T
     // Note: When min.x is < 0, all x-intersections are offset by ceil(-min.x).
     //       This means max.x needs to also be offset by this much.
     xIntersectionOff = min.x < 0 ? tty_f26dot6_ceil(-min.x) : 0;
-    pixelBuffLen     = (tty_f26dot6_ceil(max.x) >> 6) + (xIntersectionOff >> 6);
-    pixelBuff        = (TTY_F26Dot6*)calloc(pixelBuffLen, sizeof(TTY_F26Dot6));
-    if (pixelBuff == NULL) {
-        free(edges.buff);
-        if (imagePixelsWereAllocated) {
-            free(image->pixels);
+    pixelBuffOff     = glyph->offset.x <= 0 ? 0 : glyph->offset.x;
+
+    if (!instance->useBinaryRendering) {
+        // Binary rendering writes spans directly to the image, so it doesn't
+        // need the pixel buffer
+        pixelBuffLen = (tty_f26dot6_ceil(max.x) >> 6) + (xIntersectionOff >> 6);
+        pixelBuff    = (TTY_F26Dot6*)calloc(pixelBuffLen, sizeof(TTY_F26Dot6));
+        if (pixelBuff == NULL) {
+            free(edges.buff);
+            if (imagePixelsWereAllocated) {
+                free(image->pixels);
+            }
+            return TTY_ERROR_OUT_OF_MEMORY;
         }
-        return TTY_ERROR_OUT_OF_MEMORY;
     }
 
 
@@ -4263,9 +5182,41 @@ static TTY_Error tty_render_glyph_impl(TTY_Font* font, TTY_Instance* instance, T
 
     scanlineStart = tty_f26dot6_ceil(max.y);
     scanlineEnd   = tty_f26dot6_floor(min.y);
-    scanline      = scanlineStart;
 
 
+    if (instance->useBinaryRendering) {
+        // Each row of pixels is sampled by a single scanline through the
+        // centers of the row's pixels
+        scanline = scanlineStart - 0x20;
+
+        while (scanline > scanlineEnd) {
+            tty_update_or_remove_active_edges(&activeEdges, scanline, xIntersectionOff);
+            tty_sort_active_edges(&activeEdges);
+
+            {
+                TTY_Error error;
+                if ((error = tty_insert_new_active_edges(&activeEdges, &edges, scanline, xIntersectionOff))) {
+                    free(edges.buff);
+                    tty_active_edge_list_free(&activeEdges);
+                    return error;
+                }
+            }
+
+            TTY_ASSERT(y < image->size.y);
+            tty_fill_spans_using_active_edges(&activeEdges, image->pixels + y * image->size.x + x, glyph->size.x, pixelBuffOff);
+            
+            y++;
+            scanline -= 0x40;
+        }
+
+        free(edges.buff);
+        tty_active_edge_list_free(&activeEdges);
+        return TTY_ERROR_NONE;
+    }
+
+
+    scanline = scanlineStart;
+
     while (scanline >= scanlineEnd) {
         tty_update_or_remove_active_edges(&activeEdges, scanline, xIntersectionOff);
         tty_sort_active_edges(&activeEdges);
@@ -4287,8 +5238,7 @@ static TTY_Error tty_render_glyph_impl(TTY_Font* font, TTY_Instance* instance, T
             // A new row of pixels has been reached, transfer the values
             // accumulated in the pixel buffer to the image
 
-            TTY_U32 imageOff     = y * image->size.x + x;
-            TTY_U32 pixelBuffOff = glyph->offset.x <= 0 ? 0 : glyph->offset.x;
+            TTY_U32 imageOff = y * image->size.x + x;
             
             for (TTY_S32 i = 0; i < glyph->size.x; i++) {
                 TTY_U32 pixelBuffIdx = i + pixelBuffOff;
@@ -4325,17 +5275,107 @@ TTY_Error tty_render_glyph_to_existing_image(TTY_Font* font, TTY_Instance* insta
 }
 
 
+TTY_Error tty_get_glyph_metrics(TTY_Font* font, TTY_Instance* instance, TTY_Glyph* glyph) {
+    if (glyph->glyfBlock == NULL) {
+        // The glyph is an empty glyph (i.e. space)
+        glyph->advance.x = tty_get_unhinted_glyph_x_advance(font, glyph->idx, instance->scale);
+        glyph->advance.y = tty_get_unhinted_glyph_y_advance(font, instance->scale);
+        glyph->offset.x  = 0;
+        glyph->offset.y  = 0;
+        glyph->size.x    = 0;
+        glyph->size.y    = 0;
+        return TTY_ERROR_NONE;
+    }
+
+    TTY_F26Dot6_V2 min, max;
+
+    if (instance->useHinting || glyph->numContours < 0) {
+        // Hinting can move points and component offsets are rounded after 
+        // being scaled, so the bounding box stored in the glyf table can't 
+        // be used. The glyph's points are still not rasterized.
+        TTY_Error error;
+        if ((error = tty_add_glyph_points_to_zone_1(font, instance, glyph))) {
+            return error;
+        }
+        if (instance->useHinting) {
+            memset(font->hint.zone1.touchFlags, TTY_UNTOUCHED, sizeof(TTY_U8) * font->hint.zone1.numOutlinePoints);
+        }
+        tty_get_min_and_max_zone1_points(&font->hint.zone1, &min, &max);
+    }
+    else {
+        // Note: The bounding box in the glyf header isn't used since some 
+        //       fonts store the bounds of the curves rather than the bounds of
+        //       the points, which can be smaller than the rendered glyph.
+        //
+        // Scaling is monotonic, so the scaled bounds of the points are the 
+        // bounds of the scaled points.
+        tty_get_simple_glyph_point_bounds(glyph, &min, &max);
+        min.x = TTY_F10DOT22_MUL(min.x << 6, instance->scale);
+        min.y = TTY_F10DOT22_MUL(min.y << 6, instance->scale);
+        max.x = TTY_F10DOT22_MUL(max.x << 6, instance->scale);
+        max.y = TTY_F10DOT22_MUL(max.y << 6, instance->scale);
+    }
+
+    tty_set_glyph_metrics(font, instance, glyph, min, max);
+    return TTY_ERROR_NONE;
+}
+
+
 /* ----------- */
 /* Atlas Cache */
 /* ----------- */
-#define TTY_HASH(key) (177573 + key)
+#define TTY_ATLAS_CACHE_NONE 0xFFFFFFFF /* Used for empty slots, the end of entry lists, and missing shelves */
+
+static TTY_U32 tty_atlas_cache_hash(TTY_U32 cp) {
+    // MurmurHash3's finalizer, sequential code points end up far apart
+    cp ^= cp >> 16;
+    cp *= 0x85EBCA6B;
+    cp ^= cp >> 13;
+    cp *= 0xC2B2AE35;
+    cp ^= cp >> 16;
+    return cp;
+}
 
 TTY_Error tty_atlas_cache_init(TTY_Instance* instance, TTY_Atlas_Cache* cache, TTY_U32 w, TTY_U32 h) {
-    TTY_U32 maxGlyphs      =    (w / instance->maxGlyphSize.x) * (h / instance->maxGlyphSize.y);
-    size_t  totalSize      =    0;
-    size_t  imageSize      =    tty_calc_mem_size(&totalSize, w         * h                            , _Alignof(TTY_Atlas_Cache_Node));
-    size_t  nodesSize      =    tty_calc_mem_size(&totalSize, maxGlyphs * sizeof(TTY_Atlas_Cache_Node) , _Alignof(TTY_Atlas_Cache_Node*));
-    /*size_t chainHeadsSize =*/ tty_calc_mem_size(&totalSize, maxGlyphs * sizeof(TTY_Atlas_Cache_Node*), 1);
+    return tty_atlas_cache_init_paged(instance, cache, w, h, 1);
+}
+
+TTY_Error tty_atlas_cache_init_paged(TTY_Instance* instance, TTY_Atlas_Cache* cache, TTY_U32 w, TTY_U32 h, TTY_U32 maxPages) {
+    TTY_U32_V2 maxGlyphSize;
+    maxGlyphSize.x = instance->maxGlyphSize.x;
+    maxGlyphSize.y = instance->maxGlyphSize.y;
+    return tty_atlas_cache_init_custom(cache, maxGlyphSize, w, h, maxPages);
+}
+
+TTY_Error tty_atlas_cache_init_custom(TTY_Atlas_Cache* cache, TTY_U32_V2 maxGlyphSize, TTY_U32 w, TTY_U32 h, TTY_U32 maxPages) {
+    // Note: Glyphs are packed using their actual sizes, so the number of 
+    //       glyphs that fit is estimated from the maximum glyph size. Shelves 
+    //       are evicted if the cache runs out of entries before it runs out of 
+    //       space.
+    TTY_U32 maxSlots       = (w / TTY_MAX(maxGlyphSize.x, 1)) * (h / TTY_MAX(maxGlyphSize.y, 1));
+    TTY_U32 maxGlyphs      = TTY_MAX(maxSlots, 1) * TTY_ATLAS_CACHE_GLYPHS_PER_SLOT * maxPages;
+    TTY_U32 shelvesPerPage = h / TTY_ATLAS_CACHE_SHELF_ALIGN + 1;
+    TTY_U32 maxShelves     = shelvesPerPage * maxPages + 1;
+    
+    // The hash table is kept at most half full so probe sequences stay short
+    TTY_U32 numSlots = 1;
+    while (numSlots < 2 * maxGlyphs) {
+        numSlots <<= 1;
+    }
+
+    // Note: Only the first page's pixels are allocated upfront
+    size_t off                =   0;
+    size_t totalSize          =   0;
+    size_t imageSize          =   tty_calc_mem_size(&totalSize, w          * h                                       , _Alignof(TTY_Atlas_Cache_Slot));
+    size_t slotsSize          =   tty_calc_mem_size(&totalSize, numSlots   * sizeof(TTY_Atlas_Cache_Slot)            , _Alignof(TTY_U32));
+    size_t codePointsSize     =   tty_calc_mem_size(&totalSize, maxGlyphs  * sizeof(TTY_U32)                         , _Alignof(TTY_U32_V2));
+    size_t atlasPositionsSize =   tty_calc_mem_size(&totalSize, maxGlyphs  * sizeof(TTY_U32_V2)                      , _Alignof(TTY_Glyph));
+    size_t glyphsSize         =   tty_calc_mem_size(&totalSize, maxGlyphs  * sizeof(TTY_Glyph)                       , _Alignof(TTY_U32));
+    size_t entryShelvesSize   =   tty_calc_mem_size(&totalSize, maxGlyphs  * sizeof(TTY_U32)                         , _Alignof(TTY_U32));
+    size_t nextEntriesSize    =   tty_calc_mem_size(&totalSize, maxGlyphs  * sizeof(TTY_U32)                         , _Alignof(TTY_Atlas_Cache_Shelf));
+    size_t shelvesSize        =   tty_calc_mem_size(&totalSize, maxShelves * sizeof(TTY_Atlas_Cache_Shelf)           , _Alignof(TTY_Atlas_Cache_Page));
+    size_t pagesSize          =   tty_calc_mem_size(&totalSize, maxPages   * sizeof(TTY_Atlas_Cache_Page)            , _Alignof(TTY_Rect));
+    /*size_t dirtyRectsSize   =*/ tty_calc_mem_size(&totalSize, maxPages   * shelvesPerPage * sizeof(TTY_Rect)       , 1);
 
     memset(cache, 0, sizeof(TTY_Atlas_Cache));
 
@@ -4344,178 +5384,1164 @@ TTY_Error tty_atlas_cache_init(TTY_Instance* instance, TTY_Atlas_Cache* cache, T
         return TTY_ERROR_OUT_OF_MEMORY;
     }
 
-    tty_image_init(&cache->atlas, cache->mem, w, h);
+    cache->slots          = (TTY_Atlas_Cache_Slot*) (cache->mem + (off += imageSize));
+    cache->codePoints     = (TTY_U32*)              (cache->mem + (off += slotsSize));
+    cache->atlasPositions = (TTY_U32_V2*)           (cache->mem + (off += codePointsSize));
+    cache->glyphs         = (TTY_Glyph*)            (cache->mem + (off += atlasPositionsSize));
+    cache->entryShelves   = (TTY_U32*)              (cache->mem + (off += glyphsSize));
+    cache->nextEntries    = (TTY_U32*)              (cache->mem + (off += entryShelvesSize));
+    cache->shelves        = (TTY_Atlas_Cache_Shelf*)(cache->mem + (off += nextEntriesSize));
+    cache->pages          = (TTY_Atlas_Cache_Page*) (cache->mem + (off += shelvesSize));
+    cache->pageSize.x     = w;
+    cache->pageSize.y     = h;
+    cache->slotMask       = numSlots - 1;
+    cache->freeEntries    = 0;
+    cache->shelvesPerPage = shelvesPerPage;
+    cache->numPages       = 1;
+    cache->maxPages       = maxPages;
+    cache->numGlyphs      = 0;
+    cache->maxGlyphs      = maxGlyphs;
+    cache->maxGlyphSize   = maxGlyphSize;
+
+    {
+        TTY_Rect* dirtyRects = (TTY_Rect*)(cache->mem + (off += pagesSize));
+        for (TTY_U32 i = 0; i < maxPages; i++) {
+            cache->pages[i].dirtyRects = dirtyRects + i * shelvesPerPage; // Rects in the same shelf usually merge
+        }
+    }
+
+    tty_image_init(&cache->pages[0].image, cache->mem, w, h);
+
+    for (TTY_U32 i = 0; i < numSlots; i++) {
+        cache->slots[i].codePoint = TTY_ATLAS_CACHE_NONE;
+    }
+
+    for (TTY_U32 i = 0; i < maxGlyphs; i++) {
+        cache->nextEntries[i] = i + 1 < maxGlyphs ? i + 1 : TTY_ATLAS_CACHE_NONE;
+    }
 
-    cache->numGlyphs  = 0;
-    cache->maxGlyphs  = maxGlyphs;
-    cache->slotSize.x = instance->maxGlyphSize.x;
-    cache->slotSize.y = instance->maxGlyphSize.y;
-    cache->nodes      = (TTY_Atlas_Cache_Node*) (cache->mem + imageSize);
-    cache->chainHeads = (TTY_Atlas_Cache_Node**)(cache->mem + imageSize + nodesSize);
+    for (TTY_U32 i = 0; i < maxShelves; i++) {
+        cache->shelves[i].firstEntry = TTY_ATLAS_CACHE_NONE;
+    }
 
     return TTY_ERROR_NONE;
 }
 
 void tty_atlas_cache_free(TTY_Atlas_Cache* cache) {
-    if (cache != NULL) {
+    if (cache != NULL && cache->mem != NULL) {
+        // The first page's pixels are part of mem
+        for (TTY_U32 i = 1; i < cache->numPages; i++) {
+            free(cache->pages[i].image.pixels);
+        }
         free(cache->mem);
+        cache->mem = NULL;
     }
 }
 
-static TTY_Atlas_Cache_Node* tty_atlas_cache_get_no_update(TTY_Atlas_Cache* cache, TTY_U32 cp) {
-    TTY_U32               idx  = TTY_HASH(cp) % cache->maxGlyphs;
-    TTY_Atlas_Cache_Node* node = cache->chainHeads[idx];
-    
-    while (node != NULL) {
-        if (node->codePoint == cp) {
-            return node;
-        }
-        node = node->next;
-    }
+static TTY_U32 tty_atlas_cache_get_first_shelf(TTY_Atlas_Cache* cache, TTY_U32 page) {
+    return 1 + page * cache->shelvesPerPage;
+}
 
-    return NULL;
+static TTY_U32 tty_atlas_cache_get_shelf_page(TTY_Atlas_Cache* cache, TTY_U32 shelf) {
+    TTY_ASSERT(shelf != 0);
+    return (shelf - 1) / cache->shelvesPerPage;
 }
 
-static void tty_atlas_cache_touch_node(TTY_Atlas_Cache* cache, TTY_Atlas_Cache_Node* node) {
-    if (node == cache->lruTail) {
-        cache->lruTail = cache->lruTail->lruPrev;
+static TTY_Bool tty_atlas_cache_shelf_is_used(TTY_Atlas_Cache* cache, TTY_U32 shelf) {
+    if (shelf == 0) {
+        return TTY_TRUE;
     }
-    node->lruPrev->lruNext  = node->lruNext;
-    node->lruNext           = cache->lruHead;
-    node->lruPrev           = NULL;
-    cache->lruHead->lruPrev = node;
-    cache->lruHead          = node;
+    TTY_U32 page = tty_atlas_cache_get_shelf_page(cache, shelf);
+    return page < cache->numPages && shelf - tty_atlas_cache_get_first_shelf(cache, page) < cache->pages[page].numShelves;
 }
 
-static TTY_Atlas_Cache_Node* tty_atlas_cache_get(TTY_Atlas_Cache* cache, TTY_U32 cp) {
-    TTY_Atlas_Cache_Node* node = tty_atlas_cache_get_no_update(cache, cp);
-    if (node != NULL) {
-        // Code point found, update the LRU list
-        tty_atlas_cache_touch_node(cache, node);
+static TTY_U32 tty_atlas_cache_get_no_update(TTY_Atlas_Cache* cache, TTY_U32 cp) {
+    // Returns the code point's entry, or TTY_ATLAS_CACHE_NONE if it isn't 
+    // cached. The slots are loaded atomically since the concurrent cache
+    // looks up code points while another thread modifies the table.
+
+    TTY_U32 slot = tty_atlas_cache_hash(cp) & cache->slotMask;
+    
+    while (TTY_TRUE) {
+        TTY_U32 slotCp = TTY_ATOMIC_LOAD_RELAXED(&cache->slots[slot].codePoint);
+        if (slotCp == TTY_ATLAS_CACHE_NONE) {
+            break;
+        }
+        if (slotCp == cp) {
+            return TTY_ATOMIC_LOAD_RELAXED(&cache->slots[slot].entry);
+        }
+        slot = (slot + 1) & cache->slotMask;
     }
-    return node;
+
+    return TTY_ATLAS_CACHE_NONE;
 }
 
-static void tty_atlas_cache_add_node_to_chain(TTY_Atlas_Cache* cache, TTY_Atlas_Cache_Node* node) {
-    TTY_Atlas_Cache_Node** chainHead = cache->chainHeads + (TTY_HASH(node->codePoint) % cache->maxGlyphs);
-    if (*chainHead != NULL) {
-        // There is a collision
-        node->next = *chainHead;
+static TTY_U32 tty_atlas_cache_get(TTY_Atlas_Cache* cache, TTY_U32 cp) {
+    TTY_U32 entry = tty_atlas_cache_get_no_update(cache, cp);
+    if (entry != TTY_ATLAS_CACHE_NONE) {
+        // Code point found, give its shelf a second chance
+        cache->shelves[cache->entryShelves[entry]].isReferenced = TTY_TRUE;
     }
-    *chainHead = node;
+    return entry;
 }
 
-static void tty_atlas_cache_add_node_to_lru_list(TTY_Atlas_Cache* cache, TTY_Atlas_Cache_Node* node) {
-    if (cache->lruHead == NULL) {
-        cache->lruHead = node;
-        cache->lruTail = node;
+static void tty_atlas_cache_add_to_table(TTY_Atlas_Cache* cache, TTY_U32 cp, TTY_U32 entry) {
+    TTY_U32 slot = tty_atlas_cache_hash(cp) & cache->slotMask;
+    while (cache->slots[slot].codePoint != TTY_ATLAS_CACHE_NONE) {
+        slot = (slot + 1) & cache->slotMask;
     }
-    else {
-        cache->lruHead->lruPrev = node;
-        node->lruNext           = cache->lruHead;
-    }
-    cache->lruHead = node;
+    TTY_ATOMIC_STORE_RELAXED(&cache->slots[slot].codePoint, cp);
+    TTY_ATOMIC_STORE_RELAXED(&cache->slots[slot].entry,     entry);
 }
 
-static void tty_atlas_cache_insert(TTY_Atlas_Cache* cache, TTY_U32 cp) {
-    TTY_ASSERT(cache->numGlyphs < cache->maxGlyphs);
-    
-    TTY_Atlas_Cache_Node* node = cache->nodes + cache->numGlyphs;
-    node->codePoint = cp;
-    
-    tty_atlas_cache_add_node_to_chain(cache, node);
-    tty_atlas_cache_add_node_to_lru_list(cache, node);
+static void tty_atlas_cache_remove_from_table(TTY_Atlas_Cache* cache, TTY_U32 cp) {
+    TTY_U32 slot = tty_atlas_cache_hash(cp) & cache->slotMask;
+    while (cache->slots[slot].codePoint != cp) {
+        TTY_ASSERT(cache->slots[slot].codePoint != TTY_ATLAS_CACHE_NONE);
+        slot = (slot + 1) & cache->slotMask;
+    }
 
-    cache->numGlyphs++;
-}
+    // Shift the following slots of the probe sequence back so that lookups 
+    // never stop early at the removed slot (no tombstones are needed)
+    TTY_U32 next = slot;
+    while (TTY_TRUE) {
+        next = (next + 1) & cache->slotMask;
 
-static void tty_atlas_cache_remove_lru_node_from_its_chain(TTY_Atlas_Cache* cache) {
-    TTY_U32               idx  = TTY_HASH(cache->lruTail->codePoint) % cache->maxGlyphs;
-    TTY_Atlas_Cache_Node* node = cache->chainHeads[idx];
-    TTY_Atlas_Cache_Node* prev = NULL;
+        TTY_U32 nextCp = cache->slots[next].codePoint;
+        if (nextCp == TTY_ATLAS_CACHE_NONE) {
+            break;
+        }
 
-    while (node != cache->lruTail) {
-        TTY_ASSERT(node != NULL);
-        prev = node;
-        node = node->next;
+        // The slot can be moved back if the gap is within its probe sequence
+        TTY_U32 home = tty_atlas_cache_hash(nextCp) & cache->slotMask;
+        if (((next - home) & cache->slotMask) >= ((next - slot) & cache->slotMask)) {
+            TTY_ATOMIC_STORE_RELAXED(&cache->slots[slot].codePoint, nextCp);
+            TTY_ATOMIC_STORE_RELAXED(&cache->slots[slot].entry,     cache->slots[next].entry);
+            slot = next;
+        }
     }
+    
+    TTY_ATOMIC_STORE_RELAXED(&cache->slots[slot].codePoint, TTY_ATLAS_CACHE_NONE);
+}
 
-    if (prev == NULL) {
-        // The node is the first node in the chain
-        cache->chainHeads[idx] = cache->chainHeads[idx]->next;
-    }
-    else {
-        prev->next = node->next;
-    }
+static TTY_Rect tty_get_rect_union(TTY_Rect* a, TTY_Rect* b) {
+    TTY_Rect result;
+    result.pos.x  = TTY_MIN(a->pos.x, b->pos.x);
+    result.pos.y  = TTY_MIN(a->pos.y, b->pos.y);
+    result.size.x = TTY_MAX(a->pos.x + a->size.x, b->pos.x + b->size.x) - result.pos.x;
+    result.size.y = TTY_MAX(a->pos.y + a->size.y, b->pos.y + b->size.y) - result.pos.y;
+    return result;
 }
 
-static void tty_atlas_cache_replace(TTY_Atlas_Cache* cache, TTY_U32 cp) {
-    TTY_ASSERT(cache->lruTail != NULL);
-    tty_atlas_cache_remove_lru_node_from_its_chain(cache);
-    cache->lruTail->codePoint = cp;
-    tty_atlas_cache_add_node_to_chain(cache, cache->lruTail);
-    tty_atlas_cache_touch_node(cache, cache->lruTail);
+static TTY_U32 tty_get_rect_area(TTY_Rect* rect) {
+    return rect->size.x * rect->size.y;
 }
 
-TTY_Error tty_atlas_cache_get_entry(TTY_Font* font, TTY_Instance* instance, TTY_Atlas_Cache* cache, TTY_Atlas_Cache_Entry* entry, TTY_U32 codePoint) {
-    {
-        TTY_Atlas_Cache_Node* node = tty_atlas_cache_get(cache, codePoint);
-        if (node != NULL) {
-            // The entry was cached
-            *entry = node->entry;
-            return TTY_ERROR_NONE;
-        }
+static void tty_atlas_cache_add_dirty_rect(TTY_Atlas_Cache* cache, TTY_U32 pageIdx, TTY_U32 x, TTY_U32 y, TTY_U32 w, TTY_U32 h) {
+    if (w == 0 || h == 0) {
+        return;
     }
 
-    if (tty_atlas_cache_is_full(cache)) {
-        // The cache is full, replace the LRU entry
-        
-        entry->atlasPos = cache->lruTail->entry.atlasPos; // The new atlas position is the same as athe old one
-        tty_atlas_cache_replace(cache, codePoint);
-
-        // Clear the previously rendered glyph from the atlas
-        TTY_U32 offset = entry->atlasPos.x + (cache->atlas.size.x * entry->atlasPos.y);
-        TTY_U32 yEnd   = entry->atlasPos.y + cache->slotSize.y;
-
-        for (TTY_U32 y = entry->atlasPos.y; y < yEnd; y++) {
-            memset(cache->atlas.pixels + offset, 0, cache->slotSize.x);
-            offset += cache->atlas.size.x;
+    TTY_Atlas_Cache_Page* page = cache->pages + pageIdx;
+
+    TTY_Rect rect;
+    rect.pos.x  = x;
+    rect.pos.y  = y;
+    rect.size.x = w;
+    rect.size.y = h;
+
+    // Merge the rect with existing rects as long as the merged rect wastes at
+    // most a quarter of its area (i.e. the pixels that aren't dirty). Merging
+    // can make the rect overlap other rects, so this is repeated until 
+    // nothing changes.
+    TTY_Bool merged = TTY_TRUE;
+    while (merged) {
+        merged = TTY_FALSE;
+
+        for (TTY_U32 i = 0; i < page->numDirtyRects; i++) {
+            TTY_Rect* other    = page->dirtyRects + i;
+            TTY_Rect  combined = tty_get_rect_union(&rect, other);
+            TTY_U32   area     = tty_get_rect_area(&combined);
+            TTY_U32   wasted   = area - TTY_MIN(area, tty_get_rect_area(&rect) + tty_get_rect_area(other));
+
+            if (wasted <= area / 4) {
+                rect   = combined;
+                merged = TTY_TRUE;
+                *other = page->dirtyRects[--page->numDirtyRects];
+                break;
+            }
         }
     }
-    else {
-        tty_atlas_cache_insert(cache, codePoint);
-        
-        entry->atlasPos.x = cache->nextAtlasPos.x;
-        entry->atlasPos.y = cache->nextAtlasPos.y;
 
-        // TODO: Figure out a way where zero-sized glyphs don't have to be 
-        //       put in the texture atlas?
-        cache->nextAtlasPos.x += cache->slotSize.x;
-        if (cache->nextAtlasPos.x + cache->slotSize.x > cache->atlas.size.x) {
-            cache->nextAtlasPos.x = 0;
-            cache->nextAtlasPos.y += cache->slotSize.y;
+    if (page->numDirtyRects == cache->shelvesPerPage) {
+        // There is no room for another rect, merge it with the rect that 
+        // grows the least
+        TTY_U32 bestRect   = 0;
+        TTY_U32 bestGrowth = 0xFFFFFFFF;
+
+        for (TTY_U32 i = 0; i < page->numDirtyRects; i++) {
+            TTY_Rect combined = tty_get_rect_union(&rect, page->dirtyRects + i);
+            TTY_U32  growth   = tty_get_rect_area(&combined) - tty_get_rect_area(page->dirtyRects + i);
+            if (growth < bestGrowth) {
+                bestRect   = i;
+                bestGrowth = growth;
+            }
         }
-    }
 
+        page->dirtyRects[bestRect] = tty_get_rect_union(&rect, page->dirtyRects + bestRect);
+        return;
+    }
+
+    page->dirtyRects[page->numDirtyRects++] = rect;
+}
+
+static void tty_atlas_cache_evict_shelf(TTY_Atlas_Cache* cache, TTY_U32 shelfIdx) {
+    TTY_Atlas_Cache_Shelf* shelf = cache->shelves + shelfIdx;
+    TTY_U32                entry = shelf->firstEntry;
+
+    while (entry != TTY_ATLAS_CACHE_NONE) {
+        TTY_U32 next = cache->nextEntries[entry];
+        tty_atlas_cache_remove_from_table(cache, cache->codePoints[entry]);
+        cache->nextEntries[entry] = cache->freeEntries;
+        cache->freeEntries        = entry;
+        cache->numGlyphs--;
+        entry = next;
+    }
+
+    if (shelfIdx != 0) {
+        // Clear the previously rendered glyphs from the page
+        TTY_U32    pageIdx = tty_atlas_cache_get_shelf_page(cache, shelfIdx);
+        TTY_Image* image   = &cache->pages[pageIdx].image;
+        
+        for (TTY_U32 y = shelf->y; y < shelf->y + shelf->height; y++) {
+            memset(image->pixels + y * image->size.x, 0, shelf->nextX);
+        }
+        tty_atlas_cache_add_dirty_rect(cache, pageIdx, 0, shelf->y, shelf->nextX, shelf->height);
+    }
+
+    shelf->firstEntry = TTY_ATLAS_CACHE_NONE;
+    shelf->nextX      = 0;
+    TTY_ATOMIC_STORE_U8(&shelf->isReferenced, TTY_FALSE);
+}
+
+static void tty_atlas_cache_evict_page(TTY_Atlas_Cache* cache, TTY_U32 pageIdx) {
+    TTY_Atlas_Cache_Page* page       = cache->pages + pageIdx;
+    TTY_U32               firstShelf = tty_atlas_cache_get_first_shelf(cache, pageIdx);
+
+    for (TTY_U32 i = 0; i < page->numShelves; i++) {
+        tty_atlas_cache_evict_shelf(cache, firstShelf + i);
+    }
+    page->numShelves  = 0;
+    page->shelvesEndY = 0;
+}
+
+static TTY_U32 tty_atlas_cache_get_shelf_to_evict(TTY_Atlas_Cache* cache, TTY_U32 minHeight) {
+    // Uses the CLOCK algorithm over the shelves of every page: shelves that 
+    // have been used since the hand last passed them are skipped (and 
+    // unmarked)
+    
+    TTY_U32 numShelves = tty_atlas_cache_get_first_shelf(cache, cache->numPages);
+
+    for (TTY_U32 i = 0; i < 2 * numShelves; i++) {
+        TTY_U32                shelfIdx = cache->clockHand % numShelves;
+        TTY_Atlas_Cache_Shelf* shelf    = cache->shelves + shelfIdx;
+        
+        cache->clockHand = shelfIdx + 1;
+        
+        if (!tty_atlas_cache_shelf_is_used(cache, shelfIdx) || shelf->firstEntry == TTY_ATLAS_CACHE_NONE || shelf->height < minHeight) {
+            continue;
+        }
+        if (TTY_ATOMIC_LOAD_U8(&shelf->isReferenced)) {
+            TTY_ATOMIC_STORE_U8(&shelf->isReferenced, TTY_FALSE);
+            continue;
+        }
+
+        return shelfIdx;
+    }
+
+    return TTY_ATLAS_CACHE_NONE;
+}
+
+static TTY_U32 tty_atlas_cache_get_page_to_evict(TTY_Atlas_Cache* cache) {
+    // Gets the page with the fewest recently used shelves
+    TTY_U32 bestPage  = 0;
+    TTY_U32 bestCount = 0xFFFFFFFF;
+
+    for (TTY_U32 i = 0; i < cache->numPages; i++) {
+        TTY_U32 firstShelf = tty_atlas_cache_get_first_shelf(cache, i);
+        TTY_U32 count      = 0;
+        
+        for (TTY_U32 j = 0; j < cache->pages[i].numShelves; j++) {
+            count += TTY_ATOMIC_LOAD_U8(&cache->shelves[firstShelf + j].isReferenced);
+        }
+
+        if (count < bestCount) {
+            bestPage  = i;
+            bestCount = count;
+        }
+    }
+
+    return bestPage;
+}
+
+static TTY_U32 tty_atlas_cache_get_best_shelf(TTY_Atlas_Cache* cache, TTY_U32_V2 size) {
+    // Gets the shortest shelf (of any page) that has room for a glyph of the
+    // given (padded) size
+    TTY_U32 bestShelf = TTY_ATLAS_CACHE_NONE;
+    
+    for (TTY_U32 i = 0; i < cache->numPages; i++) {
+        TTY_U32 firstShelf = tty_atlas_cache_get_first_shelf(cache, i);
+        
+        for (TTY_U32 j = firstShelf; j < firstShelf + cache->pages[i].numShelves; j++) {
+            TTY_Atlas_Cache_Shelf* shelf = cache->shelves + j;
+            if (shelf->height >= size.y && shelf->nextX + size.x <= cache->pageSize.x &&
+                (bestShelf == TTY_ATLAS_CACHE_NONE || shelf->height < cache->shelves[bestShelf].height))
+            {
+                bestShelf = j;
+            }
+        }
+    }
+
+    return bestShelf;
+}
+
+static TTY_Bool tty_atlas_cache_can_add_shelf(TTY_Atlas_Cache* cache, TTY_U32 pageIdx, TTY_U32 height) {
+    TTY_Atlas_Cache_Page* page = cache->pages + pageIdx;
+    return page->numShelves < cache->shelvesPerPage && page->shelvesEndY + height <= cache->pageSize.y;
+}
+
+static TTY_U32 tty_atlas_cache_add_shelf(TTY_Atlas_Cache* cache, TTY_U32 pageIdx, TTY_U32 height) {
+    TTY_Atlas_Cache_Page* page = cache->pages + pageIdx;
+    
+    // Shelf heights are rounded up so that shelves can be reused by glyphs of
+    // similar heights once they are evicted
+    height = tty_pad_to_align(height, TTY_ATLAS_CACHE_SHELF_ALIGN);
+    height = TTY_MIN(height, cache->pageSize.y - page->shelvesEndY);
+
+    TTY_ASSERT(page->numShelves < cache->shelvesPerPage);
+    TTY_U32                shelfIdx = tty_atlas_cache_get_first_shelf(cache, pageIdx) + page->numShelves;
+    TTY_Atlas_Cache_Shelf* shelf    = cache->shelves + shelfIdx;
+    shelf->firstEntry = TTY_ATLAS_CACHE_NONE;
+    shelf->y          = page->shelvesEndY;
+    shelf->height     = height;
+    shelf->nextX      = 0;
+    TTY_ATOMIC_STORE_U8(&shelf->isReferenced, TTY_FALSE);
+
+    page->shelvesEndY += height;
+    page->numShelves++;
+    return shelfIdx;
+}
+
+static TTY_Error tty_atlas_cache_add_page(TTY_Atlas_Cache* cache) {
+    TTY_ASSERT(cache->numPages < cache->maxPages);
+    
+    TTY_Error error;
+    if ((error = tty_image_init(&cache->pages[cache->numPages].image, NULL, cache->pageSize.x, cache->pageSize.y))) {
+        return error;
+    }
+
+    cache->numPages++;
+    return TTY_ERROR_NONE;
+}
+
+static TTY_Error tty_atlas_cache_find_shelf(TTY_Atlas_Cache* cache, TTY_U32_V2 size, TTY_U32* shelf) {
+    // Note: size includes padding
+
+    *shelf = tty_atlas_cache_get_best_shelf(cache, size);
+
+    if (*shelf != TTY_ATLAS_CACHE_NONE && cache->shelves[*shelf].height - size.y <= size.y / 2) {
+        return TTY_ERROR_NONE;
+    }
+
+    // The glyph would waste too much space in the existing shelves, so start
+    // a new shelf if there is room for one
+    for (TTY_U32 i = 0; i < cache->numPages; i++) {
+        if (tty_atlas_cache_can_add_shelf(cache, i, size.y)) {
+            *shelf = tty_atlas_cache_add_shelf(cache, i, size.y);
+            return TTY_ERROR_NONE;
+        }
+    }
+
+    if (*shelf != TTY_ATLAS_CACHE_NONE) {
+        return TTY_ERROR_NONE;
+    }
+
+    // Every page is full
+    if (cache->numPages < cache->maxPages) {
+        TTY_Error error;
+        if ((error = tty_atlas_cache_add_page(cache))) {
+            return error;
+        }
+        *shelf = tty_atlas_cache_add_shelf(cache, cache->numPages - 1, size.y);
+        return TTY_ERROR_NONE;
+    }
+
+    *shelf = tty_atlas_cache_get_shelf_to_evict(cache, size.y);
+    if (*shelf != TTY_ATLAS_CACHE_NONE && *shelf != 0) {
+        tty_atlas_cache_evict_shelf(cache, *shelf);
+        return TTY_ERROR_NONE;
+    }
+
+    // None of the shelves are tall enough, so a whole page needs to be 
+    // repacked
+    TTY_U32 page = tty_atlas_cache_get_page_to_evict(cache);
+    tty_atlas_cache_evict_page(cache, page);
+    *shelf = tty_atlas_cache_add_shelf(cache, page, size.y);
+    return TTY_ERROR_NONE;
+}
+
+static TTY_Error tty_atlas_cache_reserve(TTY_Atlas_Cache* cache, TTY_U32 cp, TTY_U32_V2 size, TTY_U32* entry) {
+    // Adds an entry for the code point and reserves a `size` area of a page
+    // for it
+
+    TTY_U32_V2 paddedSize;
+    paddedSize.x = size.x + TTY_ATLAS_CACHE_PADDING;
+    paddedSize.y = size.y + TTY_ATLAS_CACHE_PADDING;
+
+    if (size.x > cache->pageSize.x || size.y > cache->pageSize.y) {
+        return TTY_ERROR_GLYPH_DOES_NOT_FIT_IN_IMAGE;
+    }
+
+    // Padding isn't needed on the right and bottom edges of a page
+    paddedSize.x = TTY_MIN(paddedSize.x, cache->pageSize.x);
+    paddedSize.y = TTY_MIN(paddedSize.y, cache->pageSize.y);
+
+    if (cache->freeEntries == TTY_ATLAS_CACHE_NONE) {
+        TTY_U32 shelf = tty_atlas_cache_get_shelf_to_evict(cache, 0);
+        TTY_ASSERT(shelf != TTY_ATLAS_CACHE_NONE);
+        tty_atlas_cache_evict_shelf(cache, shelf);
+    }
+
+    TTY_U32 shelfIdx = 0;
+    
+    if (size.x > 0 && size.y > 0) {
+        TTY_Error error;
+        if ((error = tty_atlas_cache_find_shelf(cache, paddedSize, &shelfIdx))) {
+            return error;
+        }
+    }
+    
+    TTY_Atlas_Cache_Shelf* shelf = cache->shelves + shelfIdx;
+
+    *entry             = cache->freeEntries;
+    cache->freeEntries = cache->nextEntries[*entry];
+    cache->numGlyphs++;
+
+    // Note: The fields that the concurrent cache's lookups read are stored 
+    //       atomically
+    cache->codePoints[*entry]  = cp;
+    cache->nextEntries[*entry] = shelf->firstEntry;
+    shelf->firstEntry          = *entry;
+    TTY_ATOMIC_STORE_RELAXED(&cache->entryShelves[*entry],     shelfIdx);
+    TTY_ATOMIC_STORE_RELAXED(&cache->atlasPositions[*entry].x, shelfIdx == 0 ? 0 : shelf->nextX);
+    TTY_ATOMIC_STORE_RELAXED(&cache->atlasPositions[*entry].y, shelf->y);
+    TTY_ATOMIC_STORE_U8(&shelf->isReferenced, TTY_TRUE);
+    tty_atlas_cache_add_to_table(cache, cp, *entry);
+
+    if (shelfIdx != 0) {
+        shelf->nextX = TTY_MIN(shelf->nextX + paddedSize.x, cache->pageSize.x);
+    }
+
+    return TTY_ERROR_NONE;
+}
+
+static void tty_atlas_cache_unreserve(TTY_Atlas_Cache* cache, TTY_U32 entry) {
+    // Note: The entry's space in the shelf isn't reclaimed until the shelf is 
+    //       evicted
+    TTY_U32* shelfEntry = &cache->shelves[cache->entryShelves[entry]].firstEntry;
+    while (*shelfEntry != entry) {
+        shelfEntry = cache->nextEntries + *shelfEntry;
+    }
+    *shelfEntry = cache->nextEntries[entry];
+
+    tty_atlas_cache_remove_from_table(cache, cache->codePoints[entry]);
+    cache->nextEntries[entry] = cache->freeEntries;
+    cache->freeEntries        = entry;
+    cache->numGlyphs--;
+}
+
+static TTY_U32 tty_atlas_cache_get_entry_page(TTY_Atlas_Cache* cache, TTY_U32 entry) {
+    TTY_U32 shelf = cache->entryShelves[entry];
+    return shelf == 0 ? 0 : tty_atlas_cache_get_shelf_page(cache, shelf);
+}
+
+TTY_Error tty_atlas_cache_get_entry(TTY_Font* font, TTY_Instance* instance, TTY_Atlas_Cache* cache, TTY_Atlas_Cache_Entry* entry, TTY_U32 codePoint) {
+    if (tty_atlas_cache_lookup(cache, entry, codePoint)) {
+        return TTY_ERROR_NONE;
+    }
+
+    // The glyph's size is needed before it is rendered so that space can be
+    // reserved for it
     {
         TTY_Error error;
 
         if ((error = tty_get_glyph_index(font, codePoint, &entry->glyph.idx)) ||
             (error = tty_glyph_init(font, &entry->glyph, entry->glyph.idx))   ||
-            (error = tty_render_glyph_impl(font, instance, &entry->glyph, &cache->atlas, entry->atlasPos.x, entry->atlasPos.y)))
+            (error = tty_get_glyph_metrics(font, instance, &entry->glyph)))
         {
             return error;
         }
     }
 
-    cache->lruHead->entry = *entry; // The new node is the head of the LRU list
+    TTY_U32 idx;
+    {
+        TTY_U32_V2 size;
+        size.x = entry->glyph.size.x;
+        size.y = entry->glyph.size.y;
+
+        TTY_Error error;
+        if ((error = tty_atlas_cache_reserve(cache, codePoint, size, &idx))) {
+            return error;
+        }
+    }
+
+    entry->atlasPos = cache->atlasPositions[idx];
+    entry->page     = tty_atlas_cache_get_entry_page(cache, idx);
+
+    if (entry->glyph.size.x > 0 && entry->glyph.size.y > 0) {
+        TTY_Error error;
+        if ((error = tty_render_glyph_impl(font, instance, &entry->glyph, &cache->pages[entry->page].image, entry->atlasPos.x, entry->atlasPos.y))) {
+            tty_atlas_cache_unreserve(cache, idx);
+            return error;
+        }
+        tty_atlas_cache_add_dirty_rect(cache, entry->page, entry->atlasPos.x, entry->atlasPos.y, entry->glyph.size.x, entry->glyph.size.y);
+    }
+
+    cache->glyphs[idx] = entry->glyph;
+    return TTY_ERROR_NONE;
+}
+
+TTY_Bool tty_atlas_cache_lookup(TTY_Atlas_Cache* cache, TTY_Atlas_Cache_Entry* entry, TTY_U32 codePoint) {
+    TTY_U32 idx = tty_atlas_cache_get(cache, codePoint);
+    if (idx == TTY_ATLAS_CACHE_NONE) {
+        return TTY_FALSE;
+    }
+    entry->glyph    = cache->glyphs[idx];
+    entry->atlasPos = cache->atlasPositions[idx];
+    entry->page     = tty_atlas_cache_get_entry_page(cache, idx);
+    return TTY_TRUE;
+}
+
+TTY_Error tty_atlas_cache_reserve_entry(TTY_Atlas_Cache* cache, TTY_Atlas_Cache_Entry* entry, TTY_U32 codePoint, TTY_U32_V2 size) {
+    TTY_ASSERT(tty_atlas_cache_get_no_update(cache, codePoint) == TTY_ATLAS_CACHE_NONE);
+
+    TTY_U32 idx;
+    {
+        TTY_Error error;
+        if ((error = tty_atlas_cache_reserve(cache, codePoint, size, &idx))) {
+            return error;
+        }
+    }
+
+    entry->atlasPos = cache->atlasPositions[idx];
+    entry->page     = tty_atlas_cache_get_entry_page(cache, idx);
+    tty_atomic_store_words(cache->glyphs + idx, &entry->glyph, sizeof(TTY_Glyph));
+
+    if (size.x > 0 && size.y > 0) {
+        // The caller fills in the area after this returns
+        tty_atlas_cache_add_dirty_rect(cache, entry->page, entry->atlasPos.x, entry->atlasPos.y, size.x, size.y);
+    }
+
     return TTY_ERROR_NONE;
 }
 
 TTY_Bool tty_atlas_cache_contains(TTY_Atlas_Cache* cache, TTY_U32 codePoint) {
-    return tty_atlas_cache_get_no_update(cache, codePoint) != NULL;
+    return tty_atlas_cache_get_no_update(cache, codePoint) != TTY_ATLAS_CACHE_NONE;
 }
 
 TTY_Bool tty_atlas_cache_is_full(TTY_Atlas_Cache* cache) {
-    return cache->numGlyphs == cache->maxGlyphs;
+    if (cache->freeEntries == TTY_ATLAS_CACHE_NONE) {
+        return TTY_TRUE;
+    }
+    if (cache->numPages < cache->maxPages) {
+        return TTY_FALSE;
+    }
+
+    TTY_U32_V2 paddedSize;
+    paddedSize.x = cache->maxGlyphSize.x + TTY_ATLAS_CACHE_PADDING;
+    paddedSize.y = cache->maxGlyphSize.y + TTY_ATLAS_CACHE_PADDING;
+
+    for (TTY_U32 i = 0; i < cache->numPages; i++) {
+        if (tty_atlas_cache_can_add_shelf(cache, i, paddedSize.y)) {
+            return TTY_FALSE;
+        }
+    }
+
+    return tty_atlas_cache_get_best_shelf(cache, paddedSize) == TTY_ATLAS_CACHE_NONE;
+}
+
+TTY_U32 tty_atlas_cache_get_dirty_rects(TTY_Atlas_Cache* cache, TTY_U32 page, const TTY_Rect** rects) {
+    if (page >= cache->numPages) {
+        *rects = NULL;
+        return 0;
+    }
+    *rects = cache->pages[page].dirtyRects;
+    return cache->pages[page].numDirtyRects;
+}
+
+void tty_atlas_cache_clear_dirty_rects(TTY_Atlas_Cache* cache) {
+    for (TTY_U32 i = 0; i < cache->numPages; i++) {
+        cache->pages[i].numDirtyRects = 0;
+    }
+}
+
+
+/* ---------------- */
+/* Atlas Prefetcher */
+/* ---------------- */
+struct TTY_Prefetch_Sync {
+    TTY_Mutex    mutex;
+    TTY_Cond     workCond; /* Signalled when code points are queued or the workers should stop */
+    TTY_Cond     doneCond; /* Signalled when the queue is empty and no worker is busy */
+    TTY_Thread*  threads;
+};
+
+static TTY_Bool tty_prefetch_bit_is_set(TTY_U32* bits, TTY_U32 cp) {
+    return (bits[cp >> 5] >> (cp & 31)) & 1;
+}
+
+static void tty_prefetch_set_bit(TTY_U32* bits, TTY_U32 cp) {
+    bits[cp >> 5] |= 1u << (cp & 31);
+}
+
+static void tty_prefetch_clear_bit(TTY_U32* bits, TTY_U32 cp) {
+    bits[cp >> 5] &= ~(1u << (cp & 31));
+}
+
+static void tty_prefetch_render(TTY_Prefetch_Worker* worker, TTY_U32 cp, TTY_Prefetch_Result* result) {
+    memset(result, 0, sizeof(TTY_Prefetch_Result));
+    result->codePoint = cp;
+
+    if ((result->error = tty_get_glyph_index(&worker->font, cp, &result->glyph.idx))                     ||
+        (result->error = tty_glyph_init(&worker->font, &result->glyph, result->glyph.idx))               ||
+        (result->error = tty_render_glyph(&worker->font, &worker->instance, &result->glyph, &result->image)))
+    {
+        // The image is freed by tty_render_glyph if it fails
+        result->image.pixels = NULL;
+    }
+}
+
+static TTY_Thread_Result TTY_THREAD_CALL tty_prefetch_worker_main(void* arg) {
+    TTY_Prefetch_Worker*      worker     = (TTY_Prefetch_Worker*)arg;
+    TTY_Atlas_Prefetcher*     prefetcher = worker->prefetcher;
+    struct TTY_Prefetch_Sync* sync       = prefetcher->sync;
+
+    tty_mutex_lock(&sync->mutex);
+
+    while (TTY_TRUE) {
+        while (prefetcher->queueCount == 0 && !prefetcher->isStopping) {
+            tty_cond_wait(&sync->workCond, &sync->mutex);
+        }
+        if (prefetcher->isStopping) {
+            break;
+        }
+
+        TTY_U32 cp = prefetcher->queue[prefetcher->queueHead];
+        prefetcher->queueHead = (prefetcher->queueHead + 1) % prefetcher->maxPending;
+        prefetcher->queueCount--;
+        prefetcher->numBusyWorkers++;
+
+        tty_mutex_unlock(&sync->mutex);
+
+        TTY_Prefetch_Result result;
+        tty_prefetch_render(worker, cp, &result);
+
+        tty_mutex_lock(&sync->mutex);
+
+        // Note: There is always room since the number of results can't exceed
+        //       the number of pending code points
+        prefetcher->results[prefetcher->numResults++] = result;
+        prefetcher->numBusyWorkers--;
+
+        if (prefetcher->queueCount == 0 && prefetcher->numBusyWorkers == 0) {
+            tty_cond_broadcast(&sync->doneCond);
+        }
+    }
+
+    tty_mutex_unlock(&sync->mutex);
+    return 0;
+}
+
+static void tty_atlas_prefetcher_stop(TTY_Atlas_Prefetcher* prefetcher, TTY_U32 numThreads) {
+    struct TTY_Prefetch_Sync* sync = prefetcher->sync;
+
+    tty_mutex_lock(&sync->mutex);
+    prefetcher->isStopping = TTY_TRUE;
+    tty_cond_broadcast(&sync->workCond);
+    tty_mutex_unlock(&sync->mutex);
+
+    for (TTY_U32 i = 0; i < numThreads; i++) {
+        tty_thread_join(sync->threads[i]);
+    }
+}
+
+static void tty_atlas_prefetcher_free_workers(TTY_Atlas_Prefetcher* prefetcher, TTY_U32 numWorkers) {
+    for (TTY_U32 i = 0; i < numWorkers; i++) {
+        tty_instance_free(&prefetcher->workers[i].instance);
+        tty_font_free(&prefetcher->workers[i].font);
+    }
+}
+
+TTY_Error tty_atlas_prefetcher_init(TTY_Font* font, TTY_Instance* instance, TTY_Atlas_Cache* cache, TTY_Atlas_Prefetcher* prefetcher, TTY_U32 numWorkers) {
+    numWorkers = TTY_MAX(numWorkers, 1);
+
+    TTY_U32 maxPending = cache->maxGlyphs;
+    TTY_U32 numWords   = TTY_PREFETCH_NUM_CODE_POINTS / 32;
+
+    size_t off             =   0;
+    size_t totalSize       =   0;
+    size_t syncSize        =   tty_calc_mem_size(&totalSize, sizeof(struct TTY_Prefetch_Sync)             , _Alignof(TTY_Thread));
+    size_t threadsSize     =   tty_calc_mem_size(&totalSize, numWorkers * sizeof(TTY_Thread)              , _Alignof(TTY_Prefetch_Worker));
+    size_t workersSize     =   tty_calc_mem_size(&totalSize, numWorkers * sizeof(TTY_Prefetch_Worker)     , _Alignof(TTY_Prefetch_Result));
+    size_t resultsSize     =   tty_calc_mem_size(&totalSize, maxPending * sizeof(TTY_Prefetch_Result)     , _Alignof(TTY_Prefetch_Result));
+    size_t publishBuffSize =   tty_calc_mem_size(&totalSize, maxPending * sizeof(TTY_Prefetch_Result)     , _Alignof(TTY_U32));
+    size_t queueSize       =   tty_calc_mem_size(&totalSize, maxPending * sizeof(TTY_U32)                 , _Alignof(TTY_U32));
+    size_t pendingBitsSize =   tty_calc_mem_size(&totalSize, numWords   * sizeof(TTY_U32)                 , _Alignof(TTY_U32));
+    /*size_t failedBitsSize=*/ tty_calc_mem_size(&totalSize, numWords   * sizeof(TTY_U32)                 , 1);
+
+    memset(prefetcher, 0, sizeof(TTY_Atlas_Prefetcher));
+
+    prefetcher->mem = (TTY_U8*)calloc(totalSize, 1);
+    if (prefetcher->mem == NULL) {
+        return TTY_ERROR_OUT_OF_MEMORY;
+    }
+
+    prefetcher->sync          = (struct TTY_Prefetch_Sync*)(prefetcher->mem);
+    prefetcher->sync->threads = (TTY_Thread*)              (prefetcher->mem + (off += syncSize));
+    prefetcher->workers       = (TTY_Prefetch_Worker*)     (prefetcher->mem + (off += threadsSize));
+    prefetcher->results       = (TTY_Prefetch_Result*)     (prefetcher->mem + (off += workersSize));
+    prefetcher->publishBuff   = (TTY_Prefetch_Result*)     (prefetcher->mem + (off += resultsSize));
+    prefetcher->queue         = (TTY_U32*)                 (prefetcher->mem + (off += publishBuffSize));
+    prefetcher->pendingBits   = (TTY_U32*)                 (prefetcher->mem + (off += queueSize));
+    prefetcher->failedBits    = (TTY_U32*)                 (prefetcher->mem + (off += pendingBitsSize));
+    prefetcher->font          = font;
+    prefetcher->instance      = instance;
+    prefetcher->cache         = cache;
+    prefetcher->maxPending    = maxPending;
+    prefetcher->numWorkers    = numWorkers;
+
+    {
+        TTY_U32 flags = 0;
+        if (!instance->useHinting) {
+            flags |= TTY_INSTANCE_NO_HINTING;
+        }
+        if (instance->useBinaryRendering) {
+            flags |= TTY_INSTANCE_BINARY;
+        }
+
+        for (TTY_U32 i = 0; i < numWorkers; i++) {
+            TTY_Prefetch_Worker* worker = prefetcher->workers + i;
+            worker->prefetcher = prefetcher;
+
+            TTY_Error error;
+            if ((error = tty_font_init_from_memory(&worker->font, font->fileData, font->fileSize))) {
+                tty_atlas_prefetcher_free_workers(prefetcher, i);
+                free(prefetcher->mem);
+                return error;
+            }
+            if ((error = tty_instance_init(&worker->font, &worker->instance, instance->ppem, flags))) {
+                tty_font_free(&worker->font);
+                tty_atlas_prefetcher_free_workers(prefetcher, i);
+                free(prefetcher->mem);
+                return error;
+            }
+        }
+    }
+
+    {
+        struct TTY_Prefetch_Sync* sync = prefetcher->sync;
+
+        TTY_Bool hasMutex    = tty_mutex_init(&sync->mutex);
+        TTY_Bool hasWorkCond = hasMutex    && tty_cond_init(&sync->workCond);
+        TTY_Bool hasDoneCond = hasWorkCond && tty_cond_init(&sync->doneCond);
+        if (!hasDoneCond) {
+            if (hasWorkCond) {
+                tty_cond_free(&sync->workCond);
+            }
+            if (hasMutex) {
+                tty_mutex_free(&sync->mutex);
+            }
+            tty_atlas_prefetcher_free_workers(prefetcher, numWorkers);
+            free(prefetcher->mem);
+            return TTY_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    for (TTY_U32 i = 0; i < numWorkers; i++) {
+        if (!tty_thread_create(prefetcher->sync->threads + i, tty_prefetch_worker_main, prefetcher->workers + i)) {
+            tty_atlas_prefetcher_stop(prefetcher, i);
+            tty_cond_free(&prefetcher->sync->doneCond);
+            tty_cond_free(&prefetcher->sync->workCond);
+            tty_mutex_free(&prefetcher->sync->mutex);
+            tty_atlas_prefetcher_free_workers(prefetcher, numWorkers);
+            free(prefetcher->mem);
+            return TTY_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    return TTY_ERROR_NONE;
+}
+
+void tty_atlas_prefetcher_free(TTY_Atlas_Prefetcher* prefetcher) {
+    if (prefetcher == NULL || prefetcher->mem == NULL) {
+        return;
+    }
+
+    tty_atlas_prefetcher_stop(prefetcher, prefetcher->numWorkers);
+
+    // Glyphs that were rendered but never added to the cache
+    for (TTY_U32 i = 0; i < prefetcher->numResults; i++) {
+        free(prefetcher->results[i].image.pixels);
+    }
+
+    tty_cond_free(&prefetcher->sync->doneCond);
+    tty_cond_free(&prefetcher->sync->workCond);
+    tty_mutex_free(&prefetcher->sync->mutex);
+    tty_atlas_prefetcher_free_workers(prefetcher, prefetcher->numWorkers);
+    free(prefetcher->mem);
+    prefetcher->mem = NULL;
+}
+
+static void tty_atlas_prefetcher_publish(TTY_Atlas_Prefetcher* prefetcher) {
+    // Moves the glyphs that the workers have rendered into the cache
+
+    TTY_U32 numResults;
+    {
+        struct TTY_Prefetch_Sync* sync = prefetcher->sync;
+        tty_mutex_lock(&sync->mutex);
+        numResults = prefetcher->numResults;
+        memcpy(prefetcher->publishBuff, prefetcher->results, numResults * sizeof(TTY_Prefetch_Result));
+        prefetcher->numResults = 0;
+        tty_mutex_unlock(&sync->mutex);
+    }
+
+    for (TTY_U32 i = 0; i < numResults; i++) {
+        TTY_Prefetch_Result* result = prefetcher->publishBuff + i;
+
+        tty_prefetch_clear_bit(prefetcher->pendingBits, result->codePoint);
+        prefetcher->numPending--;
+
+        // Note: The code point may have been added with tty_atlas_cache_get_entry
+        //       while it was being rendered
+        if (result->error == TTY_ERROR_NONE && !tty_atlas_cache_contains(prefetcher->cache, result->codePoint)) {
+            TTY_Atlas_Cache_Entry entry;
+            entry.glyph = result->glyph;
+
+            TTY_U32_V2 size;
+            size.x = result->glyph.size.x;
+            size.y = result->glyph.size.y;
+
+            result->error = tty_atlas_cache_reserve_entry(prefetcher->cache, &entry, result->codePoint, size);
+
+            if (result->error == TTY_ERROR_NONE && result->image.pixels != NULL) {
+                TTY_Image* page = &prefetcher->cache->pages[entry.page].image;
+                for (TTY_U32 y = 0; y < size.y; y++) {
+                    TTY_U8* dst = page->pixels + entry.atlasPos.x + (entry.atlasPos.y + y) * page->size.x;
+                    TTY_U8* src = result->image.pixels + y * result->image.size.x;
+                    memcpy(dst, src, size.x);
+                }
+            }
+        }
+
+        if (result->error != TTY_ERROR_NONE) {
+            tty_prefetch_set_bit(prefetcher->failedBits, result->codePoint);
+        }
+
+        free(result->image.pixels);
+    }
+}
+
+static TTY_U32 tty_atlas_prefetcher_queue(TTY_Atlas_Prefetcher* prefetcher, const TTY_U32* codePoints, TTY_U32 numCodePoints) {
+    struct TTY_Prefetch_Sync* sync = prefetcher->sync;
+
+    TTY_U32 numQueued = 0;
+
+    tty_mutex_lock(&sync->mutex);
+
+    for (TTY_U32 i = 0; i < numCodePoints && prefetcher->numPending < prefetcher->maxPending; i++) {
+        TTY_U32 cp = codePoints[i];
+
+        if (cp >= TTY_PREFETCH_NUM_CODE_POINTS                   ||
+            tty_prefetch_bit_is_set(prefetcher->pendingBits, cp) ||
+            tty_prefetch_bit_is_set(prefetcher->failedBits, cp)  ||
+            tty_atlas_cache_contains(prefetcher->cache, cp))
+        {
+            continue;
+        }
+
+        TTY_U32 tail = (prefetcher->queueHead + prefetcher->queueCount) % prefetcher->maxPending;
+        prefetcher->queue[tail] = cp;
+        prefetcher->queueCount++;
+        prefetcher->numPending++;
+        tty_prefetch_set_bit(prefetcher->pendingBits, cp);
+        numQueued++;
+    }
+
+    if (numQueued == 1) {
+        tty_cond_signal(&sync->workCond);
+    }
+    else if (numQueued > 1) {
+        tty_cond_broadcast(&sync->workCond);
+    }
+
+    tty_mutex_unlock(&sync->mutex);
+
+    return numQueued;
+}
+
+TTY_U32 tty_atlas_prefetch(TTY_Atlas_Prefetcher* prefetcher, const TTY_U32* codePoints, TTY_U32 numCodePoints) {
+    // Publishing first frees up room in the queue
+    tty_atlas_prefetcher_publish(prefetcher);
+    return tty_atlas_prefetcher_queue(prefetcher, codePoints, numCodePoints);
+}
+
+TTY_Error tty_atlas_prefetcher_try_get_entry(TTY_Atlas_Prefetcher* prefetcher, TTY_Atlas_Cache_Entry* entry, TTY_U32 codePoint) {
+    tty_atlas_prefetcher_publish(prefetcher);
+
+    if (tty_atlas_cache_lookup(prefetcher->cache, entry, codePoint)) {
+        return TTY_ERROR_NONE;
+    }
+
+    if (codePoint >= TTY_PREFETCH_NUM_CODE_POINTS || tty_prefetch_bit_is_set(prefetcher->failedBits, codePoint)) {
+        // Render the glyph on this thread so that the reason it failed can be
+        // returned
+        TTY_Error error = tty_atlas_cache_get_entry(prefetcher->font, prefetcher->instance, prefetcher->cache, entry, codePoint);
+        if (error == TTY_ERROR_NONE && codePoint < TTY_PREFETCH_NUM_CODE_POINTS) {
+            tty_prefetch_clear_bit(prefetcher->failedBits, codePoint);
+        }
+        return error;
+    }
+
+    // Note: Only this thread sets and clears the pending bits, so the bit can
+    //       be read without the lock
+    if (tty_atlas_prefetcher_queue(prefetcher, &codePoint, 1) == 0 && !tty_prefetch_bit_is_set(prefetcher->pendingBits, codePoint)) {
+        // The queue is full, so the glyph is rendered on this thread instead
+        // of being dropped
+        return tty_atlas_cache_get_entry(prefetcher->font, prefetcher->instance, prefetcher->cache, entry, codePoint);
+    }
+    return TTY_ERROR_GLYPH_PENDING;
+}
+
+void tty_atlas_prefetcher_wait(TTY_Atlas_Prefetcher* prefetcher) {
+    struct TTY_Prefetch_Sync* sync = prefetcher->sync;
+
+    tty_mutex_lock(&sync->mutex);
+    while (prefetcher->queueCount > 0 || prefetcher->numBusyWorkers > 0) {
+        tty_cond_wait(&sync->doneCond, &sync->mutex);
+    }
+    tty_mutex_unlock(&sync->mutex);
+
+    tty_atlas_prefetcher_publish(prefetcher);
+}
+
+
+/* ---------------------- */
+/* Concurrent Atlas Cache */
+/* ---------------------- */
+struct TTY_Atlas_Shard_Sync {
+    _Alignas(TTY_CACHE_LINE_SIZE) 
+    TTY_Mutex  mutex; /* Held by threads that add glyphs to the shard or take its dirty rects */
+    TTY_U32    seq;   /* Odd while the shard is being modified */
+};
+
+TTY_Error tty_concurrent_atlas_cache_init(TTY_Instance* instance, TTY_Concurrent_Atlas_Cache* cache, TTY_U32 w, TTY_U32 h, TTY_U32 numShards, TTY_U32 pagesPerShard) {
+    TTY_U32 numShardsPow2 = 1;
+    while (numShardsPow2 < numShards) {
+        numShardsPow2 <<= 1;
+    }
+
+    size_t off          =   0;
+    size_t totalSize    =   0;
+    size_t shardsSize   =   tty_calc_mem_size(&totalSize, numShardsPow2 * sizeof(TTY_Atlas_Cache)             , _Alignof(struct TTY_Atlas_Shard_Sync));
+    /*size_t syncsSize  =*/ tty_calc_mem_size(&totalSize, numShardsPow2 * sizeof(struct TTY_Atlas_Shard_Sync) , 1);
+
+    memset(cache, 0, sizeof(TTY_Concurrent_Atlas_Cache));
+
+    // Note: calloc doesn't guarantee cache line alignment, so the syncs are 
+    //       offset by up to a cache line
+    cache->mem = (TTY_U8*)calloc(totalSize + TTY_CACHE_LINE_SIZE, 1);
+    if (cache->mem == NULL) {
+        return TTY_ERROR_OUT_OF_MEMORY;
+    }
+
+    {
+        TTY_U8* aligned = cache->mem + tty_pad_to_align((size_t)cache->mem, TTY_CACHE_LINE_SIZE) - (size_t)cache->mem;
+        cache->shards = (TTY_Atlas_Cache*)            (aligned);
+        cache->syncs  = (struct TTY_Atlas_Shard_Sync*)(aligned + (off += shardsSize));
+    }
+    cache->numShards     = numShardsPow2;
+    cache->pagesPerShard = pagesPerShard;
+
+    for (TTY_U32 i = 0; i < numShardsPow2; i++) {
+        TTY_Error error;
+        if ((error = tty_atlas_cache_init_paged(instance, cache->shards + i, w, h, pagesPerShard))) {
+            cache->numShards = i;
+            tty_concurrent_atlas_cache_free(cache);
+            return error;
+        }
+        if (!tty_mutex_init(&cache->syncs[i].mutex)) {
+            // Shard i has no mutex yet, the ones before it are destroyed
+            tty_atlas_cache_free(cache->shards + i);
+            cache->numShards = i;
+            tty_concurrent_atlas_cache_free(cache);
+            return TTY_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    return TTY_ERROR_NONE;
+}
+
+void tty_concurrent_atlas_cache_free(TTY_Concurrent_Atlas_Cache* cache) {
+    if (cache != NULL && cache->mem != NULL) {
+        for (TTY_U32 i = 0; i < cache->numShards; i++) {
+            tty_atlas_cache_free(cache->shards + i);
+            tty_mutex_free(&cache->syncs[i].mutex);
+        }
+        free(cache->mem);
+        cache->mem = NULL;
+    }
+}
+
+static TTY_U32 tty_concurrent_atlas_cache_get_shard(TTY_Concurrent_Atlas_Cache* cache, TTY_U32 cp) {
+    // Shards are selected using the top bits of the hash since the shards' 
+    // tables use the bottom bits
+    return (TTY_U32)(((TTY_U64)tty_atlas_cache_hash(cp) * cache->numShards) >> 32);
+}
+
+static TTY_Bool tty_concurrent_atlas_cache_lookup(TTY_Concurrent_Atlas_Cache* cache, TTY_U32 shardIdx, TTY_Atlas_Cache_Entry* entry, TTY_U32 cp) {
+    TTY_Atlas_Cache*             shard = cache->shards + shardIdx;
+    struct TTY_Atlas_Shard_Sync* sync  = cache->syncs  + shardIdx;
+
+    while (TTY_TRUE) {
+        TTY_U32 seq = TTY_ATOMIC_LOAD_ACQUIRE(&sync->seq);
+        if (seq & 1) {
+            // A glyph is being added, this only takes as long as evicting a
+            // shelf and copying the glyph's pixels
+            TTY_THREAD_YIELD();
+            continue;
+        }
+
+        // Note: The shard's table always has empty slots, so the lookup ends 
+        //       even if a writer changes the table while it is being read
+        TTY_U32 idx   = tty_atlas_cache_get_no_update(shard, cp);
+        TTY_U32 shelf = 0;
+        if (idx != TTY_ATLAS_CACHE_NONE) {
+            tty_atomic_load_words(&entry->glyph, shard->glyphs + idx, sizeof(TTY_Glyph));
+            entry->atlasPos.x = TTY_ATOMIC_LOAD_RELAXED(&shard->atlasPositions[idx].x);
+            entry->atlasPos.y = TTY_ATOMIC_LOAD_RELAXED(&shard->atlasPositions[idx].y);
+            shelf             = TTY_ATOMIC_LOAD_RELAXED(&shard->entryShelves[idx]);
+        }
+
+        TTY_ATOMIC_FENCE_ACQUIRE();
+        if (TTY_ATOMIC_LOAD_RELAXED(&sync->seq) != seq) {
+            continue;
+        }
+
+        if (idx == TTY_ATLAS_CACHE_NONE) {
+            return TTY_FALSE;
+        }
+
+        entry->page = shardIdx * cache->pagesPerShard + (shelf == 0 ? 0 : tty_atlas_cache_get_shelf_page(shard, shelf));
+
+        // Give the shelf a second chance. The bit is only written if it isn't
+        // already set so that hits don't make threads fight over the cache line.
+        if (!TTY_ATOMIC_LOAD_U8(&shard->shelves[shelf].isReferenced)) {
+            TTY_ATOMIC_STORE_U8(&shard->shelves[shelf].isReferenced, TTY_TRUE);
+        }
+        return TTY_TRUE;
+    }
+}
+
+TTY_Error tty_concurrent_atlas_cache_get_entry(TTY_Font* font, TTY_Instance* instance, TTY_Concurrent_Atlas_Cache* cache, TTY_Atlas_Cache_Entry* entry, TTY_U32 codePoint) {
+    TTY_U32 shardIdx = tty_concurrent_atlas_cache_get_shard(cache, codePoint);
+
+    if (tty_concurrent_atlas_cache_lookup(cache, shardIdx, entry, codePoint)) {
+        return TTY_ERROR_NONE;
+    }
+
+    TTY_Atlas_Cache*             shard = cache->shards + shardIdx;
+    struct TTY_Atlas_Shard_Sync* sync  = cache->syncs  + shardIdx;
+
+    tty_mutex_lock(&sync->mutex);
+
+    // Another thread may have added the glyph while this one was waiting
+    if (tty_concurrent_atlas_cache_lookup(cache, shardIdx, entry, codePoint)) {
+        tty_mutex_unlock(&sync->mutex);
+        return TTY_ERROR_NONE;
+    }
+
+    // The glyph is rendered before the shard is modified so that lookups 
+    // don't have to wait for it
+    TTY_Image image = {0};
+    {
+        memset(&entry->glyph, 0, sizeof(TTY_Glyph));
+
+        TTY_Error error;
+        if ((error = tty_get_glyph_index(font, codePoint, &entry->glyph.idx))          ||
+            (error = tty_glyph_init(font, &entry->glyph, entry->glyph.idx))            ||
+            (error = tty_render_glyph(font, instance, &entry->glyph, &image)))
+        {
+            tty_mutex_unlock(&sync->mutex);
+            return error;
+        }
+    }
+
+    TTY_ATOMIC_STORE_RELAXED(&sync->seq, sync->seq + 1);
+    TTY_ATOMIC_FENCE_RELEASE();
+
+    TTY_Error error;
+    {
+        TTY_U32_V2 size;
+        size.x = entry->glyph.size.x;
+        size.y = entry->glyph.size.y;
+
+        error = tty_atlas_cache_reserve_entry(shard, entry, codePoint, size);
+
+        if (error == TTY_ERROR_NONE && image.pixels != NULL) {
+            TTY_Image* page = &shard->pages[entry->page].image;
+            for (TTY_U32 y = 0; y < size.y; y++) {
+                TTY_U8* dst = page->pixels + entry->atlasPos.x + (entry->atlasPos.y + y) * page->size.x;
+                TTY_U8* src = image.pixels + y * image.size.x;
+                memcpy(dst, src, size.x);
+            }
+        }
+    }
+
+    TTY_ATOMIC_STORE_RELEASE(&sync->seq, sync->seq + 1);
+
+    tty_mutex_unlock(&sync->mutex);
+
+    free(image.pixels);
+    entry->page += shardIdx * cache->pagesPerShard;
+    return error;
+}
+
+TTY_U32 tty_concurrent_atlas_cache_take_dirty_rects(TTY_Concurrent_Atlas_Cache* cache, TTY_U32 page, TTY_Rect* rects, TTY_U32 maxRects) {
+    TTY_U32 shardIdx = page / cache->pagesPerShard;
+    TTY_U32 pageIdx  = page % cache->pagesPerShard;
+
+    if (shardIdx >= cache->numShards) {
+        return 0;
+    }
+
+    TTY_Atlas_Cache*             shard = cache->shards + shardIdx;
+    struct TTY_Atlas_Shard_Sync* sync  = cache->syncs  + shardIdx;
+
+    TTY_U32 numRects = 0;
+
+    tty_mutex_lock(&sync->mutex);
+
+    if (pageIdx < shard->numPages) {
+        TTY_Atlas_Cache_Page* shardPage = shard->pages + pageIdx;
+
+        numRects = TTY_MIN(shardPage->numDirtyRects, maxRects);
+        memcpy(rects, shardPage->dirtyRects, numRects * sizeof(TTY_Rect));
+
+        shardPage->numDirtyRects -= numRects;
+        memmove(shardPage->dirtyRects, shardPage->dirtyRects + numRects, shardPage->numDirtyRects * sizeof(TTY_Rect));
+    }
+
+    tty_mutex_unlock(&sync->mutex);
+
+    return numRects;
 }
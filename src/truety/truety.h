@@ -9,6 +9,8 @@
 
 struct TTY_Program_Context;
 struct TTY_Zone;
+struct TTY_Outline;
+struct TTY_Component_Offset;
 
 typedef uint8_t  TTY_Bool;
 typedef uint8_t  TTY_U8;
@@ -39,12 +41,14 @@ typedef enum {
     TTY_ERROR_OUT_OF_MEMORY              ,
     TTY_ERROR_UNKNOWN_INSTRUCTION        , /* TODO: This will be deprecated once all instructions are implemented */
     TTY_ERROR_GLYPH_DOES_NOT_FIT_IN_IMAGE,
+    TTY_ERROR_GLYPH_PENDING              , /* The glyph is being rendered by a prefetch worker */
 } TTY_Error;
 
 typedef enum {
     TTY_INSTANCE_DEFAULT                = 0,
     TTY_INSTANCE_NO_HINTING             = 1,
     TTY_INSTANCE_SUBPIXEL_RENDERING_RGB = 2, /* TODO: implement subpixel rendering */
+    TTY_INSTANCE_BINARY                 = 4, /* Pixels are either 0 or 255, sampled once at the pixel center */
 } TTY_Instance_Flag;
 
 typedef struct {
@@ -162,10 +166,31 @@ typedef struct {
     TTY_U16   format;
 } TTY_Encoding;
 
+/* A decoded copy of the font's character to glyph mapping */
+typedef struct {
+    TTY_U16*   bmp;   /* The glyph indices of U+0000 to U+FFFF                                     */
+    TTY_U16**  pages; /* Pages of 256 glyph indices covering U+10000 to U+10FFFF, NULL if unmapped */
+} TTY_Glyph_Index_Map;
+
+/* Decoded, unscaled glyph outlines that are reused by every instance of a 
+   font. Composite glyphs are stored with their components already merged. */
+typedef struct {
+    struct TTY_Outline**           outlines;   /* Indexed by glyph index, NULL if the glyph's outline isn't cached */
+    struct TTY_Outline*            lruHead;
+    struct TTY_Outline*            lruTail;
+    struct TTY_Component_Offset*   offsetBuff; /* Used when decoding composite glyphs */
+    TTY_U32                        offsetCap;
+    TTY_U32                        size;       /* The number of bytes used by the cached outlines */
+    TTY_U32                        maxSize;
+} TTY_Outline_Cache;
+
 typedef struct {
     TTY_Font_Hinting_Data  hint;
+    TTY_Glyph_Index_Map    glyphIndexMap; /* Only used after tty_font_init_glyph_index_map is called */
+    TTY_Outline_Cache      outlineCache;  /* Only used after tty_font_init_outline_cache is called  */
     TTY_U8*                fileData;
     TTY_S32                fileSize;
+    TTY_U8                 fileDataSource; /* Whether fileData was allocated, mapped, or provided by the user */
     TTY_Table              cmap;
     TTY_Table              cvt;
     TTY_Table              fpgm;
@@ -186,6 +211,8 @@ typedef struct {
     TTY_S16                descender;
     TTY_S16                lineGap;
     TTY_S16                maxHoriExtent;
+    TTY_S16                indexToLocFormat; /* 0 for short loca offsets, 1 for long offsets */
+    TTY_U16                numHMetrics;
     TTY_Bool               hasHinting;
 } TTY_Font;
 
@@ -208,11 +235,13 @@ typedef struct {
     TTY_F10Dot22               scale;
     TTY_Bool                   useHinting;
     TTY_Bool                   useSubpixelRendering; /* TODO: Implement subpixel rendering */
+    TTY_Bool                   useBinaryRendering;
     TTY_Bool                   isRotated;            /* TODO: Implement rotation */
     TTY_Bool                   isStretched;          /* TODO: Implement stretching */
 } TTY_Instance;
 
-/* advance, offset, and size are not calculated until the glyph is rendered */
+/* advance, offset, and size are not calculated until the glyph is rendered or
+   `tty_get_glyph_metrics` is called */
 typedef struct {
     TTY_U8*  glyfBlock;
     TTY_U32  idx;
@@ -227,32 +256,116 @@ typedef struct {
     TTY_U32_V2  size;
 } TTY_Image;
 
+typedef struct {
+    TTY_U32_V2  pos;
+    TTY_U32_V2  size;
+} TTY_Rect;
+
 typedef struct {
     TTY_Glyph   glyph;
     TTY_U32_V2  atlasPos;
+    TTY_U32     page;
 } TTY_Atlas_Cache_Entry;
 
-typedef struct TTY_Atlas_Cache_Node {
-    TTY_U32                       codePoint;
-    TTY_Atlas_Cache_Entry         entry;
-    struct TTY_Atlas_Cache_Node*  lruPrev;
-    struct TTY_Atlas_Cache_Node*  lruNext;
-    struct TTY_Atlas_Cache_Node*  next;
-} TTY_Atlas_Cache_Node;
+typedef struct {
+    TTY_U32  codePoint;
+    TTY_U32  entry;
+} TTY_Atlas_Cache_Slot;
 
+/* A row of a page that glyphs are packed into from left to right */
 typedef struct {
-    TTY_U8*                mem;
-    TTY_Atlas_Cache_Node*  nodes;
-    TTY_Atlas_Cache_Node** chainHeads;
-    TTY_Atlas_Cache_Node*  lruHead;
-    TTY_Atlas_Cache_Node*  lruTail;
-    TTY_Image              atlas;
-    TTY_U32_V2             slotSize;
-    TTY_U32_V2             nextAtlasPos;
-    TTY_U32                numGlyphs;
-    TTY_U32                maxGlyphs;
+    TTY_U32   firstEntry;
+    TTY_U32   y;
+    TTY_U32   height;
+    TTY_U32   nextX;
+    TTY_Bool  isReferenced; /* Set when one of the shelf's glyphs is used, cleared by the eviction clock */
+} TTY_Atlas_Cache_Shelf;
+
+typedef struct {
+    TTY_Image  image;         /* pixels is NULL until the page is used */
+    TTY_Rect*  dirtyRects;    /* Areas of the page that changed since the dirty rects were last cleared */
+    TTY_U32    numDirtyRects;
+    TTY_U32    numShelves;
+    TTY_U32    shelvesEndY;
+} TTY_Atlas_Cache_Page;
+
+/* Entries are stored as parallel arrays so that lookups only touch the data
+   they need */
+typedef struct {
+    TTY_U8*                 mem;
+    TTY_Atlas_Cache_Slot*   slots;          /* Open addressing hash table that maps code points to entries */
+    TTY_U32*                codePoints;     /* Indexed by entry */
+    TTY_U32_V2*             atlasPositions; /* Indexed by entry */
+    TTY_Glyph*              glyphs;         /* Indexed by entry */
+    TTY_U32*                entryShelves;   /* Indexed by entry */
+    TTY_U32*                nextEntries;    /* Indexed by entry, the next entry in the same shelf or in the free list */
+    TTY_Atlas_Cache_Shelf*  shelves;        /* shelves[0] holds glyphs that have no pixels, followed by shelvesPerPage shelves per page */
+    TTY_Atlas_Cache_Page*   pages;
+    TTY_U32_V2              pageSize;
+    TTY_U32_V2              maxGlyphSize;
+    TTY_U32                 slotMask;
+    TTY_U32                 freeEntries;
+    TTY_U32                 shelvesPerPage;
+    TTY_U32                 numPages;
+    TTY_U32                 maxPages;
+    TTY_U32                 numGlyphs;
+    TTY_U32                 maxGlyphs;
+    TTY_U32                 clockHand;
 } TTY_Atlas_Cache;
 
+/* A glyph that a prefetch worker rendered, but that hasn't been added to the
+   cache yet */
+typedef struct {
+    TTY_Glyph  glyph;
+    TTY_Image  image;     /* pixels is NULL if the glyph is empty or couldn't be rendered */
+    TTY_U32    codePoint;
+    TTY_Error  error;
+} TTY_Prefetch_Result;
+
+/* Each worker has its own font and instance since rendering modifies them. 
+   The font shares the file data of the prefetcher's font. */
+typedef struct {
+    TTY_Font                       font;
+    TTY_Instance                   instance;
+    struct TTY_Atlas_Prefetcher*   prefetcher;
+} TTY_Prefetch_Worker;
+
+/* Glyphs are rendered by the workers, but only the thread that owns the 
+   prefetcher adds them to the cache. Entries therefore appear in the cache 
+   fully rendered, and the cache itself doesn't need a lock. */
+typedef struct TTY_Atlas_Prefetcher {
+    TTY_U8*                    mem;
+    struct TTY_Prefetch_Sync*  sync;           /* Threads, the lock, and condition variables */
+    TTY_Font*                  font;
+    TTY_Instance*              instance;
+    TTY_Atlas_Cache*           cache;
+    TTY_Prefetch_Worker*       workers;
+    TTY_U32*                   queue;          /* Ring buffer of code points waiting for a worker */
+    TTY_Prefetch_Result*       results;        /* Filled in by the workers */
+    TTY_Prefetch_Result*       publishBuff;    /* Results are moved here so they can be added to the cache without holding the lock */
+    TTY_U32*                   pendingBits;    /* One bit per code point, set from when it is queued until it is added to the cache */
+    TTY_U32*                   failedBits;     /* One bit per code point, set if it couldn't be rendered or added to the cache */
+    TTY_U32                    queueHead;
+    TTY_U32                    queueCount;
+    TTY_U32                    numResults;
+    TTY_U32                    numBusyWorkers;
+    TTY_U32                    numPending;
+    TTY_U32                    maxPending;
+    TTY_U32                    numWorkers;
+    TTY_Bool                   isStopping;
+} TTY_Atlas_Prefetcher;
+
+/* Each shard is an independent atlas cache with its own pages. Code points 
+   are assigned to shards by their hash. Lookups don't take a lock, they are
+   retried if the shard was modified while they were reading it. */
+typedef struct {
+    TTY_U8*                         mem;
+    TTY_Atlas_Cache*                shards;
+    struct TTY_Atlas_Shard_Sync*    syncs;         /* One per shard, each on its own cache line */
+    TTY_U32                         numShards;     /* A power of two */
+    TTY_U32                         pagesPerShard;
+} TTY_Concurrent_Atlas_Cache;
+
 
 /* 
  * Creates a `TTY_Font` using the TTF file specified by `path`.
@@ -263,11 +376,29 @@ typedef struct {
  *     TTY_ERROR_FAILED_TO_READ_FILE - The file contents could not be read.
  *     TTY_ERROR_FILE_IS_NOT_TTF     - The file does not contain a TTF file signature.
  *     TTY_ERROR_FILE_IS_CORRUPTED   - The file content differs from what is expected.
- *     TTY_ERROR_UNSUPPORTED_FEATURE - The file uses an encoding that is not Unicode.
+ *     TTY_ERROR_UNSUPPORTED_FEATURE - The file doesn't have a Unicode cmap subtable of format 4, 12, or 13.
  *     TTY_ERROR_UNKNOWN_INSTRUCTION - The font has hinting and the font program has an instruction that is not yet handled.
  */
 TTY_Error tty_font_init(TTY_Font* font, const char* path);
 
+/*
+ * Creates a `TTY_Font` by memory-mapping the TTF file specified by `path`. 
+ * Pages of the file are loaded lazily and are shared between processes that
+ * map the same file.
+ *
+ * Returns the same errors as `tty_font_init`.
+ */
+TTY_Error tty_font_init_mapped(TTY_Font* font, const char* path);
+
+/*
+ * Creates a `TTY_Font` using TTF data that is already in memory. The data is
+ * not copied, it must remain valid until `tty_font_free` is called, and it is
+ * never written to. Multiple fonts can share the same data.
+ *
+ * Returns the same errors as `tty_font_init`.
+ */
+TTY_Error tty_font_init_from_memory(TTY_Font* font, const void* data, TTY_U32 size);
+
 void tty_font_free(TTY_Font* font);
 
 /*
@@ -300,12 +431,65 @@ void tty_instance_free(TTY_Instance* instance);
  */
 TTY_Error tty_get_glyph_index(TTY_Font* font, TTY_U32 codePoint, TTY_U32* idx);
 
+/*
+ * Equivalent to calling `tty_get_glyph_index` for each of the `count` code 
+ * points, but the cmap subtable is only located once.
+ *
+ * Returns one of the following:
+ *     TTY_ERROR_NONE                - The glyph indices were successfully retrieved.
+ *     TTY_ERROR_UNSUPPORTED_FEATURE - The font's encoding format is not handled yet.
+ */
+TTY_Error tty_get_glyph_indices(TTY_Font* font, const TTY_U32* codePoints, TTY_U32 count, TTY_U32* indices);
+
+/*
+ * Decodes the font's character to glyph mapping so that `tty_get_glyph_index`
+ * becomes a single table lookup instead of a search of the cmap subtable. 
+ * Code points in the BMP are stored in a flat array (128 KiB) and higher code
+ * points are stored in pages that are only allocated if they map to a glyph.
+ *
+ * Returns one of the following:
+ *     TTY_ERROR_NONE          - The map was successfully created.
+ *     TTY_ERROR_OUT_OF_MEMORY - Not enough memory could be allocated for the map.
+ */
+TTY_Error tty_font_init_glyph_index_map(TTY_Font* font);
+
+/*
+ * Enables caching of decoded glyph outlines so that rendering the same glyph
+ * again (at any size, using any instance of the font) doesn't need to parse
+ * the glyf table. Outlines are stored unscaled, and the least recently used 
+ * outlines are freed once they use more than `maxSize` bytes. Composite glyphs
+ * are only cached for instances that don't use hinting since each component
+ * runs its own glyph program.
+ *
+ * Returns one of the following:
+ *     TTY_ERROR_NONE          - The cache was successfully created.
+ *     TTY_ERROR_OUT_OF_MEMORY - Not enough memory could be allocated for the cache.
+ */
+TTY_Error tty_font_init_outline_cache(TTY_Font* font, TTY_U32 maxSize);
+
 /*
  * Returns one of the following:
  *     TTY_ERROR_NONE - The glyph was successfully loaded.
  */
 TTY_Error tty_glyph_init(TTY_Font* font, TTY_Glyph* glyph, TTY_U32 idx);
 
+/*
+ * Equivalent to calling `tty_glyph_init` for each of the `count` glyph indices.
+ *
+ * Returns one of the following:
+ *     TTY_ERROR_NONE - The glyphs were successfully loaded.
+ *     Otherwise, the first error produced by `tty_glyph_init`. The glyphs after the one that failed aren't loaded.
+ */
+TTY_Error tty_glyphs_init(TTY_Font* font, const TTY_U32* indices, TTY_U32 count, TTY_Glyph* glyphs);
+
+/*
+ * Gets the size of the glyph's data in the glyf table, which starts at
+ * `glyph->glyfBlock`. Returns 0 if the glyph has no outline. Glyphs whose data
+ * is byte for byte identical have identical outlines, since composite glyphs
+ * refer to their components by index.
+ */
+TTY_U32 tty_get_glyph_data_size(TTY_Font* font, const TTY_Glyph* glyph);
+
 
 /*
  * Returns one of the following:
@@ -337,24 +521,180 @@ TTY_Error tty_render_glyph(TTY_Font* font, TTY_Instance* instance, TTY_Glyph* gl
 TTY_Error tty_render_glyph_to_existing_image(TTY_Font* font, TTY_Instance* instance, TTY_Glyph* glyph, TTY_Image* image, TTY_U32 x, TTY_U32 y);
 
 /*
+ * Calculates the glyph's advance, offset, and size without rendering it. They
+ * are identical to the values calculated by rendering the glyph. For simple
+ * glyphs in unhinted instances, they come straight from the hmtx table and a
+ * scan of the glyph's coordinates. Otherwise, the glyph's outline has to be 
+ * loaded (and hinted) first.
+ *
+ * Returns one of the following:
+ *    TTY_ERROR_NONE                - The metrics were calculated successfully.
+ *    TTY_ERROR_UNSUPPORTED_FEATURE - The glyph is a composite glyph that uses point matching.
+ *    TTY_ERROR_UNKNOWN_INSTRUCTION - The instance uses hinting and the glyph program has an instruction that is not yet handled.
+ */
+TTY_Error tty_get_glyph_metrics(TTY_Font* font, TTY_Instance* instance, TTY_Glyph* glyph);
+
+/*
+ * Creates a `TTY_Atlas_Cache` with a single `w` x `h` page. Glyphs are packed
+ * into shelves (rows) using their actual size, so small glyphs take up less
+ * space than large ones. When the page is full, a shelf that hasn't been used
+ * recently is cleared and reused.
+ *
  * Returns one of the following:
  *     TTY_ERROR_NONE          - The cache was successfully created.
  *     TTY_ERROR_OUT_OF_MEMORY - Not enough memory could be allocated for the cache.
  */
 TTY_Error tty_atlas_cache_init(TTY_Instance* instance, TTY_Atlas_Cache* cache, TTY_U32 w, TTY_U32 h);
 
+/*
+ * Equivalent to `tty_atlas_cache_init`, except the cache can grow to 
+ * `maxPages` pages of `w` x `h` pixels. A new page is only allocated once the 
+ * existing pages are full, and shelves are only evicted once `maxPages` pages
+ * are full. `TTY_Atlas_Cache_Entry.page` says which page a glyph is in.
+ *
+ * Returns one of the following:
+ *     TTY_ERROR_NONE          - The cache was successfully created.
+ *     TTY_ERROR_OUT_OF_MEMORY - Not enough memory could be allocated for the cache.
+ */
+TTY_Error tty_atlas_cache_init_paged(TTY_Instance* instance, TTY_Atlas_Cache* cache, TTY_U32 w, TTY_U32 h, TTY_U32 maxPages);
+
+/*
+ * Equivalent to `tty_atlas_cache_init_paged`, except the glyphs don't have to
+ * come from an instance. `maxGlyphSize` is the size of the largest area that 
+ * will be reserved with `tty_atlas_cache_reserve_entry`.
+ *
+ * Returns one of the following:
+ *     TTY_ERROR_NONE          - The cache was successfully created.
+ *     TTY_ERROR_OUT_OF_MEMORY - Not enough memory could be allocated for the cache.
+ */
+TTY_Error tty_atlas_cache_init_custom(TTY_Atlas_Cache* cache, TTY_U32_V2 maxGlyphSize, TTY_U32 w, TTY_U32 h, TTY_U32 maxPages);
+
 void tty_atlas_cache_free(TTY_Atlas_Cache* cache);
 
 /*
  * Returns TTY_ERROR_NONE on success. If the entry was not already cached, then
- * this function may return any error produced by `tty_render_glyph_to_existing_image`.
+ * this function may return any error produced by `tty_render_glyph_to_existing_image`
+ * or `tty_get_glyph_metrics`. TTY_ERROR_GLYPH_DOES_NOT_FIT_IN_IMAGE is returned
+ * if the glyph is larger than a page, and TTY_ERROR_OUT_OF_MEMORY is returned
+ * if a new page could not be allocated.
  */
 TTY_Error tty_atlas_cache_get_entry(TTY_Font* font, TTY_Instance* instance, TTY_Atlas_Cache* cache, TTY_Atlas_Cache_Entry* entry, TTY_U32 codePoint);
 
+/* 
+ * Returns TTY_TRUE and fills in `entry` if the code point is cached. Unlike
+ * `tty_atlas_cache_get_entry`, nothing is rendered if it isn't.
+ */
+TTY_Bool tty_atlas_cache_lookup(TTY_Atlas_Cache* cache, TTY_Atlas_Cache_Entry* entry, TTY_U32 codePoint);
+
+/*
+ * Adds an entry for a code point that isn't cached and reserves a `size` area
+ * of a page for it, evicting other glyphs if needed. Nothing is rendered, the 
+ * caller writes the glyph's pixels to `cache->pages[entry->page].image` at 
+ * `entry->atlasPos`. This allows the cache to hold images other than plain 
+ * glyph bitmaps (e.g. distance fields). `entry->glyph` is stored as is.
+ *
+ * Returns one of the following:
+ *     TTY_ERROR_NONE                        - The area was successfully reserved.
+ *     TTY_ERROR_GLYPH_DOES_NOT_FIT_IN_IMAGE - `size` is larger than a page.
+ *     TTY_ERROR_OUT_OF_MEMORY               - A new page could not be allocated.
+ */
+TTY_Error tty_atlas_cache_reserve_entry(TTY_Atlas_Cache* cache, TTY_Atlas_Cache_Entry* entry, TTY_U32 codePoint, TTY_U32_V2 size);
+
 /* Note: This does not update the cache */
 TTY_Bool tty_atlas_cache_contains(TTY_Atlas_Cache* cache, TTY_U32 codePoint);
 
+/* Returns TTY_TRUE if adding a glyph of the maximum size would evict a shelf (or a page) */
 TTY_Bool tty_atlas_cache_is_full(TTY_Atlas_Cache* cache);
 
+/*
+ * Gets the areas of the page that have changed (glyphs that were rendered or
+ * cleared) since `tty_atlas_cache_clear_dirty_rects` was last called, so only
+ * those areas need to be uploaded to a texture. Overlapping and neighbouring 
+ * areas are merged. `*rects` is valid until the cache is next modified.
+ *
+ * Returns the number of rects.
+ */
+TTY_U32 tty_atlas_cache_get_dirty_rects(TTY_Atlas_Cache* cache, TTY_U32 page, const TTY_Rect** rects);
+
+/* Typically called once per frame, after the dirty rects have been uploaded */
+void tty_atlas_cache_clear_dirty_rects(TTY_Atlas_Cache* cache);
+
+/*
+ * Creates a `TTY_Atlas_Prefetcher` that renders glyphs for `cache` on 
+ * `numWorkers` background threads. `font`, `instance`, and `cache` must remain
+ * valid until `tty_atlas_prefetcher_free` is called. The prefetcher and the 
+ * cache must only be used by the thread that created the prefetcher.
+ *
+ * Returns one of the following:
+ *     TTY_ERROR_NONE          - The prefetcher was successfully created.
+ *     TTY_ERROR_OUT_OF_MEMORY - Not enough memory could be allocated, or a thread, mutex, or condition variable could not be created.
+ *     Any error produced by `tty_font_init_from_memory` or `tty_instance_init` when creating the workers' fonts and instances.
+ */
+TTY_Error tty_atlas_prefetcher_init(TTY_Font* font, TTY_Instance* instance, TTY_Atlas_Cache* cache, TTY_Atlas_Prefetcher* prefetcher, TTY_U32 numWorkers);
+
+/* Stops the workers, glyphs that haven't been rendered yet are discarded */
+void tty_atlas_prefetcher_free(TTY_Atlas_Prefetcher* prefetcher);
+
+/*
+ * Queues the code points to be rendered in the background. Code points that
+ * are already cached or pending are skipped, as are code points that don't 
+ * fit in the queue (the queue holds as many glyphs as the cache does).
+ *
+ * Returns the number of code points that were queued.
+ */
+TTY_U32 tty_atlas_prefetch(TTY_Atlas_Prefetcher* prefetcher, const TTY_U32* codePoints, TTY_U32 numCodePoints);
+
+/*
+ * Gets the code point's entry without waiting for it to be rendered. Glyphs 
+ * that the workers have finished are added to the cache first. If the code 
+ * point isn't cached, it is queued. If the queue is full, the glyph is 
+ * rendered on the calling thread instead.
+ *
+ * Returns one of the following:
+ *     TTY_ERROR_NONE          - The entry was cached, or was rendered on the calling thread.
+ *     TTY_ERROR_GLYPH_PENDING - The glyph is queued or being rendered, `tty_atlas_prefetcher_wait` adds it to the cache.
+ *     If the glyph couldn't be rendered in the background or the queue is 
+ *     full, it is rendered on the calling thread and any error produced by 
+ *     `tty_atlas_cache_get_entry` is returned.
+ */
+TTY_Error tty_atlas_prefetcher_try_get_entry(TTY_Atlas_Prefetcher* prefetcher, TTY_Atlas_Cache_Entry* entry, TTY_U32 codePoint);
+
+/* Blocks until every queued glyph has been rendered and added to the cache */
+void tty_atlas_prefetcher_wait(TTY_Atlas_Prefetcher* prefetcher);
+
+/*
+ * Creates a `TTY_Concurrent_Atlas_Cache` that can be used by several threads
+ * at once. `numShards` is rounded up to a power of two, and each shard can 
+ * grow to `pagesPerShard` pages of `w` x `h` pixels. Page `i` of shard `s` is
+ * `shards[s].pages[i]`, and `TTY_Atlas_Cache_Entry.page` is 
+ * `s * pagesPerShard + i` (e.g. a layer of a texture array).
+ *
+ * Returns one of the following:
+ *     TTY_ERROR_NONE          - The cache was successfully created.
+ *     TTY_ERROR_OUT_OF_MEMORY - Not enough memory could be allocated for the cache, or a mutex could not be created.
+ */
+TTY_Error tty_concurrent_atlas_cache_init(TTY_Instance* instance, TTY_Concurrent_Atlas_Cache* cache, TTY_U32 w, TTY_U32 h, TTY_U32 numShards, TTY_U32 pagesPerShard);
+
+void tty_concurrent_atlas_cache_free(TTY_Concurrent_Atlas_Cache* cache);
+
+/*
+ * Equivalent to `tty_atlas_cache_get_entry`, except it can be called by 
+ * several threads at once. Fonts and instances can't be shared between 
+ * threads, so each thread passes its own (e.g. created with 
+ * `tty_font_init_from_memory`) with the same flags and ppem. Cache hits don't 
+ * take a lock or write to shared memory other than a glyph's reference bit.
+ *
+ * Returns the same errors as `tty_atlas_cache_get_entry`.
+ */
+TTY_Error tty_concurrent_atlas_cache_get_entry(TTY_Font* font, TTY_Instance* instance, TTY_Concurrent_Atlas_Cache* cache, TTY_Atlas_Cache_Entry* entry, TTY_U32 codePoint);
+
+/*
+ * Copies up to `maxRects` of the page's dirty rects into `rects` and removes 
+ * them from the page. Rects that don't fit are returned by the next call.
+ *
+ * Returns the number of rects that were copied.
+ */
+TTY_U32 tty_concurrent_atlas_cache_take_dirty_rects(TTY_Concurrent_Atlas_Cache* cache, TTY_U32 page, TTY_Rect* rects, TTY_U32 maxRects);
+
 
 #endif